@@ -0,0 +1,271 @@
+#include <QtTest>
+#include <QElapsedTimer>
+
+#include "../simulation/layoutsimulator.h"
+#include "../input/simulatedspeedsensor.h"
+#include "../commandstation/simulatedcommandstation.h"
+
+#include "../recorder/recordingmanager.h"
+
+static constexpr int LocoAddress = 3;
+
+// Measured mean speed must be this close to model curve
+static constexpr double MaxCurveError = 0.02;
+
+// Readings needed before a step is compared
+static constexpr int MinReadingsPerStep = 5;
+
+// Drain sensor ring, returns mean speed of readings
+static double takeMeanSpeed(ISpeedSensor *sensor, int *countOut = nullptr)
+{
+    constexpr int BatchSize = 256;
+    SpeedSample batch[BatchSize];
+
+    double sum = 0;
+    int total = 0;
+    int count = 0;
+    do
+    {
+        count = sensor->takeReadings(batch, BatchSize);
+        for(int i = 0; i < count; i++)
+        {
+            if(batch[i].metersPerSecond <= 0)
+                continue; // Standstill readings
+            sum += batch[i].metersPerSecond;
+            total++;
+        }
+    }
+    while(count == BatchSize);
+
+    if(countOut)
+        *countOut = total;
+    return total ? sum / total : 0;
+}
+
+class LayoutSimBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void calibrationSweep_data();
+    void calibrationSweep();
+
+    void recordingSweep();
+
+    void emergencyStop();
+    void directionChange();
+    void fastPacing();
+};
+
+void LayoutSimBenchmark::calibrationSweep_data()
+{
+    QTest::addColumn<bool>("reverse");
+
+    QTest::newRow("forward") << false;
+    QTest::newRow("reverse") << true;
+}
+
+void LayoutSimBenchmark::calibrationSweep()
+{
+    // Same procedure as RecordingManager: one step at a time, wait to settle, measure
+    QFETCH(bool, reverse);
+    const LocomotiveDirection direction = reverse ? LocomotiveDirection::Reverse : LocomotiveDirection::Forward;
+
+    LayoutSimulator sim;
+    SimulatedSpeedSensor *sensor = sim.speedSensor();
+    const VirtualLocomotive *loco = sim.locomotive(LocoAddress);
+
+    int feedbackCount = 0;
+    connect(sim.commandStation(), &ICommandStation::locomotiveSpeedFeedback, this,
+            [&feedbackCount](int, int, LocomotiveDirection, bool, qint64) { feedbackCount++; });
+
+    QElapsedTimer timer;
+    timer.start();
+
+    int compared = 0;
+    for(int step = 1; step <= VirtualLocomotive::MaxStep; step++)
+    {
+        sim.commandStation()->setLocomotiveSpeed(LocoAddress, step, direction);
+
+        sim.runFor(2000000);
+        takeMeanSpeed(sensor);
+
+        sim.runFor(1000000);
+        int readings = 0;
+        const double measured = takeMeanSpeed(sensor, &readings);
+
+        if(readings < MinReadingsPerStep)
+            continue; // Too slow for enough edges
+
+        const double expected = loco->curveSpeed(step, direction);
+        QVERIFY2(qAbs(measured - expected) <= expected * MaxCurveError,
+                 qPrintable(QStringLiteral("step %1 measured %2 expected %3")
+                            .arg(step).arg(measured).arg(expected)));
+        compared++;
+    }
+
+    const qint64 wallMillis = timer.elapsed();
+    qInfo().nospace() << "simulated: " << sim.elapsedMicros() / 1000000.0 << " s"
+                      << " wall: " << wallMillis << " ms"
+                      << " steps compared: " << compared;
+
+    QCOMPARE(feedbackCount, VirtualLocomotive::MaxStep);
+    QVERIFY(compared > VirtualLocomotive::MaxStep / 2);
+    QCOMPARE(sensor->overrunCount(), quint64(0));
+}
+
+void LayoutSimBenchmark::recordingSweep()
+{
+    // Real RecordingManager sparse sweep, steps end as soon as speed is steady.
+    // Its timers run on host clock so simulator is paced in real time
+    VirtualLocomotiveConfig config;
+    config.accelerationCV = 0;
+    config.decelerationCV = 0;
+    config.inertiaMillis = 50;
+    config.wheelDiameterMillimeters = 3; // More edges per second at low speed
+
+    LayoutSimulator sim;
+    const VirtualLocomotive *loco = sim.addLocomotive(LocoAddress, config);
+
+    RecordingManager manager;
+    manager.setCommandStation(sim.commandStation());
+    manager.setSpeedSensor(sim.speedSensor());
+    manager.setLocomotiveDCCAddress(LocoAddress);
+    manager.setStartingDCCStep(8);
+    manager.setSparseSweep(true);
+    manager.setAdaptiveStepTime(true);
+    manager.setMaxStepTimeMillis(5000);
+    manager.setMinStepTimeMillis(300);
+    manager.sweepPlanner()->setCoarseStride(24);
+    manager.sweepPlanner()->setMaxMeasurements(12);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    sim.start();
+    QVERIFY(manager.start());
+
+    QTRY_VERIFY_WITH_TIMEOUT(manager.state() == RecordingManager::State::Stopped, 90000);
+    sim.stop();
+
+    const QMap<int, double>& measured = manager.sweepPlanner()->measurements();
+    qInfo().nospace() << "wall: " << timer.elapsed() << " ms"
+                      << " steps measured: " << measured.size()
+                      << " requested: " << manager.sweepPlanner()->requestedCount();
+
+    // Planner always measures first and last step
+    QVERIFY(measured.contains(8));
+    QVERIFY(measured.contains(VirtualLocomotive::MaxStep));
+
+    for(auto it = measured.cbegin(); it != measured.cend(); ++it)
+    {
+        const double expected = loco->curveSpeed(it.key(), LocomotiveDirection::Forward);
+        QVERIFY2(qAbs(it.value() - expected) <= expected * MaxCurveError * 2,
+                 qPrintable(QStringLiteral("step %1 measured %2 expected %3")
+                            .arg(it.key()).arg(it.value()).arg(expected)));
+    }
+
+    QCOMPARE(manager.lostSensorReadings(), quint64(0));
+}
+
+void LayoutSimBenchmark::emergencyStop()
+{
+    LayoutSimulator sim;
+    const VirtualLocomotive *loco = sim.locomotive(LocoAddress);
+
+    int lastFeedbackStep = 0;
+    connect(sim.commandStation(), &ICommandStation::locomotiveSpeedFeedback, this,
+            [&lastFeedbackStep](int, int speedStep, LocomotiveDirection, bool, qint64) { lastFeedbackStep = speedStep; });
+
+    sim.commandStation()->setLocomotiveSpeed(LocoAddress, VirtualLocomotive::MaxStep, LocomotiveDirection::Forward);
+    sim.runFor(15000000);
+
+    const double speed = loco->metersPerSecond();
+    QVERIFY(qAbs(speed - loco->curveSpeed(VirtualLocomotive::MaxStep, LocomotiveDirection::Forward)) < 0.001);
+
+    sim.commandStation()->emergencyStop(LocoAddress);
+    const double before = loco->wheelMillimeters();
+    sim.runFor(3000000);
+
+    QCOMPARE(lastFeedbackStep, EMERGENCY_STOP);
+    QCOMPARE(loco->decoderStep(), 0);
+    QCOMPARE(loco->metersPerSecond(), 0.0);
+
+    // Only flywheel coasting: latency at full speed plus v * inertia time constant
+    const double latencyMillimeters = speed * sim.commandLatencyMicros() / 1000.0;
+    const double coastMillimeters = speed * loco->config().inertiaMillis;
+    const double stopDistance = loco->wheelMillimeters() - before;
+    qInfo() << "stop distance mm:" << stopDistance;
+    QVERIFY(stopDistance <= (latencyMillimeters + coastMillimeters) * 1.05);
+}
+
+void LayoutSimBenchmark::directionChange()
+{
+    LayoutSimulator sim;
+    const VirtualLocomotive *loco = sim.locomotive(LocoAddress);
+
+    sim.commandStation()->setLocomotiveSpeed(LocoAddress, 60, LocomotiveDirection::Forward);
+    sim.runFor(10000000);
+    QCOMPARE(loco->decoderStep(), 60);
+
+    // Decoder slows down to zero before reversing
+    sim.commandStation()->setLocomotiveSpeed(LocoAddress, 60, LocomotiveDirection::Reverse);
+    bool passedZero = false;
+    for(int i = 0; i < 200; i++)
+    {
+        sim.runFor(50000);
+        QVERIFY(loco->decoderStep() <= 60);
+        if(loco->decoderStep() == 0)
+            passedZero = true;
+    }
+
+    QVERIFY(passedZero);
+    QCOMPARE(loco->decoderStep(), -60);
+    QVERIFY(qAbs(loco->metersPerSecond() + loco->curveSpeed(60, LocomotiveDirection::Reverse)) < 0.001);
+}
+
+void LayoutSimBenchmark::fastPacing()
+{
+    // Driven by event loop like in application, but not paced to wall clock
+    LayoutSimulator sim;
+    const VirtualLocomotive *loco = sim.locomotive(LocoAddress);
+    sim.setPacing(LayoutSimulator::Pacing::AsFastAsPossible);
+    sim.commandStation()->setLocomotiveSpeed(LocoAddress, 100, LocomotiveDirection::Forward);
+
+    QElapsedTimer timer;
+    timer.start();
+    sim.start();
+
+    // Ten simulated minutes, drain sensor ring like RecordingManager does
+    // otherwise most readings would be dropped
+    int readings = 0;
+    while(sim.elapsedMicros() < 600000000LL && timer.elapsed() < 30000)
+    {
+        QCoreApplication::processEvents();
+
+        int count = 0;
+        takeMeanSpeed(sim.speedSensor(), &count);
+        readings += count;
+    }
+    sim.stop();
+
+    int count = 0;
+    takeMeanSpeed(sim.speedSensor(), &count);
+    readings += count;
+
+    qInfo().nospace() << "simulated: " << sim.elapsedMicros() / 1000000.0 << " s"
+                      << " wall: " << timer.elapsed() << " ms"
+                      << " readings: " << readings;
+
+    QVERIFY(sim.elapsedMicros() >= 600000000LL);
+    QCOMPARE(sim.speedSensor()->overrunCount(), quint64(0));
+
+    // One reading each half rotation, first edge only starts measuring
+    const int halfRotations = int(loco->wheelMillimeters() / loco->millimetersPerHalfRotation());
+    QVERIFY2(qAbs(readings - (halfRotations - 1)) <= 1,
+             qPrintable(QStringLiteral("readings %1 half rotations %2").arg(readings).arg(halfRotations)));
+}
+
+QTEST_GUILESS_MAIN(LayoutSimBenchmark)
+
+#include "layoutsimbenchmark.moc"
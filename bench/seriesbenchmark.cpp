@@ -0,0 +1,283 @@
+#include <QtTest>
+#include <QRandomGenerator>
+#include <QElapsedTimer>
+
+#include "../recorder/series/requestedspeedstepseries.h"
+#include "../recorder/series/receivedspeedstepseries.h"
+#include "../recorder/series/rawsensordataseries.h"
+#include "../recorder/series/sensortravelleddistanceseries.h"
+#include "../recorder/series/movingaverageseries.h"
+#include "../recorder/series/totalstepaverageseries.h"
+#include "../recorder/series/dataseriescurvemapping.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Heap allocation counter for whole process
+static std::atomic<qint64> gAllocationCount{0};
+
+static inline void countAllocation()
+{
+    gAllocationCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+#if defined(__GLIBC__)
+// Qt containers call malloc directly, so count at that level
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t n, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size)
+{
+    countAllocation();
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    countAllocation();
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    countAllocation();
+    return __libc_realloc(ptr, size);
+}
+}
+#else
+// Only C++ allocations can be counted portably
+void *operator new(std::size_t size)
+{
+    countAllocation();
+    if(void *ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+#endif
+
+// Same rate as sensor readings
+static constexpr double SampleSeconds = 0.1;
+
+// Hot path must not allocate for each sample,
+// storage growth and step bookkeeping are allowed
+static constexpr double MaxAllocationsPerSample = 0.02;
+static constexpr qint64 FixedAllocations = 2000;
+
+// Synthetic run modelled on DummySpeedSensor::generateRandomSpeedCurve()
+// Fixed seed so every run gets same data
+struct SyntheticRun
+{
+    QVector<double> speed;
+    QVector<double> travelled;
+    int samplesPerStep = 1;
+
+    static SyntheticRun generate(int samples)
+    {
+        QRandomGenerator rng(1234);
+
+        double speedCurve[127];
+        speedCurve[0] = 0;
+        const double MAX_INCREMENT = 0.3;
+        for(int i = 1; i < 127; i++)
+            speedCurve[i] = speedCurve[i - 1] + rng.bounded(MAX_INCREMENT);
+
+        SyntheticRun run;
+        run.samplesPerStep = qMax(1, samples / 126);
+        run.speed.reserve(samples);
+        run.travelled.reserve(samples);
+
+        const double MAX_OSCILLATION = 0.2;
+        double travelledMillimeters = 0;
+        for(int i = 0; i < samples; i++)
+        {
+            const int step = qMin(126, i / run.samplesPerStep + 1);
+            const double speed = speedCurve[step] + rng.bounded(MAX_OSCILLATION) - MAX_OSCILLATION / 2;
+            travelledMillimeters += speed * SampleSeconds * 1000.0;
+
+            run.speed.append(speed);
+            run.travelled.append(travelledMillimeters);
+        }
+
+        return run;
+    }
+};
+
+// RawSensorDataSeries -> MovingAverageSeries -> DataSeriesCurveMapping
+// SensorTravelledDistanceSeries -> TotalStepAverageSeries -> DataSeriesCurveMapping
+struct Pipeline
+{
+    RequestedSpeedStepSeries reqStep;
+    ReceivedSpeedStepSeries recvStep;
+    RawSensorDataSeries raw;
+    SensorTravelledDistanceSeries travelled;
+
+    MovingAverageSeries avg{5, MovingAverageSeries::Alignment::Trailing};
+    DataSeriesCurveMapping avgMapping;
+
+    TotalStepAverageSeries total;
+    DataSeriesCurveMapping totalMapping;
+
+    void connectDerived()
+    {
+        avg.setSource(&raw);
+        avgMapping.setRecvStep(&recvStep);
+        avgMapping.setSource(&avg);
+
+        total.setAccelerationMilliseconds(1000);
+        total.setTravelledSource(&travelled);
+        total.setRecvStepSeries(&recvStep);
+        total.setReqStepSeries(&reqStep);
+        totalMapping.setRecvStep(&recvStep);
+        totalMapping.setSource(&total);
+    }
+
+    void feed(const SyntheticRun& run)
+    {
+        int step = 0;
+        for(int i = 0; i < run.speed.size(); i++)
+        {
+            const double seconds = i * SampleSeconds;
+
+            if(i % run.samplesPerStep == 0 && step < 126)
+            {
+                // Command station replies immediately
+                reqStep.addPoint(step, seconds);
+                reqStep.addPoint(step + 1, seconds);
+                recvStep.addPoint(step, seconds);
+                recvStep.addPoint(step + 1, seconds);
+                step++;
+            }
+
+            raw.addPoint(run.speed.at(i), seconds);
+            travelled.addPoint(run.travelled.at(i), seconds);
+        }
+
+        // Stop
+        const double seconds = run.speed.size() * SampleSeconds;
+        reqStep.addPoint(step, seconds);
+        reqStep.addPoint(0, seconds);
+        recvStep.addPoint(step, seconds);
+        recvStep.addPoint(0, seconds);
+    }
+};
+
+class SeriesBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void livePipeline_data();
+    void livePipeline();
+
+    void offlineRecalculate_data();
+    void offlineRecalculate();
+
+private:
+    void addSampleRows();
+    void checkSinglePass(const SyntheticRun& run, bool live);
+};
+
+void SeriesBenchmark::addSampleRows()
+{
+    QTest::addColumn<int>("samples");
+
+    QTest::newRow("1k") << 1000;
+    QTest::newRow("100k") << 100000;
+    QTest::newRow("1M") << 1000000;
+}
+
+void SeriesBenchmark::checkSinglePass(const SyntheticRun &run, bool live)
+{
+    const int samples = run.speed.size();
+
+    Pipeline p;
+    if(live)
+        p.connectDerived();
+
+    const qint64 allocBefore = gAllocationCount.load(std::memory_order_relaxed);
+    QElapsedTimer timer;
+    timer.start();
+
+    if(live)
+    {
+        p.feed(run);
+    }
+    else
+    {
+        p.feed(run);
+        p.connectDerived();
+    }
+
+    const qint64 nsecs = timer.nsecsElapsed();
+    const qint64 allocations = gAllocationCount.load(std::memory_order_relaxed) - allocBefore;
+
+    qInfo().nospace() << "samples: " << samples
+                      << " ns/sample: " << double(nsecs) / samples
+                      << " allocations: " << allocations
+                      << " allocations/sample: " << double(allocations) / samples;
+
+    QVERIFY(p.totalMapping.getPointCount() > 0);
+    QCOMPARE(p.avgMapping.getPointCount(), samples);
+
+    QVERIFY2(allocations <= qint64(MaxAllocationsPerSample * samples) + FixedAllocations,
+             "Too many allocations in analysis hot path");
+}
+
+void SeriesBenchmark::livePipeline_data()
+{
+    addSampleRows();
+}
+
+void SeriesBenchmark::livePipeline()
+{
+    // Derived series connected first, notified for each sample like while recording
+    QFETCH(int, samples);
+    const SyntheticRun run = SyntheticRun::generate(samples);
+
+    checkSinglePass(run, true);
+
+    QBENCHMARK
+    {
+        Pipeline p;
+        p.connectDerived();
+        p.feed(run);
+    }
+}
+
+void SeriesBenchmark::offlineRecalculate_data()
+{
+    addSampleRows();
+}
+
+void SeriesBenchmark::offlineRecalculate()
+{
+    // Derived series connected after all data, like replay and batch analysis
+    QFETCH(int, samples);
+    const SyntheticRun run = SyntheticRun::generate(samples);
+
+    checkSinglePass(run, false);
+
+    QBENCHMARK
+    {
+        Pipeline p;
+        p.feed(run);
+        p.connectDerived();
+    }
+}
+
+QTEST_GUILESS_MAIN(SeriesBenchmark)
+
+#include "seriesbenchmark.moc"
@@ -0,0 +1,309 @@
+#include "batchanalysisjob.h"
+
+#include "../recorder/capturereader.h"
+#include "../recorder/speedcurvefile.h"
+
+#include "../recorder/series/capturedseries.h"
+#include "../recorder/series/totalstepaverageseries.h"
+#include "../recorder/series/dataseriescurvemapping.h"
+
+#include "../commandstation/utils.h"
+
+#include <QAtomicInt>
+#include <QFileInfo>
+#include <QDir>
+
+#include <QDebug>
+
+#include <memory>
+#include <utility>
+
+// Reverse steps are recorded as negative steps
+static QVector<double> curveFromMapping(IDataSeries *mapping, BatchAnalysisConfig::StepValue stepValue,
+                                        LocomotiveDirection direction, int &missingSteps)
+{
+    constexpr int CurveSize = SpeedCurveFile::CurveSize;
+
+    QVector<double> values(CurveSize, 0);
+    QVector<int> counts(CurveSize, 0);
+
+    const int pointCount = mapping->getPointCount();
+    int idx = 0;
+    while(idx < pointCount)
+    {
+        const DataSeriesSpan span = mapping->getSpan(idx, pointCount - idx);
+        if(!span.count)
+            break;
+
+        for(int i = 0; i < span.count; i++)
+        {
+            int step = int(span.x[i]);
+            if(direction == LocomotiveDirection::Reverse)
+                step = -step;
+            if(step < 0 || step >= CurveSize)
+                continue;
+
+            switch (stepValue)
+            {
+            case BatchAnalysisConfig::StepValue::First:
+                if(counts[step] == 0)
+                    values[step] = span.y[i];
+                break;
+            case BatchAnalysisConfig::StepValue::Last:
+                values[step] = span.y[i];
+                break;
+            case BatchAnalysisConfig::StepValue::Mean:
+                values[step] += span.y[i];
+                break;
+            }
+
+            counts[step]++;
+        }
+
+        idx += span.count;
+    }
+
+    if(stepValue == BatchAnalysisConfig::StepValue::Mean)
+    {
+        for(int step = 0; step < CurveSize; step++)
+        {
+            if(counts[step])
+                values[step] /= counts[step];
+        }
+    }
+
+    // Step 0 is always stopped
+    values[0] = 0;
+    counts[0] = 1;
+
+    // Fill steps without data, like sparse "speed_mapping" files
+    missingSteps = 0;
+    int lastStep = 0;
+    for(int step = 1; step < CurveSize; step++)
+    {
+        if(!counts[step])
+        {
+            missingSteps++;
+            continue;
+        }
+
+        if(step > lastStep + 1)
+        {
+            // Linear interpolation of steps inbetween
+            const int numSteps = step - lastStep;
+            const double increment = (values[step] - values[lastStep]) / double(numSteps);
+            for(int i = 1; i < numSteps; i++)
+                values[lastStep + i] = values[lastStep] + increment * double(i);
+        }
+
+        lastStep = step;
+    }
+
+    // Last recorded speed for steps after end of run
+    for(int step = lastStep + 1; step < CurveSize; step++)
+        values[step] = values[lastStep];
+
+    return values;
+}
+
+// Speed and travelled distance at each half rotation found in waveform
+static bool detectEdges(const CaptureReader& reader, const BatchAnalysisConfig& config,
+                        QVector<double>& time, QVector<double>& speed, QVector<double>& travelled)
+{
+    const QVector<CaptureReader::Chunk> chunks = reader.chunks(CaptureFile::HallWaveform);
+    if(chunks.isEmpty())
+        return false;
+
+    HallEdgeDetector detector;
+    detector.setThresholds(config.edgeThresholds);
+
+    QVector<quint16> samples;
+    QVector<double> micros;
+    QVector<HallEdgeDetector::Edge> edges;
+
+    for(const CaptureReader::Chunk& chunk : chunks)
+    {
+        samples.resize(chunk.count);
+        micros.resize(chunk.count);
+
+        const double *t = chunk.column(0);
+        const double *v = chunk.column(1);
+        for(int i = 0; i < chunk.count; i++)
+        {
+            samples[i] = quint16(qBound(0.0, v[i], 65535.0));
+            micros[i] = t[i] * 1000000.0;
+        }
+
+        detector.process(samples.constData(), micros.constData(), chunk.count, edges);
+    }
+
+    const double mmPerHalf = config.millimetersPerHalfRotation;
+    double distance = 0;
+    for(int i = 1; i < edges.size(); i++)
+    {
+        const double dt = edges.at(i).micros - edges.at(i - 1).micros;
+        if(dt <= 0)
+            continue;
+
+        distance += mmPerHalf;
+        time.append(edges.at(i).micros / 1000000.0);
+        speed.append(mmPerHalf / dt * 1000.0); // mm/us to m/s
+        travelled.append(distance);
+    }
+
+    return true;
+}
+
+BatchAnalysisJob::BatchAnalysisJob(const QString &fileName, const BatchAnalysisConfig &config,
+                                   QAtomicInt *failedCount)
+    : mFileName(fileName)
+    , mConfig(config)
+    , mFailedCount(failedCount)
+{
+
+}
+
+void BatchAnalysisJob::run()
+{
+    QString errMsg;
+    if(!analyze(errMsg))
+    {
+        qWarning().noquote() << mFileName << "FAILED:" << errMsg;
+        mFailedCount->fetchAndAddRelaxed(1);
+        return;
+    }
+
+    qInfo().noquote() << mFileName << "done";
+}
+
+bool BatchAnalysisJob::analyze(QString &errOut)
+{
+    CaptureReader reader;
+    if(!reader.open(mFileName))
+    {
+        errOut = reader.errorString();
+        return false;
+    }
+
+    if(reader.isRecovered())
+        qWarning().noquote() << mFileName << "was not closed properly, using recovered chunks";
+
+    // Must outlive series using them
+    QVector<double> edgeTime, edgeSpeed, edgeTravelled;
+
+    // Created without parent, must be deleted before reader
+    std::unique_ptr<CapturedSeries> rawSpeed;
+    std::unique_ptr<CapturedSeries> travelled;
+
+    if(mConfig.redetectEdges)
+    {
+        if(!detectEdges(reader, mConfig, edgeTime, edgeSpeed, edgeTravelled))
+        {
+            errOut = QLatin1String("No waveform recorded");
+            return false;
+        }
+
+        qInfo().noquote() << mFileName << ":" << edgeTime.size() << "half rotations detected";
+
+        rawSpeed.reset(new CapturedSeries(DataSeriesType::SensorRawData));
+        rawSpeed->addChunk(edgeTime.constData(), edgeSpeed.constData(), edgeTime.size());
+        travelled.reset(new CapturedSeries(DataSeriesType::TravelledDistance));
+        travelled->addChunk(edgeTime.constData(), edgeTravelled.constData(), edgeTime.size());
+    }
+    else
+    {
+        rawSpeed.reset(reader.createSeries(CaptureFile::RawSpeed, 1));
+        travelled.reset(reader.createSeries(CaptureFile::TravelledDistance, 1));
+    }
+
+    std::unique_ptr<CapturedSeries> reqStep(reader.createSeries(CaptureFile::RequestedStep, 1));
+    std::unique_ptr<CapturedSeries> recvStep(reader.createSeries(CaptureFile::ReceivedStep, 1));
+
+    if(recvStep->getPointCount() == 0)
+    {
+        errOut = QLatin1String("No received steps");
+        return false;
+    }
+
+    if(mConfig.rawData)
+    {
+        if(!saveCurve(rawSpeed.get(), recvStep.get(), QLatin1String("raw"),
+                      QLatin1String("Raw"), errOut))
+            return false;
+    }
+
+    for(const BatchAnalysisConfig::MovingAverage& avg : mConfig.movingAverages)
+    {
+        MovingAverageSeries s(avg.windowSize, avg.alignment);
+        s.setSource(rawSpeed.get());
+
+        const bool trailing = avg.alignment == MovingAverageSeries::Alignment::Trailing;
+        QString suffix = QLatin1String("avg") + QString::number(avg.windowSize);
+        QString description = QLatin1String("Moving Average ") + QString::number(avg.windowSize);
+        if(trailing)
+        {
+            suffix += QLatin1String("t");
+            description += QLatin1String(" trailing");
+        }
+
+        if(!saveCurve(&s, recvStep.get(), suffix, description, errOut))
+            return false;
+    }
+
+    for(qint64 accelMillis : std::as_const(mConfig.totalAverageAccelMillis))
+    {
+        TotalStepAverageSeries s;
+        s.setAccelerationMilliseconds(accelMillis);
+        s.setTravelledSource(travelled.get());
+        s.setRecvStepSeries(recvStep.get());
+        s.setReqStepSeries(reqStep.get());
+
+        const QString suffix = QLatin1String("total") + QString::number(accelMillis);
+        const QString description = QLatin1String("Total Average %1 ms").arg(QString::number(accelMillis));
+
+        if(!saveCurve(&s, recvStep.get(), suffix, description, errOut))
+            return false;
+    }
+
+    return true;
+}
+
+bool BatchAnalysisJob::saveCurve(IDataSeries *s, IDataSeries *recvStep,
+                                 const QString &suffix, const QString &description,
+                                 QString &errOut)
+{
+    DataSeriesCurveMapping mapping;
+    mapping.setRecvStep(recvStep);
+    mapping.setSource(s);
+
+    int missingSteps = 0;
+    const QVector<double> curve = curveFromMapping(&mapping, mConfig.stepValue,
+                                                   LocomotiveDirection::Forward, missingSteps);
+
+    // Only for bidirectional recordings
+    int reverseMissingSteps = 0;
+    QVector<double> reverseCurve = curveFromMapping(&mapping, mConfig.stepValue,
+                                                    LocomotiveDirection::Reverse, reverseMissingSteps);
+    if(reverseMissingSteps >= SpeedCurveFile::CurveSize - 1)
+        reverseCurve.clear();
+
+    QFileInfo info(mFileName);
+    const QString baseName = info.completeBaseName();
+    const QString outFile = QDir(mConfig.outputDir).filePath(baseName + QLatin1String("_")
+                                                             + suffix + QLatin1String(".json"));
+
+    if(missingSteps > 0)
+    {
+        qWarning().noquote() << outFile << ":" << missingSteps
+                             << "steps without data were interpolated";
+    }
+
+    if(!SpeedCurveFile::saveCurveArray(outFile, baseName + QLatin1String(" ") + description,
+                                       curve, reverseCurve))
+    {
+        errOut = QLatin1String("Cannot write ") + outFile;
+        return false;
+    }
+
+    return true;
+}
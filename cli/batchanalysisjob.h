@@ -0,0 +1,65 @@
+#ifndef BATCHANALYSISJOB_H
+#define BATCHANALYSISJOB_H
+
+#include <QRunnable>
+#include <QString>
+#include <QVector>
+
+#include "../recorder/series/movingaverageseries.h"
+#include "../input/halledgedetector.h"
+
+class QAtomicInt;
+
+struct BatchAnalysisConfig
+{
+    // Which mapped value becomes the step speed
+    enum class StepValue
+    {
+        First = 0, // Same as "Store First of Each Step" in speed curve table
+        Last,
+        Mean
+    };
+
+    struct MovingAverage
+    {
+        int windowSize;
+        MovingAverageSeries::Alignment alignment;
+    };
+
+    QVector<MovingAverage> movingAverages;
+    QVector<qint64> totalAverageAccelMillis;
+    bool rawData = false;
+
+    StepValue stepValue = StepValue::First;
+    QString outputDir;
+
+    // Replace recorded speed with one detected again on recorded waveform
+    bool redetectEdges = false;
+    HallEdgeDetector::Thresholds edgeThresholds;
+    double millimetersPerHalfRotation = 0;
+};
+
+// Analyzes one capture file and writes a speed curve for each
+// configured derived series. Series live only in worker thread
+class BatchAnalysisJob : public QRunnable
+{
+public:
+    BatchAnalysisJob(const QString& fileName, const BatchAnalysisConfig& config,
+                     QAtomicInt *failedCount);
+
+    void run() override;
+
+private:
+    bool analyze(QString &errOut);
+
+    bool saveCurve(IDataSeries *s, IDataSeries *recvStep,
+                   const QString& suffix, const QString& description,
+                   QString &errOut);
+
+private:
+    QString mFileName;
+    BatchAnalysisConfig mConfig;
+    QAtomicInt *mFailedCount;
+};
+
+#endif // BATCHANALYSISJOB_H
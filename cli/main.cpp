@@ -0,0 +1,212 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <QFileInfo>
+#include <QDir>
+
+#include <QDebug>
+
+#include "batchanalysisjob.h"
+
+// Parse "5" or "5:trailing"
+static bool parseMovingAverage(const QString& str, BatchAnalysisConfig::MovingAverage& avg)
+{
+    const QStringList parts = str.split(QLatin1String(":"));
+
+    bool ok = false;
+    avg.windowSize = parts.first().toInt(&ok);
+    if(!ok || avg.windowSize < 1)
+        return false;
+
+    avg.alignment = MovingAverageSeries::Alignment::Centered;
+    if(parts.size() == 2 && parts.at(1) == QLatin1String("trailing"))
+        avg.alignment = MovingAverageSeries::Alignment::Trailing;
+    else if(parts.size() != 1)
+        return false;
+
+    return true;
+}
+
+// Parse "highEnter:highExit:lowEnter:lowExit:mmPerHalfRotation"
+static bool parseEdges(const QString& str, BatchAnalysisConfig& config)
+{
+    const QStringList parts = str.split(QLatin1String(":"));
+    if(parts.size() != 5)
+        return false;
+
+    int values[4];
+    for(int i = 0; i < 4; i++)
+    {
+        bool ok = false;
+        values[i] = parts.at(i).toInt(&ok);
+        if(!ok || values[i] < 0)
+            return false;
+    }
+
+    bool ok = false;
+    config.millimetersPerHalfRotation = parts.at(4).toDouble(&ok);
+    if(!ok || config.millimetersPerHalfRotation <= 0)
+        return false;
+
+    config.edgeThresholds.highEnter = values[0];
+    config.edgeThresholds.highExit = values[1];
+    config.edgeThresholds.lowEnter = values[2];
+    config.edgeThresholds.lowExit = values[3];
+    config.redetectEdges = true;
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QLatin1String("msr-analyze"));
+    QCoreApplication::setApplicationVersion(QLatin1String("0.1"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QLatin1String("Generate speed curves from recorded run captures"));
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument(QLatin1String("inputs"),
+                                 QLatin1String("Capture files or directories of *.msrcap files"),
+                                 QLatin1String("inputs..."));
+
+    QCommandLineOption outputOpt({QLatin1String("o"), QLatin1String("output")},
+                                 QLatin1String("Output directory, default is current one"),
+                                 QLatin1String("dir"), QLatin1String("."));
+    QCommandLineOption avgOpt(QLatin1String("avg"),
+                              QLatin1String("Add moving average of raw speed, can be repeated"),
+                              QLatin1String("window[:trailing]"));
+    QCommandLineOption totalOpt(QLatin1String("total"),
+                                QLatin1String("Add total step average with acceleration offset, can be repeated"),
+                                QLatin1String("millis"));
+    QCommandLineOption rawOpt(QLatin1String("raw"),
+                              QLatin1String("Add curve of raw speed readings"));
+    QCommandLineOption pickOpt(QLatin1String("pick"),
+                               QLatin1String("Value used for each step: first, last or mean"),
+                               QLatin1String("mode"), QLatin1String("first"));
+    QCommandLineOption jobsOpt({QLatin1String("j"), QLatin1String("jobs")},
+                               QLatin1String("Number of parallel jobs, default is one per core"),
+                               QLatin1String("n"));
+
+    QCommandLineOption edgesOpt(QLatin1String("edges"),
+                                QLatin1String("Detect half rotations again on recorded waveform with these thresholds"),
+                                QLatin1String("hiEnter:hiExit:loEnter:loExit:mmPerHalfRotation"));
+
+    parser.addOption(outputOpt);
+    parser.addOption(avgOpt);
+    parser.addOption(totalOpt);
+    parser.addOption(rawOpt);
+    parser.addOption(pickOpt);
+    parser.addOption(jobsOpt);
+    parser.addOption(edgesOpt);
+
+    parser.process(app);
+
+    BatchAnalysisConfig config;
+    config.outputDir = parser.value(outputOpt);
+    config.rawData = parser.isSet(rawOpt);
+
+    const QStringList avgList = parser.values(avgOpt);
+    for(const QString& str : avgList)
+    {
+        BatchAnalysisConfig::MovingAverage avg;
+        if(!parseMovingAverage(str, avg))
+        {
+            qCritical().noquote() << "Invalid moving average:" << str;
+            return 1;
+        }
+        config.movingAverages.append(avg);
+    }
+
+    const QStringList totalList = parser.values(totalOpt);
+    for(const QString& str : totalList)
+    {
+        bool ok = false;
+        qint64 millis = str.toLongLong(&ok);
+        if(!ok || millis < 0)
+        {
+            qCritical().noquote() << "Invalid acceleration millis:" << str;
+            return 1;
+        }
+        config.totalAverageAccelMillis.append(millis);
+    }
+
+    if(config.movingAverages.isEmpty() && config.totalAverageAccelMillis.isEmpty() && !config.rawData)
+    {
+        // Same default as GUI
+        config.totalAverageAccelMillis.append(1000);
+    }
+
+    if(parser.isSet(edgesOpt) && !parseEdges(parser.value(edgesOpt), config))
+    {
+        qCritical().noquote() << "Invalid edge detection parameters:" << parser.value(edgesOpt);
+        return 1;
+    }
+
+    const QString pick = parser.value(pickOpt);
+    if(pick == QLatin1String("first"))
+        config.stepValue = BatchAnalysisConfig::StepValue::First;
+    else if(pick == QLatin1String("last"))
+        config.stepValue = BatchAnalysisConfig::StepValue::Last;
+    else if(pick == QLatin1String("mean"))
+        config.stepValue = BatchAnalysisConfig::StepValue::Mean;
+    else
+    {
+        qCritical().noquote() << "Invalid pick mode:" << pick;
+        return 1;
+    }
+
+    if(!QDir().mkpath(config.outputDir))
+    {
+        qCritical().noquote() << "Cannot create output directory:" << config.outputDir;
+        return 1;
+    }
+
+    QStringList files;
+    const QStringList inputs = parser.positionalArguments();
+    for(const QString& input : inputs)
+    {
+        QFileInfo info(input);
+        if(info.isDir())
+        {
+            QDir dir(input);
+            const QStringList entries = dir.entryList({QLatin1String("*.msrcap")}, QDir::Files, QDir::Name);
+            for(const QString& entry : entries)
+                files.append(dir.filePath(entry));
+        }
+        else
+        {
+            files.append(input);
+        }
+    }
+
+    if(files.isEmpty())
+    {
+        parser.showHelp(1);
+    }
+
+    QThreadPool *pool = QThreadPool::globalInstance();
+    if(parser.isSet(jobsOpt))
+    {
+        const int jobs = parser.value(jobsOpt).toInt();
+        if(jobs > 0)
+            pool->setMaxThreadCount(jobs);
+    }
+
+    // Each run is independent, analyze one per thread
+    QAtomicInt failedCount;
+    for(const QString& fileName : std::as_const(files))
+        pool->start(new BatchAnalysisJob(fileName, config, &failedCount));
+
+    pool->waitForDone();
+
+    const int failed = failedCount.loadRelaxed();
+    if(failed > 0)
+    {
+        qCritical().noquote() << failed << "of" << files.size() << "runs failed";
+        return 1;
+    }
+
+    return 0;
+}
@@ -22,13 +22,14 @@
 
 #include "z21commandstation.h"
 
-#include <QUdpSocket>
-
-#include <QElapsedTimer>
 #include <QtEndian>
+#include <QTimerEvent>
 
 #include "z21messages.h"
 
+#include "../../utils/threadutils.h"
+#include "../../utils/monotonicclock.h"
+
 #include <QDebug>
 
 #include <QTimer>
@@ -36,24 +37,21 @@
 Z21CommandStation::Z21CommandStation(QObject *parent)
     : ICommandStation{parent}
 {
-    mSocket = new QUdpSocket(this);
-    mSocket->bind(QHostAddress("192.168.1.196"), 21105);
-    //mSocket->bind(QHostAddress::LocalHost, 21105);
-    connect(mSocket, &QUdpSocket::readyRead, this, &Z21CommandStation::readPendingDatagram);
-    QTimer *t = new QTimer(this);
-    connect(t, &QTimer::timeout, this, &Z21CommandStation::readPendingDatagram);
-    t->start(500);
+    mSocket = new Z21DatagramSocket(this);
+    connect(mSocket, &Z21DatagramSocket::datagramsReceived, this,
+            &Z21CommandStation::onDatagramsReceived, Qt::DirectConnection);
 
     QTimer *keepAlive = new QTimer(this);
     connect(keepAlive, &QTimer::timeout, this,
             [this]()
     {
         send(Z21::LanSetBroadcastFlags(Z21::BroadcastFlags::AllLocoChanges));
+#ifdef MSR_TRACE_Z21_LATENCY
+        logLatencyStats();
+#endif
     });
     keepAlive->start(10000);
 
-    send(Z21::LanSetBroadcastFlags(Z21::BroadcastFlags::AllLocoChanges));
-
     QTimer *locoInfo = new QTimer(this);
     connect(locoInfo, &QTimer::timeout, this,
             [this]()
@@ -64,15 +62,27 @@ Z21CommandStation::Z21CommandStation(QObject *parent)
     //locoInfo->start(1000);
 }
 
+bool Z21CommandStation::bind(const QHostAddress &address, quint16 port)
+{
+    if(!mSocket->bind(address, port))
+        return false;
+
+    send(Z21::LanSetBroadcastFlags(Z21::BroadcastFlags::AllLocoChanges));
+    return true;
+}
+
+void Z21CommandStation::setStationAddress(const QHostAddress &address, quint16 port)
+{
+    mStationAddress = address;
+    mStationPort = port;
+}
+
 bool Z21CommandStation::setLocomotiveSpeed(int address, int speedStep, LocomotiveDirection direction)
 {
-    ReplyQueueItem item;
-    item.address = address;
-    item.speedStep = speedStep;
-    item.direction = direction;
-    item.elapsed.start();
-    replyQueue.append(item);
+    if(queueIfOtherThread(this, [=]() { setLocomotiveSpeed(address, speedStep, direction); }))
+        return true;
 
+    addPending(CommandType::SetLocoDrive, address, speedStep, direction);
 
     Z21::LanXSetLocoDrive message;
     message.setAddress(address, false);
@@ -89,11 +99,16 @@ bool Z21CommandStation::setLocomotiveSpeed(int address, int speedStep, Locomotiv
     message.updateChecksum();
 
     send(message);
-    return false;
+    return true;
 }
 
 bool Z21CommandStation::emergencyStop(int address)
 {
+    if(queueIfOtherThread(this, [=]() { emergencyStop(address); }))
+        return true;
+
+    addPending(CommandType::EmergencyStop, address, EMERGENCY_STOP, LocomotiveDirection::Forward);
+
     Z21::LanXSetLocoDrive message;
     message.setAddress(address, false);
     message.setDirection(Z21::Direction::Forward);
@@ -104,164 +119,230 @@ bool Z21CommandStation::emergencyStop(int address)
     return true;
 }
 
-void Z21CommandStation::readPendingDatagram()
-{
-    constexpr int MAX_BUF_SIZE = 4096;
-
-    QElapsedTimer timer;
-    timer.start();
+const Z21CommandStation::MessageHandler Z21CommandStation::messageHandlers[] = {
+    {Z21::LAN_X, Z21::LAN_X_LOCO_INFO, Z21::LanXLocoInfo::minMessageSize, &Z21CommandStation::onLocoInfo},
+};
 
-    while (mSocket->hasPendingDatagrams() && timer.elapsed() < 500)
+void Z21CommandStation::onDatagramsReceived(const Z21DatagramSocket::Datagram *datagrams, int count)
+{
+    for(int i = 0; i < count; i++)
     {
-        // Allocate buffer
-        qint64 sz = mSocket->pendingDatagramSize();
-        if (sz > MAX_BUF_SIZE)
-            sz = MAX_BUF_SIZE;
-
-        std::unique_ptr<uint8_t[]> buf(new uint8_t[sz]);
-        uint8_t *ptr = buf.get();
-
-        // Receive datagram
-        mSocket->readDatagram(reinterpret_cast<char *>(ptr), sz);
+        const uint8_t *ptr = datagrams[i].data;
+        int sz = datagrams[i].size;
 
         // NOTE: a single datagram can contain multimple independent Z21 message
-        while (sz > 2)
+        while (sz >= int(sizeof(Z21::Message)))
         {
-            // Check message is fully read
-            uint16_t msgSize = *reinterpret_cast<uint16_t *>(ptr);
+            // Check message is fully read, messages are packed so no alignment needed
+            uint16_t msgSize = 0;
+            memcpy(&msgSize, ptr, sizeof(msgSize));
             msgSize = qFromLittleEndian(msgSize);
 
-            //qDebug() << "Message???";
-
-            if (msgSize > sz || !msgSize)
+            if (msgSize > sz || msgSize < sizeof(Z21::Message))
                 break;
 
             // Handle message
-            const Z21::Message& message = *reinterpret_cast<const Z21::Message*>(ptr);
-            receive(message);
+            receive(*reinterpret_cast<const Z21::Message*>(ptr));
 
             // Go to next message
             ptr += msgSize;
             sz -= msgSize;
         }
     }
-
-    if (mSocket->hasPendingDatagrams() && !socketReadScheduled)
-    {
-        socketReadScheduled = true;
-        // Manually schedule next read
-        QMetaObject::invokeMethod(
-                    this,
-                    [this]() {
-            socketReadScheduled = false;
-            readPendingDatagram();
-        },
-        Qt::QueuedConnection);
-    }
 }
 
 void Z21CommandStation::receive(const Z21::Message &message)
 {
-    //qDebug() << "RECEIVE";
+    const uint16_t header = message.header();
+    const int size = message.dataLen();
 
-    // Clear old reply queue items
-    auto it = replyQueue.begin();
-    while(it != replyQueue.end())
+    uint8_t xheader = 0;
+    if(header == Z21::LAN_X)
     {
-        if(it->elapsed.elapsed() > 500)
-            it = replyQueue.erase(it);
-        else
-            it++;
+        // Checksum reads up to data size stored in xheader
+        const auto& lanX = static_cast<const Z21::LanX&>(message);
+        if(size < int(sizeof(Z21::LanX)) + 1)
+            return;
+        if(lanX.xheader != Z21::LAN_X_LOCO_INFO && size < int(sizeof(Z21::LanX)) + (lanX.xheader & 0x0F) + 1)
+            return;
+        if(!Z21::LanX::isChecksumValid(lanX))
+            return;
+
+        xheader = lanX.xheader;
     }
 
-    switch(message.header())
-    {
-    case Z21::LAN_X:
+    for(const MessageHandler& handler : messageHandlers)
     {
-        const auto& lanX = static_cast<const Z21::LanX&>(message);
+        if(handler.header != header || handler.xheader != xheader)
+            continue;
 
-        if(!Z21::LanX::isChecksumValid(lanX))
-            break;
+        if(size >= handler.minSize)
+            (this->*handler.handle)(message);
+        return;
+    }
+}
 
-        switch(lanX.xheader)
-        {
-        case Z21::LAN_X_LOCO_INFO:
-        {
-            if(message.dataLen() >= Z21::LanXLocoInfo::minMessageSize && message.dataLen() <= Z21::LanXLocoInfo::maxMessageSize)
-            {
-                const auto& reply = static_cast<const Z21::LanXLocoInfo&>(message);
+void Z21CommandStation::onLocoInfo(const Z21::Message &message)
+{
+    if(message.dataLen() > Z21::LanXLocoInfo::maxMessageSize)
+        return;
+
+    const auto& reply = static_cast<const Z21::LanXLocoInfo&>(message);
+
+    LocomotiveDirection direction = LocomotiveDirection::Forward;
+    if(reply.direction() == Z21::Direction::Reverse)
+        direction = LocomotiveDirection::Reverse;
 
-                LocomotiveDirection direction = LocomotiveDirection::Forward;
-                if(reply.direction() == Z21::Direction::Reverse)
-                    direction = LocomotiveDirection::Reverse;
+    //Rescale everything to 126 steps
+    int currentSpeedStep = reply.speedStep();
+    if(reply.speedSteps() != 126)
+    {
+        qDebug() << "WRONG SPEED STEP:" << reply.speedSteps();
+        currentSpeedStep = float(currentSpeedStep) / float(reply.speedSteps()) * 126.0;
+    }
 
-                //Rescale everything to 126 steps
-                int currentSpeedStep = reply.speedStep();
-                if(reply.speedSteps() != 126)
-                {
-                    qDebug() << "WRONG SPEED STEP:" << reply.speedSteps();
-                    currentSpeedStep = float(currentSpeedStep) / float(reply.speedSteps()) * 126.0;
-                }
+    if(reply.isEmergencyStop())
+        currentSpeedStep = EMERGENCY_STOP;
 
-                if(reply.isEmergencyStop())
-                    currentSpeedStep = EMERGENCY_STOP;
+    const qint64 now = monotonicMicros();
+    bool wasQueued = takePending(reply.address(), currentSpeedStep, direction, now);
 
-                auto queued = replyQueue.end();
-                for(auto it = replyQueue.begin(); it != replyQueue.end(); it++)
-                {
-                    if(it->address != reply.address())
-                        continue;
+#ifdef MSR_TRACE_Z21_LOCO_INFO
+    qDebug() << "LOCO_INFO:" << reply.address()
+             << "Dir:" << (direction == LocomotiveDirection::Forward ? 'F' : 'R')
+             << "Step:" << currentSpeedStep
+             << "Queued:" << wasQueued;
+#endif
 
-                    if(it->direction != direction)
-                        continue;
+    emit locomotiveSpeedFeedback(reply.address(), currentSpeedStep, direction, wasQueued, now);
+}
+
+void Z21CommandStation::addPending(CommandType type, int address, int speedStep, LocomotiveDirection direction)
+{
+    PendingCommand cmd;
+    cmd.id = mNextPendingId++;
+    cmd.speedStep = speedStep;
+    cmd.direction = direction;
+    cmd.type = type;
+    cmd.sentMicros = monotonicMicros();
+    mPending[address].append(cmd);
+    mPendingCount++;
+
+    // Expires between timeout and timeout + 1 slot
+    const int slot = (mWheelPos + ReplyTimeoutMillis / WheelSlotMillis + 1) % WheelSize;
+    mWheel[slot].append(WheelEntry{address, cmd.id});
+
+    if(!mWheelTimerId)
+        mWheelTimerId = startTimer(WheelSlotMillis, Qt::CoarseTimer);
+}
 
-                    if(it->speedStep != currentSpeedStep)
-                        continue;
+bool Z21CommandStation::takePending(int address, int speedStep, LocomotiveDirection direction, qint64 replyMicros)
+{
+    auto it = mPending.find(address);
+    if(it == mPending.end())
+        return false;
 
-                    queued = it;
-                    break;
-                }
+    // Oldest matching command first
+    QVector<PendingCommand>& commands = it.value();
+    for(int i = 0; i < commands.size(); i++)
+    {
+        const PendingCommand& cmd = commands.at(i);
+        if(cmd.direction != direction || cmd.speedStep != speedStep)
+            continue;
+
+        mLatency[int(cmd.type)].add(replyMicros - cmd.sentMicros);
+        commands.removeAt(i);
+        mPendingCount--;
+        return true;
+    }
 
-                bool wasQueued = (queued != replyQueue.end());
+    return false;
+}
 
-                if(wasQueued)
-                    replyQueue.erase(queued);
+void Z21CommandStation::advanceWheel()
+{
+    mWheelPos = (mWheelPos + 1) % WheelSize;
 
-                qDebug() << "LOCO_INFO:" << reply.address()
-                         << "Dir:" << (direction == LocomotiveDirection::Forward ? 'F' : 'R')
-                         << "Step:" << currentSpeedStep
-                         << "Queued:" << wasQueued;
+    QVector<WheelEntry>& slot = mWheel[mWheelPos];
+    for(const WheelEntry& entry : std::as_const(slot))
+    {
+        auto it = mPending.find(entry.address);
+        if(it == mPending.end())
+            continue;
 
-                emit locomotiveSpeedFeedback(reply.address(), currentSpeedStep, direction, wasQueued);
-            }
-            break;
-        }
-        default:
+        QVector<PendingCommand>& commands = it.value();
+        for(int i = 0; i < commands.size(); i++)
+        {
+            if(commands.at(i).id != entry.id)
+                continue;
+
+            commands.removeAt(i);
+            mPendingCount--;
+            mExpiredCount++;
             break;
         }
-        break;
     }
-    default:
-        break;
+
+    // Keep capacity for next round
+    slot.clear();
+
+    if(mPendingCount == 0)
+    {
+        killTimer(mWheelTimerId);
+        mWheelTimerId = 0;
+    }
+}
+
+void Z21CommandStation::resetLatencyStats()
+{
+    if(queueIfOtherThread(this, [this]() { resetLatencyStats(); }))
+        return;
+
+    for(LatencyHistogram& histogram : mLatency)
+        histogram.reset();
+    mExpiredCount = 0;
+    mLoggedCount = 0;
+}
+
+void Z21CommandStation::logLatencyStats()
+{
+    const LatencyHistogram& drive = mLatency[int(CommandType::SetLocoDrive)];
+    if(drive.count() == mLoggedCount)
+        return;
+    mLoggedCount = drive.count();
+
+    qDebug() << "Z21 LOCO_DRIVE latency us:"
+             << "n" << drive.count()
+             << "mean" << drive.mean()
+             << "p50" << drive.percentile(0.5)
+             << "p99" << drive.percentile(0.99)
+             << "max" << drive.max()
+             << "expired" << mExpiredCount;
+}
+
+void Z21CommandStation::timerEvent(QTimerEvent *e)
+{
+    if(e->timerId() == mWheelTimerId && mWheelTimerId)
+    {
+        advanceWheel();
+        return;
     }
+
+    ICommandStation::timerEvent(e);
 }
 
 void Z21CommandStation::send(const Z21::Message &message)
 {
-    mSocket->writeDatagram(reinterpret_cast<const char*>(&message),
-                           message.dataLen(),
-                           QHostAddress::Broadcast, 21105);
+    mSocket->writeDatagram(&message, message.dataLen(),
+                           mStationAddress, mStationPort);
 }
 
 void Z21CommandStation::requestLocoInfo(int address, int oldStep, LocomotiveDirection oldDir)
 {
-    ReplyQueueItem item;
-    item.address = address;
-    item.speedStep = oldStep;
-    item.direction = oldDir;
-    item.elapsed.start();
-    //replyQueue.append(item);
+    if(queueIfOtherThread(this, [=]() { requestLocoInfo(address, oldStep, oldDir); }))
+        return;
 
+    // Reply is not correlated, current state may differ from old one
     Z21::LanXGetLocoInfo message(address, false);
     send(message);
 }
@@ -25,12 +25,15 @@
 
 #include "../icommandstation.h"
 
-#include <QElapsedTimer>
+#include "z21datagramsocket.h"
 
-class QUdpSocket;
+#include "../../utils/latencyhistogram.h"
+
+#include <QHash>
+#include <QVector>
 
 namespace Z21 {
-class Message;
+struct Message;
 }
 
 class Z21CommandStation : public ICommandStation
@@ -39,32 +42,97 @@ class Z21CommandStation : public ICommandStation
 public:
     explicit Z21CommandStation(QObject *parent = nullptr);
 
+    // Bind local socket and subscribe to loco changes
+    bool bind(const QHostAddress& address, quint16 port);
+
+    // Where commands are sent, default is broadcast on port 21105
+    void setStationAddress(const QHostAddress& address, quint16 port);
+
     virtual bool setLocomotiveSpeed(int address, int speedStep, LocomotiveDirection direction) override;
 
     virtual bool emergencyStop(int address) override;
 
     void requestLocoInfo(int address, int oldStep, LocomotiveDirection oldDir);
 
+    // Commands whose reply round trip is measured
+    enum class CommandType
+    {
+        SetLocoDrive = 0,
+        EmergencyStop,
+        NTypes
+    };
+
+    // Latency and expired commands are logged with MSR_TRACE_Z21_LATENCY
+    void resetLatencyStats();
+
+protected:
+    void timerEvent(QTimerEvent *e) override;
+
 private slots:
-    void readPendingDatagram();
+    void onDatagramsReceived(const Z21DatagramSocket::Datagram *datagrams, int count);
 
 private:
     void receive(const Z21::Message& message);
     void send(const Z21::Message& message);
 
+    void onLocoInfo(const Z21::Message& message);
+
+    void addPending(CommandType type, int address, int speedStep, LocomotiveDirection direction);
+    bool takePending(int address, int speedStep, LocomotiveDirection direction, qint64 replyMicros);
+    void advanceWheel();
+    void logLatencyStats();
+
+    // Dispatch on (header, xheader), xheader only for LAN_X
+    // Messages shorter than minSize are dropped before handler is called
+    struct MessageHandler
+    {
+        uint16_t header;
+        uint8_t xheader;
+        uint16_t minSize;
+        void (Z21CommandStation::*handle)(const Z21::Message& message);
+    };
+    static const MessageHandler messageHandlers[];
+
 private:
-    QUdpSocket *mSocket;
-    bool socketReadScheduled = false;
+    Z21DatagramSocket *mSocket;
+
+    QHostAddress mStationAddress = QHostAddress(QHostAddress::Broadcast);
+    quint16 mStationPort = 21105;
 
-    struct ReplyQueueItem
+    // Commands waiting for LAN_X_LOCO_INFO, hashed by address
+    // Each address has few in flight commands so they are scanned in order
+    struct PendingCommand
     {
-        int address;
+        quint32 id;
         int speedStep;
         LocomotiveDirection direction;
-        QElapsedTimer elapsed;
+        CommandType type;
+        qint64 sentMicros;
+    };
+    QHash<int, QVector<PendingCommand>> mPending;
+    int mPendingCount = 0;
+    quint32 mNextPendingId = 0;
+
+    // Timer wheel for reply timeout, entries are left in their slot
+    // when reply arrives and ignored on expiry if id is gone
+    static constexpr int ReplyTimeoutMillis = 500;
+    static constexpr int WheelSlotMillis = 100;
+    static constexpr int WheelSize = ReplyTimeoutMillis / WheelSlotMillis + 2;
+
+    struct WheelEntry
+    {
+        int address;
+        quint32 id;
     };
+    QVector<WheelEntry> mWheel[WheelSize];
+    int mWheelPos = 0;
+    int mWheelTimerId = 0;
+
+    LatencyHistogram mLatency[int(CommandType::NTypes)];
 
-    QVector<ReplyQueueItem> replyQueue;
+    // Commands which got no matching reply in time
+    quint64 mExpiredCount = 0;
+    quint64 mLoggedCount = 0;
 };
 
 #endif // Z21COMMANDSTATION_H
@@ -0,0 +1,189 @@
+#include "z21datagramsocket.h"
+
+#include <QDebug>
+
+#ifdef Q_OS_LINUX
+#include <QSocketNotifier>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#else
+#include <QUdpSocket>
+#endif
+
+Z21DatagramSocket::Z21DatagramSocket(QObject *parent)
+    : QObject{parent}
+    , mSlots(new Slot[BatchSize])
+{
+#ifdef Q_OS_LINUX
+    mSocketFd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(mSocketFd < 0)
+    {
+        qWarning() << "Z21: cannot create socket:" << strerror(errno);
+        return;
+    }
+
+    // Command station is reached by broadcast
+    int on = 1;
+    setsockopt(mSocketFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    setsockopt(mSocketFd, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on));
+
+    // Room for bursts of loco broadcasts on a busy layout
+    int rcvBuf = 256 * 1024;
+    setsockopt(mSocketFd, SOL_SOCKET, SO_RCVBUF, &rcvBuf, sizeof(rcvBuf));
+
+    // Level triggered, fires again if we leave datagrams in queue
+    mNotifier = new QSocketNotifier(mSocketFd, QSocketNotifier::Read, this);
+    connect(mNotifier, &QSocketNotifier::activated, this, &Z21DatagramSocket::readPendingDatagrams);
+#else
+    mSocket = new QUdpSocket(this);
+    connect(mSocket, &QUdpSocket::readyRead, this, &Z21DatagramSocket::readPendingDatagrams);
+#endif
+}
+
+Z21DatagramSocket::~Z21DatagramSocket()
+{
+#ifdef Q_OS_LINUX
+    // Notifier must go before its socket
+    delete mNotifier;
+    mNotifier = nullptr;
+
+    if(mSocketFd >= 0)
+        ::close(mSocketFd);
+    mSocketFd = -1;
+#endif
+}
+
+bool Z21DatagramSocket::bind(const QHostAddress &address, quint16 port)
+{
+#ifdef Q_OS_LINUX
+    if(mSocketFd < 0)
+        return false;
+
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(address.toIPv4Address());
+
+    if(::bind(mSocketFd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) < 0)
+    {
+        qWarning() << "Z21: cannot bind" << address.toString() << port << strerror(errno);
+        return false;
+    }
+    return true;
+#else
+    return mSocket->bind(address, port);
+#endif
+}
+
+bool Z21DatagramSocket::writeDatagram(const void *data, int size, const QHostAddress &address, quint16 port)
+{
+#ifdef Q_OS_LINUX
+    if(mSocketFd < 0)
+        return false;
+
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(address.toIPv4Address());
+
+    const ssize_t ret = ::sendto(mSocketFd, data, size_t(size), 0,
+                                 reinterpret_cast<const sockaddr *>(&addr), sizeof(addr));
+    return ret == size;
+#else
+    return mSocket->writeDatagram(static_cast<const char *>(data), size, address, port) == size;
+#endif
+}
+
+void Z21DatagramSocket::readPendingDatagrams()
+{
+    for(int batch = 0; batch < MaxBatchesPerRead; batch++)
+    {
+        const int count = readBatch();
+        if(!count)
+            return;
+
+        mReceivedCount += count;
+        emit datagramsReceived(mBatch, count);
+
+        // Short batch means socket queue is empty
+        if(count < BatchSize)
+            return;
+    }
+
+#ifndef Q_OS_LINUX
+    // Let other events run, then continue
+    if(mSocket->hasPendingDatagrams() && !mReadScheduled)
+    {
+        mReadScheduled = true;
+        QMetaObject::invokeMethod(this, [this]()
+        {
+            mReadScheduled = false;
+            readPendingDatagrams();
+        }, Qt::QueuedConnection);
+    }
+#endif
+}
+
+int Z21DatagramSocket::readBatch()
+{
+#ifdef Q_OS_LINUX
+    if(mSocketFd < 0)
+        return 0;
+
+    mmsghdr msgs[BatchSize];
+    iovec iovs[BatchSize];
+    std::memset(msgs, 0, sizeof(msgs));
+
+    for(int i = 0; i < BatchSize; i++)
+    {
+        iovs[i].iov_base = mSlots[i].data;
+        iovs[i].iov_len = MaxDatagramSize;
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    const int count = recvmmsg(mSocketFd, msgs, BatchSize, MSG_DONTWAIT, nullptr);
+    if(count < 0)
+    {
+        if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            qWarning() << "Z21: receive failed:" << strerror(errno);
+        return 0;
+    }
+
+    for(int i = 0; i < count; i++)
+    {
+        if(msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+            mTruncatedCount++;
+
+        mBatch[i].data = mSlots[i].data;
+        mBatch[i].size = int(qMin(msgs[i].msg_len, unsigned(MaxDatagramSize)));
+    }
+
+    return count;
+#else
+    int count = 0;
+    while(count < BatchSize && mSocket->hasPendingDatagrams())
+    {
+        if(mSocket->pendingDatagramSize() > MaxDatagramSize)
+            mTruncatedCount++;
+
+        // Larger datagrams are truncated
+        const qint64 size = mSocket->readDatagram(reinterpret_cast<char *>(mSlots[count].data),
+                                                  MaxDatagramSize);
+        if(size < 0)
+            break;
+
+        mBatch[count].data = mSlots[count].data;
+        mBatch[count].size = int(size);
+        count++;
+    }
+
+    return count;
+#endif
+}
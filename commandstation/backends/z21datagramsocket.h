@@ -0,0 +1,81 @@
+#ifndef Z21DATAGRAMSOCKET_H
+#define Z21DATAGRAMSOCKET_H
+
+#include <QObject>
+#include <QHostAddress>
+
+#include <cstdint>
+#include <memory>
+
+#ifdef Q_OS_LINUX
+class QSocketNotifier;
+#else
+class QUdpSocket;
+#endif
+
+// UDP socket for Z21 protocol which receives into a preallocated buffer pool.
+// On Linux a native socket is used and a batch of datagrams is read
+// with a single recvmmsg() call, elsewhere QUdpSocket reads into the same pool.
+// No allocation happens while receiving.
+class Z21DatagramSocket : public QObject
+{
+    Q_OBJECT
+public:
+    // Datagrams read before returning to event loop
+    static constexpr int BatchSize = 16;
+    static constexpr int MaxBatchesPerRead = 32;
+
+    // Ethernet MTU minus IP and UDP headers
+    static constexpr int MaxDatagramSize = 1472;
+
+    struct Datagram
+    {
+        const uint8_t *data = nullptr;
+        int size = 0;
+    };
+
+    explicit Z21DatagramSocket(QObject *parent = nullptr);
+    ~Z21DatagramSocket();
+
+    bool bind(const QHostAddress& address, quint16 port);
+
+    bool writeDatagram(const void *data, int size, const QHostAddress& address, quint16 port);
+
+    inline quint64 receivedCount() const { return mReceivedCount; }
+    inline quint64 truncatedCount() const { return mTruncatedCount; }
+
+signals:
+    // Buffers are reused by next batch, only valid during emission
+    // so it must be connected in same thread (direct connection)
+    void datagramsReceived(const Z21DatagramSocket::Datagram *datagrams, int count);
+
+private slots:
+    void readPendingDatagrams();
+
+private:
+    // Fills mBatch, returns number of datagrams read
+    int readBatch();
+
+private:
+    // Each slot starts aligned, message structs are read in place
+    struct alignas(16) Slot
+    {
+        uint8_t data[MaxDatagramSize];
+    };
+
+    std::unique_ptr<Slot[]> mSlots;
+    Datagram mBatch[BatchSize];
+
+    quint64 mReceivedCount = 0;
+    quint64 mTruncatedCount = 0;
+
+#ifdef Q_OS_LINUX
+    int mSocketFd = -1;
+    QSocketNotifier *mNotifier = nullptr;
+#else
+    QUdpSocket *mSocket = nullptr;
+    bool mReadScheduled = false;
+#endif
+};
+
+#endif // Z21DATAGRAMSOCKET_H
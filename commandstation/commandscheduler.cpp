@@ -0,0 +1,226 @@
+#include "commandscheduler.h"
+
+#include "../utils/threadutils.h"
+#include "../utils/monotonicclock.h"
+
+#include <QTimerEvent>
+
+#include <QtMath>
+
+#include <QDebug>
+
+static constexpr int StatsLogMillis = 10000;
+
+CommandScheduler::CommandScheduler(QObject *parent)
+    : ICommandStation{parent}
+{
+    mLastRefillMicros = monotonicMicros();
+    mStatsTimerId = startTimer(StatsLogMillis, Qt::VeryCoarseTimer);
+}
+
+bool CommandScheduler::setLocomotiveSpeed(int address, int speedStep, LocomotiveDirection direction)
+{
+    if(queueIfOtherThread(this, [=]() { setLocomotiveSpeed(address, speedStep, direction); }))
+        return true;
+
+    if(!mCommandStation)
+        return false;
+
+    if(speedStep == EMERGENCY_STOP)
+    {
+        // Same priority as emergencyStop() but keep requested direction
+        cancelPending(address);
+
+        refillTokens();
+        mTokens -= 1;
+        mSentCount++;
+        return mCommandStation->setLocomotiveSpeed(address, speedStep, direction);
+    }
+
+    auto it = mPending.find(address);
+    if(it != mPending.end())
+    {
+        // Superseded, keep queue position of older one
+        it->speedStep = speedStep;
+        it->direction = direction;
+        mDroppedCount++;
+        return true;
+    }
+
+    mPending.insert(address, PendingSpeed{speedStep, direction});
+    mOrder.append(address);
+    mMaxQueueDepth = qMax(mMaxQueueDepth, mPending.size());
+
+    flushQueue();
+    return true;
+}
+
+bool CommandScheduler::emergencyStop(int address)
+{
+    if(queueIfOtherThread(this, [=]() { emergencyStop(address); }))
+        return true;
+
+    if(!mCommandStation)
+        return false;
+
+    // Pending speed would restart the locomotive
+    cancelPending(address);
+
+    // Never delayed, budget goes negative so other commands wait
+    refillTokens();
+    mTokens -= 1;
+    mSentCount++;
+    return mCommandStation->emergencyStop(address);
+}
+
+ICommandStation *CommandScheduler::commandStation() const
+{
+    return mCommandStation;
+}
+
+void CommandScheduler::setCommandStation(ICommandStation *newCommandStation)
+{
+    if(mCommandStation)
+        disconnect(mCommandStation, &ICommandStation::locomotiveSpeedFeedback, this, &ICommandStation::locomotiveSpeedFeedback);
+
+    mCommandStation = newCommandStation;
+
+    if(mCommandStation)
+        connect(mCommandStation, &ICommandStation::locomotiveSpeedFeedback, this, &ICommandStation::locomotiveSpeedFeedback);
+}
+
+int CommandScheduler::packetsPerSecond() const
+{
+    return mPacketsPerSecond;
+}
+
+void CommandScheduler::setPacketsPerSecond(int newPacketsPerSecond)
+{
+    if(queueIfOtherThread(this, [=]() { setPacketsPerSecond(newPacketsPerSecond); }))
+        return;
+
+    if(newPacketsPerSecond < 1)
+        return;
+
+    refillTokens();
+    mPacketsPerSecond = newPacketsPerSecond;
+    scheduleFlush();
+}
+
+int CommandScheduler::burstSize() const
+{
+    return mBurstSize;
+}
+
+void CommandScheduler::setBurstSize(int newBurstSize)
+{
+    if(queueIfOtherThread(this, [=]() { setBurstSize(newBurstSize); }))
+        return;
+
+    if(newBurstSize < 1)
+        return;
+
+    mBurstSize = newBurstSize;
+    mTokens = qMin(mTokens, double(mBurstSize));
+}
+
+void CommandScheduler::resetCounters()
+{
+    if(queueIfOtherThread(this, [this]() { resetCounters(); }))
+        return;
+
+    mMaxQueueDepth = mPending.size();
+    mDroppedCount = 0;
+    mSentCount = 0;
+    mLoggedSentCount = 0;
+}
+
+void CommandScheduler::timerEvent(QTimerEvent *e)
+{
+    if(e->timerId() == mFlushTimerId && mFlushTimerId)
+    {
+        killTimer(mFlushTimerId);
+        mFlushTimerId = 0;
+
+        flushQueue();
+        return;
+    }
+    else if(e->timerId() == mStatsTimerId && mStatsTimerId)
+    {
+        logStats();
+        return;
+    }
+
+    ICommandStation::timerEvent(e);
+}
+
+void CommandScheduler::refillTokens()
+{
+    const qint64 now = monotonicMicros();
+    const double elapsed = double(now - mLastRefillMicros) / 1000000.0;
+    mLastRefillMicros = now;
+
+    mTokens = qMin(double(mBurstSize), mTokens + elapsed * mPacketsPerSecond);
+}
+
+void CommandScheduler::flushQueue()
+{
+    refillTokens();
+
+    while(mTokens >= 1 && !mOrder.isEmpty())
+    {
+        const int address = mOrder.takeFirst();
+
+        auto it = mPending.find(address);
+        if(it == mPending.end())
+            continue; // Cancelled by emergency stop
+
+        const PendingSpeed cmd = it.value();
+        mPending.erase(it);
+
+        mTokens -= 1;
+        mSentCount++;
+
+        if(mCommandStation)
+            mCommandStation->setLocomotiveSpeed(address, cmd.speedStep, cmd.direction);
+    }
+
+    if(mPending.isEmpty())
+        mOrder.clear();
+
+    scheduleFlush();
+}
+
+void CommandScheduler::scheduleFlush()
+{
+    if(mPending.isEmpty() || mFlushTimerId)
+        return;
+
+    // Wait until next token is available
+    const double missing = 1.0 - mTokens;
+    const int waitMillis = qMax(1, qCeil(missing * 1000.0 / mPacketsPerSecond));
+    mFlushTimerId = startTimer(waitMillis, Qt::PreciseTimer);
+}
+
+void CommandScheduler::cancelPending(int address)
+{
+    if(!mPending.remove(address))
+        return;
+
+    // Otherwise a new speed for address would be queued twice
+    mOrder.removeOne(address);
+    mDroppedCount++;
+}
+
+void CommandScheduler::logStats()
+{
+    if(mSentCount == mLoggedSentCount)
+        return;
+    mLoggedSentCount = mSentCount;
+
+    qDebug() << "Scheduler sent:" << mSentCount
+             << "dropped" << mDroppedCount
+             << "queue" << mPending.size()
+             << "max queue" << mMaxQueueDepth
+             << "budget pkt/s" << mPacketsPerSecond;
+}
@@ -0,0 +1,85 @@
+#ifndef COMMANDSCHEDULER_H
+#define COMMANDSCHEDULER_H
+
+#include "icommandstation.h"
+
+#include <QHash>
+#include <QVector>
+
+// Sits between LocomotivePool and a real command station.
+// Speed commands are queued one per address: a newer speed for an address
+// replaces the pending one, which is dropped.
+// Output is limited by a token bucket of packetsPerSecond with a small burst.
+// Emergency stops are sent at once, even over budget, and cancel pending speed.
+// Feedback of command station is forwarded unchanged.
+// Must live in same thread of its command station.
+// Counters are logged periodically when something was sent.
+class CommandScheduler : public ICommandStation
+{
+    Q_OBJECT
+public:
+    explicit CommandScheduler(QObject *parent = nullptr);
+
+    bool setLocomotiveSpeed(int address, int speedStep, LocomotiveDirection direction) override;
+
+    bool emergencyStop(int address) override;
+
+    ICommandStation *commandStation() const;
+    void setCommandStation(ICommandStation *newCommandStation);
+
+    int packetsPerSecond() const;
+    void setPacketsPerSecond(int newPacketsPerSecond);
+
+    int burstSize() const;
+    void setBurstSize(int newBurstSize);
+
+    // Counters are read in scheduler thread, other threads use the log
+    // Addresses with a speed waiting to be sent
+    inline int queueDepth() const { return mPending.size(); }
+    inline int maxQueueDepth() const { return mMaxQueueDepth; }
+
+    // Speeds replaced by a newer one or cancelled by emergency stop
+    inline quint64 droppedCount() const { return mDroppedCount; }
+    inline quint64 sentCount() const { return mSentCount; }
+
+    void resetCounters();
+
+protected:
+    void timerEvent(QTimerEvent *e) override;
+
+private:
+    void refillTokens();
+    void flushQueue();
+    void scheduleFlush();
+    void cancelPending(int address);
+    void logStats();
+
+private:
+    ICommandStation *mCommandStation = nullptr;
+
+    struct PendingSpeed
+    {
+        int speedStep;
+        LocomotiveDirection direction;
+    };
+
+    QHash<int, PendingSpeed> mPending;
+
+    // Send order of addresses, entries without pending speed are skipped
+    QVector<int> mOrder;
+
+    int mPacketsPerSecond = 50;
+    int mBurstSize = 4;
+
+    double mTokens = 4;
+    qint64 mLastRefillMicros = 0;
+    int mFlushTimerId = 0;
+    int mStatsTimerId = 0;
+
+    int mMaxQueueDepth = 0;
+    quint64 mDroppedCount = 0;
+    quint64 mSentCount = 0;
+    quint64 mLoggedSentCount = 0;
+};
+
+#endif // COMMANDSCHEDULER_H
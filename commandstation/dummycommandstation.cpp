@@ -1,5 +1,7 @@
 #include "dummycommandstation.h"
 
+#include "../utils/monotonicclock.h"
+
 #include <QTimer>
 
 DummyCommandStation::DummyCommandStation(QObject *parent)
@@ -12,7 +14,7 @@ bool DummyCommandStation::setLocomotiveSpeed(int address, int speedStep, Locomot
 {
     QTimer::singleShot(300, this, [this, address, speedStep, direction]()
                        {
-                           locomotiveSpeedFeedback(address, speedStep, direction, false);
+                           locomotiveSpeedFeedback(address, speedStep, direction, false, monotonicMicros());
                        });
     return true;
 }
@@ -21,7 +23,7 @@ bool DummyCommandStation::emergencyStop(int address)
 {
     QTimer::singleShot(300, this, [this, address]()
                        {
-                           locomotiveSpeedFeedback(address, 0, LocomotiveDirection::Forward, false);
+                           locomotiveSpeedFeedback(address, 0, LocomotiveDirection::Forward, false, monotonicMicros());
                        });
     return true;
 }
@@ -11,12 +11,16 @@ class ICommandStation : public QObject
 public:
     explicit ICommandStation(QObject *parent = nullptr);
 
+    // Return true if command was sent or queued to station thread,
+    // confirmation comes later with locomotiveSpeedFeedback()
     virtual bool setLocomotiveSpeed(int address, int speedStep, LocomotiveDirection direction) = 0;
 
     virtual bool emergencyStop(int address) = 0;
 
 signals:
-    void locomotiveSpeedFeedback(int address, int speedStep, LocomotiveDirection direction, bool wasQueued);
+    // hostMicros is monotonicMicros() when feedback was received
+    void locomotiveSpeedFeedback(int address, int speedStep, LocomotiveDirection direction,
+                                 bool wasQueued, qint64 hostMicros);
 };
 
 #endif // ICOMMANDSTATION_H
@@ -0,0 +1,23 @@
+#include "replaycommandstation.h"
+
+ReplayCommandStation::ReplayCommandStation(QObject *parent)
+    : ICommandStation{parent}
+{
+
+}
+
+bool ReplayCommandStation::setLocomotiveSpeed(int /*address*/, int /*speedStep*/, LocomotiveDirection /*direction*/)
+{
+    return true;
+}
+
+bool ReplayCommandStation::emergencyStop(int /*address*/)
+{
+    return true;
+}
+
+void ReplayCommandStation::replayFeedback(int address, int speedStep, LocomotiveDirection direction)
+{
+    // Replay clock is used instead of host time
+    emit locomotiveSpeedFeedback(address, speedStep, direction, false, 0);
+}
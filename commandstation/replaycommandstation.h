@@ -0,0 +1,21 @@
+#ifndef REPLAYCOMMANDSTATION_H
+#define REPLAYCOMMANDSTATION_H
+
+#include "icommandstation.h"
+
+// Re-emits locomotive feedback of a recorded run, driven by ReplayEngine
+// Commands are accepted but ignored, the recorded ones are replayed instead
+class ReplayCommandStation : public ICommandStation
+{
+    Q_OBJECT
+public:
+    explicit ReplayCommandStation(QObject *parent = nullptr);
+
+    bool setLocomotiveSpeed(int address, int speedStep, LocomotiveDirection direction) override;
+
+    bool emergencyStop(int address) override;
+
+    void replayFeedback(int address, int speedStep, LocomotiveDirection direction);
+};
+
+#endif // REPLAYCOMMANDSTATION_H
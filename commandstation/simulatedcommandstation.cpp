@@ -0,0 +1,38 @@
+#include "simulatedcommandstation.h"
+
+#include "../simulation/layoutsimulator.h"
+
+#include "../utils/threadutils.h"
+
+SimulatedCommandStation::SimulatedCommandStation(LayoutSimulator *simulator)
+    : ICommandStation{simulator}
+    , mSimulator(simulator)
+{
+
+}
+
+bool SimulatedCommandStation::setLocomotiveSpeed(int address, int speedStep, LocomotiveDirection direction)
+{
+    if(queueIfOtherThread(this, [=]() { setLocomotiveSpeed(address, speedStep, direction); }))
+        return true;
+
+    mSimulator->queueCommand(address, speedStep, direction);
+    return true;
+}
+
+bool SimulatedCommandStation::emergencyStop(int address)
+{
+    if(queueIfOtherThread(this, [=]() { emergencyStop(address); }))
+        return true;
+
+    // Keep direction like a real decoder
+    const VirtualLocomotive *loco = mSimulator->locomotive(address);
+    const LocomotiveDirection direction = loco ? loco->requestedDirection() : LocomotiveDirection::Forward;
+    mSimulator->queueCommand(address, EMERGENCY_STOP, direction);
+    return true;
+}
+
+void SimulatedCommandStation::simulateFeedback(int address, int speedStep, LocomotiveDirection direction, qint64 hostMicros)
+{
+    emit locomotiveSpeedFeedback(address, speedStep, direction, false, hostMicros);
+}
@@ -0,0 +1,26 @@
+#ifndef SIMULATEDCOMMANDSTATION_H
+#define SIMULATEDCOMMANDSTATION_H
+
+#include "icommandstation.h"
+
+class LayoutSimulator;
+
+// Forwards commands to virtual locomotives of a LayoutSimulator
+// and emits their feedback on simulator clock
+class SimulatedCommandStation : public ICommandStation
+{
+    Q_OBJECT
+public:
+    explicit SimulatedCommandStation(LayoutSimulator *simulator);
+
+    bool setLocomotiveSpeed(int address, int speedStep, LocomotiveDirection direction) override;
+
+    bool emergencyStop(int address) override;
+
+    void simulateFeedback(int address, int speedStep, LocomotiveDirection direction, qint64 hostMicros);
+
+private:
+    LayoutSimulator *mSimulator;
+};
+
+#endif // SIMULATEDCOMMANDSTATION_H
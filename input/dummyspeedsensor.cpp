@@ -31,7 +31,7 @@ void DummySpeedSensor::timerEvent(QTimerEvent *e)
         currentSpeed += noise;
         lastSpeedMetersPerSecond = currentSpeed;
 
-        emit speedReading(currentSpeed, travelledMillimeters, newTime);
+        publishReading(currentSpeed, travelledMillimeters, newTime * 1000);
         return;
     }
 
@@ -7,12 +7,29 @@
 #include <QLabel>
 #include <QPushButton>
 #include <QSpinBox>
+#include <QLineEdit>
+#include <QHostAddress>
+#include <QHBoxLayout>
 
 ESPAnalogHallConfigWidget::ESPAnalogHallConfigWidget(QWidget *parent)
     : QWidget{parent}
 {
     QVBoxLayout *lay = new QVBoxLayout(this);
 
+    mAddressEdit = new QLineEdit(QLatin1String(ESPAnalogHallSensor::DefaultAddress));
+    mAddressEdit->setToolTip(tr("Applied on next connection"));
+    mPortSpin = new QSpinBox;
+    mPortSpin->setRange(1, 65535);
+    mPortSpin->setValue(ESPAnalogHallSensor::DefaultPort);
+
+    QHBoxLayout *addressLay = new QHBoxLayout;
+    addressLay->addWidget(new QLabel(tr("Sensor Address:")));
+    addressLay->addWidget(mAddressEdit);
+    addressLay->addWidget(mPortSpin);
+    lay->addLayout(addressLay);
+    connect(mAddressEdit, &QLineEdit::editingFinished, this, &ESPAnalogHallConfigWidget::applyAddress);
+    connect(mPortSpin, &QSpinBox::editingFinished, this, &ESPAnalogHallConfigWidget::applyAddress);
+
     mConnectedCheck = new QCheckBox(tr("Connected"));
     lay->addWidget(mConnectedCheck);
     connect(mConnectedCheck, &QCheckBox::toggled, this, [this](bool val)
@@ -30,6 +47,25 @@ ESPAnalogHallConfigWidget::ESPAnalogHallConfigWidget(QWidget *parent)
             mSensor->setDebugOutput(val);
     });
 
+    mBinaryProtocolCheck = new QCheckBox(tr("Binary Protocol"));
+    mBinaryProtocolCheck->setChecked(true);
+    mBinaryProtocolCheck->setToolTip(tr("Applied on next connection"));
+    lay->addWidget(mBinaryProtocolCheck);
+    connect(mBinaryProtocolCheck, &QCheckBox::toggled, this, [this](bool val)
+    {
+        if(mSensor)
+            mSensor->setPreferBinaryProtocol(val);
+    });
+
+    mHostEdgesCheck = new QCheckBox(tr("Host Edge Detection"));
+    mHostEdgesCheck->setToolTip(tr("Detect half rotations from raw waveform using thresholds below"));
+    lay->addWidget(mHostEdgesCheck);
+    connect(mHostEdgesCheck, &QCheckBox::toggled, this, [this](bool val)
+    {
+        if(mSensor)
+            mSensor->setHostEdgeDetection(val);
+    });
+
     mMonitorBut = new QPushButton;
     lay->addWidget(mMonitorBut);
     setMonitoring(false);
@@ -117,11 +153,35 @@ void ESPAnalogHallConfigWidget::setSensor(ESPAnalogHallSensor *newSensor)
                 this, &ESPAnalogHallConfigWidget::onSensorDestroyed);
         connect(mSensor, &ESPAnalogHallSensor::sensorMinMaxChanged,
                 this, &ESPAnalogHallConfigWidget::onSensorMinMaxChanged);
+
+        mSensor->setPreferBinaryProtocol(mBinaryProtocolCheck->isChecked());
+        mSensor->setHostEdgeDetection(mHostEdgesCheck->isChecked());
     }
 
     setMonitoring(false);
 }
 
+void ESPAnalogHallConfigWidget::setSensorAddress(const QHostAddress &address, quint16 port)
+{
+    mAddressEdit->setText(address.toString());
+    mPortSpin->setValue(port);
+    applyAddress();
+}
+
+void ESPAnalogHallConfigWidget::applyAddress()
+{
+    QHostAddress address;
+    if(!address.setAddress(mAddressEdit->text().trimmed()))
+    {
+        mAddressEdit->setStyleSheet(QLatin1String("color: red"));
+        return;
+    }
+
+    mAddressEdit->setStyleSheet(QString());
+    if(mSensor)
+        mSensor->setIPAddress(address, quint16(mPortSpin->value()));
+}
+
 void ESPAnalogHallConfigWidget::onSensorDestroyed()
 {
     setSensor(nullptr);
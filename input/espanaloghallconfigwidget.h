@@ -5,10 +5,13 @@
 
 class ESPAnalogHallSensor;
 
+class QHostAddress;
+
 class QPushButton;
 class QCheckBox;
 class QLabel;
 class QSpinBox;
+class QLineEdit;
 
 class ESPAnalogHallConfigWidget : public QWidget
 {
@@ -19,11 +22,15 @@ public:
     ESPAnalogHallSensor *sensor() const;
     void setSensor(ESPAnalogHallSensor *newSensor);
 
+    // Shows address and sets it on sensor
+    void setSensorAddress(const QHostAddress& address, quint16 port);
+
 private slots:
     void onSensorDestroyed();
     void onSensorMinMaxChanged(int sensorMin, int sensorMax);
 
     void setMonitoring(bool val);
+    void applyAddress();
 
 private:
     ESPAnalogHallSensor *mSensor = nullptr;
@@ -32,8 +39,12 @@ private:
     int mSensorMax = -1;
     bool mMonitoring = false;
 
+    QLineEdit *mAddressEdit;
+    QSpinBox *mPortSpin;
     QCheckBox *mConnectedCheck;
     QCheckBox *mDebugOutputCheck;
+    QCheckBox *mBinaryProtocolCheck;
+    QCheckBox *mHostEdgesCheck;
     QPushButton *mMonitorBut;
     QPushButton *mResetTravelBut;
     QPushButton *mSuggestThresholdBut;
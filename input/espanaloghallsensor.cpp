@@ -1,18 +1,23 @@
 #include "espanaloghallsensor.h"
 
+#include "../utils/threadutils.h"
+
 #include <QTcpSocket>
 #include <QElapsedTimer>
 
 #include <QDebug>
 #include <QTime>
 
+#include <cstring>
+
 ESPAnalogHallSensor::ESPAnalogHallSensor(QObject *parent)
     : ISpeedSensor{parent}
 {
     mSocket = new QTcpSocket(this);
+    connect(mSocket, &QTcpSocket::connected, this, &ESPAnalogHallSensor::onConnected);
     connect(mSocket, &QTcpSocket::readyRead, this, &ESPAnalogHallSensor::parseData);
 
-    mIPAddress = QHostAddress("192.168.1.4");
+    mIPAddress = QHostAddress(QLatin1String(DefaultAddress));
 }
 
 ESPAnalogHallSensor::~ESPAnalogHallSensor()
@@ -22,8 +27,20 @@ ESPAnalogHallSensor::~ESPAnalogHallSensor()
 
 void ESPAnalogHallSensor::setState(bool on)
 {
+    if(queueIfOtherThread(this, [=]() { setState(on); }))
+        return;
+
     if(on && mSocket->state() != QTcpSocket::ConnectedState)
     {
+        // Drop partial data of previous connection
+        mParser.clear();
+        mFrameParser.clear();
+        mBinaryMode = false;
+        mReportedLostFrames = 0;
+        mEdgeDetector.reset();
+        mLastEdgeMicros = -1;
+        mLastHostReadingMicros = -1;
+        mLastReadingMillis = -1;
         mSocket->connectToHost(mIPAddress, mPort, QIODevice::ReadWrite);
     }
     else if(!on && mSocket->state() == QTcpSocket::ConnectedState)
@@ -32,8 +49,22 @@ void ESPAnalogHallSensor::setState(bool on)
     }
 }
 
+void ESPAnalogHallSensor::setIPAddress(const QHostAddress &address, quint16 port)
+{
+    if(queueIfOtherThread(this, [=]() { setIPAddress(address, port); }))
+        return;
+
+    mIPAddress = address;
+    mPort = port;
+}
+
 void ESPAnalogHallSensor::resetTravelledCount()
 {
+    if(queueIfOtherThread(this, [=]() { resetTravelledCount(); }))
+        return;
+
+    mHostTravelled = 0;
+
     if(mSocket->state() != QTcpSocket::ConnectedState)
         return;
 
@@ -43,20 +74,30 @@ void ESPAnalogHallSensor::resetTravelledCount()
 
 void ESPAnalogHallSensor::setDebugOutput(bool val)
 {
-    if(mSocket->state() != QTcpSocket::ConnectedState)
+    if(queueIfOtherThread(this, [=]() { setDebugOutput(val); }))
         return;
 
-    mSocket->write(val ? "d\n" : "n\n");
-    mSocket->flush();
+    mDebugOutput = val;
+    updateAnalogStreaming();
 }
 
 void ESPAnalogHallSensor::setThresholds(int highEnter, int highExit, int lowEnter, int lowExit)
 {
+    if(queueIfOtherThread(this, [=]() { setThresholds(highEnter, highExit, lowEnter, lowExit); }))
+        return;
+
+    HallEdgeDetector::Thresholds thresholds;
+    thresholds.highEnter = highEnter;
+    thresholds.highExit = highExit;
+    thresholds.lowEnter = lowEnter;
+    thresholds.lowExit = lowExit;
+    mEdgeDetector.setThresholds(thresholds);
+
     if(mSocket->state() != QTcpSocket::ConnectedState)
         return;
 
     QString format(QLatin1String("s %1 %2 %3 %4\n"));
-    QByteArray cmd = format.arg(highEnter).arg(highExit).arg(lowEnter).arg(lowEnter).toLatin1();
+    QByteArray cmd = format.arg(highEnter).arg(highExit).arg(lowEnter).arg(lowExit).toLatin1();
 
     mSocket->write(cmd);
     mSocket->flush();
@@ -64,91 +105,267 @@ void ESPAnalogHallSensor::setThresholds(int highEnter, int highExit, int lowEnte
 
 void ESPAnalogHallSensor::resetSensorMinMax()
 {
+    if(queueIfOtherThread(this, [=]() { resetSensorMinMax(); }))
+        return;
+
     minValue = -1;
     maxValue = -1;
     emit sensorMinMaxChanged(-1, -1);
 }
 
+void ESPAnalogHallSensor::setPreferBinaryProtocol(bool val)
+{
+    if(queueIfOtherThread(this, [=]() { setPreferBinaryProtocol(val); }))
+        return;
+
+    mPreferBinary = val;
+}
+
+void ESPAnalogHallSensor::setHostEdgeDetection(bool val)
+{
+    if(queueIfOtherThread(this, [=]() { setHostEdgeDetection(val); }))
+        return;
+
+    mHostEdgeDetection = val;
+    mEdgeDetector.reset();
+    mLastEdgeMicros = -1;
+    updateAnalogStreaming();
+}
+
+void ESPAnalogHallSensor::onConnected()
+{
+    if(!mPreferBinary)
+        return;
+
+    // Old firmware ignores it and keeps sending text lines
+    mSocket->write("b 1\n");
+    mSocket->flush();
+}
+
 void ESPAnalogHallSensor::parseData()
 {
     QElapsedTimer t;
     t.start();
 
-    while(mSocket->canReadLine())
-    {
-        QByteArray line = mSocket->readLine(30);
+    ESPSensorLineParser::Record rec;
 
-        qDebug() << "SENSOR:" << QTime::currentTime() << line;
+    while(mSocket->bytesAvailable() > 0)
+    {
+        if(mBinaryMode)
+        {
+            const qint64 n = mSocket->read(mFrameParser.writeBuffer(), mFrameParser.writeSpace());
+            if(n <= 0)
+                break;
 
-        QList<QByteArray> list = line.split(' ');
-        if(list.size() == 2)
+            mFrameParser.commitWrite(int(n));
+            parseFrames();
+        }
+        else
         {
-            // Might be a debug output
-            // "NUM_HALF_ROTATIONS SENSOR_VALUE"
-            bool ok = false;
-            int halfRotations = list.at(0).toInt(&ok);
-            int sensorValue = 0;
-            bool minMaxChanged = false;
-
-            if(ok)
-            {
-                Q_UNUSED(halfRotations);
-                sensorValue = list.at(1).toInt(&ok);
-            }
+            const qint64 n = mSocket->read(mParser.writeBuffer(), mParser.writeSpace());
+            if(n <= 0)
+                break;
 
-            if(ok)
-            {
-                if(sensorValue > maxValue)
-                {
-                    maxValue = sensorValue;
-                    minMaxChanged = true;
-                }
+            mParser.commitWrite(int(n));
 
-                if(minValue == -1 || sensorValue < minValue)
+            while(mParser.nextRecord(rec))
+            {
+                if(rec.type == ESPSensorLineParser::RecordType::BinaryModeAck)
                 {
-                    minValue = sensorValue;
-                    minMaxChanged = true;
+                    switchToBinaryMode();
+                    parseFrames();
+                    break;
                 }
-            }
 
-            if(minMaxChanged)
-            {
-                emit sensorMinMaxChanged(minValue, maxValue);
+                handleRecord(rec);
             }
         }
-        else if(list.size() == 4)
+
+        if(t.hasExpired(500))
         {
-            qint64 timestamp = 0;
-            qint64 halfRotationCount = 0;
-            double travelledSpace = 0;
-            double avgSpeed = 0;
+            // Avoid blocking event loop
+            // Reschedule parsing
+            QMetaObject::invokeMethod(this, &ESPAnalogHallSensor::parseData, Qt::QueuedConnection);
+            break;
+        }
+    }
+}
+
+void ESPAnalogHallSensor::handleRecord(const ESPSensorLineParser::Record &rec)
+{
+#ifdef MSR_TRACE_SENSOR_LINES
+    qDebug() << "SENSOR:" << QTime::currentTime() << QByteArray(rec.line, rec.lineLength);
+#endif
+
+    switch (rec.type)
+    {
+    case ESPSensorLineParser::RecordType::Reading:
+    {
+        publishReading(rec.metersPerSecond, rec.travelledMillimeters, rec.timestamp * 1000);
+        break;
+    }
+    case ESPSensorLineParser::RecordType::SensorValue:
+    {
+        // Might be a debug output
+        if(updateMinMax(rec.sensorValue))
+            emit sensorMinMaxChanged(minValue, maxValue);
+        break;
+    }
+    default:
+        break;
+    }
+}
 
-            bool ok = false;
-            timestamp = list.at(0).toLongLong(&ok);
+void ESPAnalogHallSensor::switchToBinaryMode()
+{
+    // Bytes after acknowledge line are already frames
+    const int size = qMin(mParser.remainingSize(), mFrameParser.writeSpace());
+    memcpy(mFrameParser.writeBuffer(), mParser.remainingData(), size);
+    mFrameParser.commitWrite(size);
 
-            if(ok)
-                halfRotationCount = list.at(1).toLongLong(&ok);
+    mParser.clear();
+    mBinaryMode = true;
 
-            if(ok)
-                travelledSpace = list.at(2).toDouble(&ok);
+    if(mHostEdgeDetection)
+        updateAnalogStreaming();
+}
 
-            if(ok)
-                avgSpeed = list.at(3).toDouble(&ok);
+void ESPAnalogHallSensor::parseFrames()
+{
+    ESPSensorFrameParser::Frame frame;
+    while(mFrameParser.nextFrame(frame))
+        handleFrame(frame);
 
-            Q_UNUSED(halfRotationCount);
+    if(mFrameParser.lostFrames() != mReportedLostFrames)
+    {
+        qWarning() << "ESP sensor frames lost:" << mFrameParser.lostFrames() - mReportedLostFrames
+                   << "CRC errors:" << mFrameParser.crcErrors();
+        mReportedLostFrames = mFrameParser.lostFrames();
+    }
+}
 
-            if(ok)
-            {
-                emit speedReading(avgSpeed, travelledSpace, timestamp);
-            }
+void ESPAnalogHallSensor::handleFrame(const ESPSensorFrameParser::Frame &frame)
+{
+    switch (frame.type)
+    {
+    case ESPSensorFrameParser::FrameType::Reading:
+    {
+        // Sensor millis are 32 bit, micros would wrap after ~71 minutes
+        mLastReadingMillis = qint64(frame.timestamp);
+        const qint64 timestampMicros = mLastReadingMillis * 1000;
+
+        if(frame.halfRotations > 0 && frame.travelledMillimeters > 0)
+            mMillimetersPerHalfRotation = frame.travelledMillimeters / frame.halfRotations;
+
+        if(!mHostEdgeDetection || mMillimetersPerHalfRotation <= 0)
+        {
+            publishReading(frame.metersPerSecond, frame.travelledMillimeters, timestampMicros);
+        }
+        else if(mLastEdgeMicros < 0 || double(timestampMicros) - mLastEdgeMicros > StallMicros)
+        {
+            // No edges means we are stopped, keep readings flowing
+            publishHostReading(0, timestampMicros);
         }
+        break;
+    }
+    case ESPSensorFrameParser::FrameType::AnalogBlock:
+    {
+        handleWaveform(frame);
+        break;
+    }
+    }
+}
 
-        if(t.hasExpired(500))
+void ESPAnalogHallSensor::handleWaveform(const ESPSensorFrameParser::Frame &frame)
+{
+    // Cannot unwrap micros before a reading tells us sensor millis
+    if(mLastReadingMillis < 0)
+        return;
+
+    WaveformBlock block;
+    block.firstSampleMicros = unwrapMicros(frame.firstSampleMicros);
+    block.samplePeriodMicros = frame.samplePeriodMicros;
+    block.count = qMin(frame.sampleCount, int(WaveformBlock::MaxSamples));
+    memcpy(block.samples, frame.samples, block.count * sizeof(quint16));
+    publishWaveform(block);
+
+    // Raw samples at full rate, notify min/max once per block
+    bool minMaxChanged = false;
+    for(int i = 0; i < block.count; i++)
+    {
+        if(updateMinMax(block.samples[i]))
+            minMaxChanged = true;
+    }
+
+    if(minMaxChanged)
+        emit sensorMinMaxChanged(minValue, maxValue);
+
+    if(!mHostEdgeDetection || mMillimetersPerHalfRotation <= 0)
+        return;
+
+    mEdges.clear();
+    mEdgeDetector.process(block.samples, block.count, block.firstSampleMicros,
+                          block.samplePeriodMicros, mEdges);
+
+    for(const HallEdgeDetector::Edge& edge : std::as_const(mEdges))
+    {
+        if(mLastEdgeMicros >= 0 && edge.micros > mLastEdgeMicros)
         {
-            // Avoid blocking event loop
-            // Reschedule parsing
-            QMetaObject::invokeMethod(this, &ESPAnalogHallSensor::parseData, Qt::QueuedConnection);
-            break;
+            // Speed of last half rotation, mm/us to m/s
+            mHostTravelled += mMillimetersPerHalfRotation;
+            const double speed = mMillimetersPerHalfRotation / (edge.micros - mLastEdgeMicros) * 1000.0;
+            publishHostReading(speed, qRound64(edge.micros));
         }
+
+        mLastEdgeMicros = edge.micros;
+    }
+}
+
+void ESPAnalogHallSensor::publishHostReading(double metersPerSecond, qint64 timestampMicros)
+{
+    if(timestampMicros <= mLastHostReadingMicros)
+        return;
+
+    mLastHostReadingMicros = timestampMicros;
+    publishReading(metersPerSecond, mHostTravelled, timestampMicros);
+}
+
+bool ESPAnalogHallSensor::updateMinMax(int sensorValue)
+{
+    bool minMaxChanged = false;
+
+    if(sensorValue > maxValue)
+    {
+        maxValue = sensorValue;
+        minMaxChanged = true;
+    }
+
+    if(minValue == -1 || sensorValue < minValue)
+    {
+        minValue = sensorValue;
+        minMaxChanged = true;
     }
+
+    return minMaxChanged;
+}
+
+void ESPAnalogHallSensor::updateAnalogStreaming()
+{
+    if(mSocket->state() != QTcpSocket::ConnectedState)
+        return;
+
+    // In binary mode "d" streams raw waveform blocks
+    const bool on = mDebugOutput || (mHostEdgeDetection && mBinaryMode);
+    mSocket->write(on ? "d\n" : "n\n");
+    mSocket->flush();
+}
+
+qint64 ESPAnalogHallSensor::unwrapMicros(quint32 micros) const
+{
+    // Sensor micros wrap every ~71 minutes, millis of last reading
+    // tell us which wrap we are in
+    constexpr qint64 WrapPeriod = qint64(1) << 32;
+    const qint64 reference = mLastReadingMillis * 1000;
+    const qint64 wraps = qRound64(double(reference - qint64(micros)) / double(WrapPeriod));
+    return qint64(micros) + wraps * WrapPeriod;
 }
@@ -2,6 +2,9 @@
 #define ESPANALOGHALLSENSOR_H
 
 #include "ispeedsensor.h"
+#include "espsensorlineparser.h"
+#include "espsensorframeparser.h"
+#include "halledgedetector.h"
 
 #include <QHostAddress>
 
@@ -11,6 +14,9 @@ class ESPAnalogHallSensor : public ISpeedSensor
 {
     Q_OBJECT
 public:
+    static constexpr const char *DefaultAddress = "192.168.1.4";
+    static constexpr quint16 DefaultPort = 1234;
+
     explicit ESPAnalogHallSensor(QObject *parent = nullptr);
     ~ESPAnalogHallSensor();
 
@@ -20,6 +26,9 @@ signals:
 public slots:
     void setState(bool on);
 
+    // Applied on next connection
+    void setIPAddress(const QHostAddress& address, quint16 port = DefaultPort);
+
     void resetTravelledCount();
 
     void setDebugOutput(bool val);
@@ -28,13 +37,56 @@ public slots:
 
     void resetSensorMinMax();
 
+    // Ask sensor for binary frames on next connection
+    void setPreferBinaryProtocol(bool val);
+
+    // Detect half rotations on raw waveform instead of using sensor readings.
+    // Needs binary protocol, distance of half rotation is learned from sensor readings
+    void setHostEdgeDetection(bool val);
+
 private slots:
+    void onConnected();
     void parseData();
 
 private:
+    void handleRecord(const ESPSensorLineParser::Record& rec);
+    void switchToBinaryMode();
+    void parseFrames();
+    void handleFrame(const ESPSensorFrameParser::Frame& frame);
+    bool updateMinMax(int sensorValue);
+    void updateAnalogStreaming();
+    qint64 unwrapMicros(quint32 micros) const;
+    void handleWaveform(const ESPSensorFrameParser::Frame& frame);
+
+    // Host edge readings and stall readings come from different frames,
+    // older ones are dropped so timestamps never go back
+    void publishHostReading(double metersPerSecond, qint64 timestampMicros);
+
+private:
+    // Without edges for this long, loco is considered stopped
+    static constexpr double StallMicros = 1000000;
+
     QTcpSocket *mSocket;
     QHostAddress mIPAddress;
-    const int mPort = 1234;
+    quint16 mPort = DefaultPort;
+
+    ESPSensorLineParser mParser;
+    ESPSensorFrameParser mFrameParser;
+    bool mPreferBinary = true;
+    bool mBinaryMode = false;
+    quint64 mReportedLostFrames = 0;
+
+    bool mDebugOutput = false;
+    bool mHostEdgeDetection = false;
+    HallEdgeDetector mEdgeDetector;
+    QVector<HallEdgeDetector::Edge> mEdges;
+    double mMillimetersPerHalfRotation = 0;
+    double mLastEdgeMicros = -1;
+    double mHostTravelled = 0;
+    qint64 mLastHostReadingMicros = -1;
+
+    // Negative until first reading of connection
+    qint64 mLastReadingMillis = -1;
 
     int maxValue = -1;
     int minValue = -1;
@@ -0,0 +1,147 @@
+#include "espsensorframeparser.h"
+
+#include <QtEndian>
+
+#include <cstring>
+
+static float readFloat(const uchar *p)
+{
+    const quint32 bits = qFromLittleEndian<quint32>(p);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+ESPSensorFrameParser::ESPSensorFrameParser()
+{
+
+}
+
+void ESPSensorFrameParser::commitWrite(int size)
+{
+    mSize = qMin(mSize + size, int(BufferSize));
+}
+
+bool ESPSensorFrameParser::nextFrame(Frame &out)
+{
+    while(true)
+    {
+        const int available = mSize - mReadPos;
+        if(available < HeaderSize)
+        {
+            compact();
+            return false;
+        }
+
+        const uchar *frame = reinterpret_cast<const uchar *>(mBuffer + mReadPos);
+
+        const int payload = payloadSize(frame[2]);
+        if(qFromLittleEndian<quint16>(frame) != Magic || payload < 0 || frame[3] != payload)
+        {
+            // Not a frame start, resync on next byte
+            mReadPos++;
+            continue;
+        }
+
+        const int frameSize = HeaderSize + payload + TrailerSize;
+        if(available < frameSize)
+        {
+            compact();
+            return false;
+        }
+
+        const quint16 crc = qFromLittleEndian<quint16>(frame + HeaderSize + payload);
+        if(crc != crc16(frame, HeaderSize + payload))
+        {
+            // Magic may have been inside payload of a corrupted frame
+            mCrcErrors++;
+            mReadPos++;
+            continue;
+        }
+
+        mReadPos += frameSize;
+
+        out.type = FrameType(frame[2]);
+        out.sequence = qFromLittleEndian<quint32>(frame + 4);
+
+        if(mHasSequence && out.sequence != mNextSequence)
+            mLostFrames += quint32(out.sequence - mNextSequence); // Wraps correctly
+        mHasSequence = true;
+        mNextSequence = out.sequence + 1;
+
+        const uchar *data = frame + HeaderSize;
+        switch (out.type)
+        {
+        case FrameType::Reading:
+        {
+            out.timestamp = qFromLittleEndian<quint32>(data);
+            out.halfRotations = qFromLittleEndian<quint32>(data + 4);
+            out.travelledMillimeters = readFloat(data + 8);
+            out.metersPerSecond = readFloat(data + 12);
+            break;
+        }
+        case FrameType::AnalogBlock:
+        {
+            out.firstSampleMicros = qFromLittleEndian<quint32>(data);
+            out.samplePeriodMicros = qFromLittleEndian<quint16>(data + 4);
+            out.sampleCount = qMin(int(qFromLittleEndian<quint16>(data + 6)), MaxAnalogSamples);
+            for(int i = 0; i < out.sampleCount; i++)
+                out.samples[i] = qFromLittleEndian<quint16>(data + 8 + i * 2);
+            break;
+        }
+        }
+
+        return true;
+    }
+}
+
+void ESPSensorFrameParser::clear()
+{
+    mSize = 0;
+    mReadPos = 0;
+    mHasSequence = false;
+    mNextSequence = 0;
+}
+
+quint16 ESPSensorFrameParser::crc16(const uchar *data, int size)
+{
+    // CRC-16/CCITT-FALSE, poly 0x1021
+    static const auto table = []()
+    {
+        struct { quint16 v[256]; } t;
+        for(int i = 0; i < 256; i++)
+        {
+            quint16 crc = quint16(i << 8);
+            for(int bit = 0; bit < 8; bit++)
+                crc = (crc & 0x8000) ? quint16((crc << 1) ^ 0x1021) : quint16(crc << 1);
+            t.v[i] = crc;
+        }
+        return t;
+    }();
+
+    quint16 crc = 0xFFFF;
+    for(int i = 0; i < size; i++)
+        crc = quint16((crc << 8) ^ table.v[((crc >> 8) ^ data[i]) & 0xFF]);
+    return crc;
+}
+
+int ESPSensorFrameParser::payloadSize(quint8 type)
+{
+    switch (FrameType(type))
+    {
+    case FrameType::Reading:
+        return ReadingPayloadSize;
+    case FrameType::AnalogBlock:
+        return AnalogBlockPayloadSize;
+    }
+    return -1;
+}
+
+void ESPSensorFrameParser::compact()
+{
+    const int remaining = mSize - mReadPos;
+    if(remaining > 0 && mReadPos > 0)
+        memmove(mBuffer, mBuffer + mReadPos, remaining);
+    mSize = remaining;
+    mReadPos = 0;
+}
@@ -0,0 +1,95 @@
+#ifndef ESPSENSORFRAMEPARSER_H
+#define ESPSENSORFRAMEPARSER_H
+
+#include <QtGlobal>
+
+// Binary mode of ESP sensor protocol.
+// Host sends "b 1\n", sensor answers "BIN 1\n" and then only sends frames.
+// Sensors without binary support ignore the command and keep sending text.
+//
+// Frames are little endian, fixed size for each type:
+// Header:   u16 magic, u8 type, u8 payload size, u32 sequence number
+// Payload:  see Reading and AnalogBlock below
+// Trailer:  u16 CRC-16/CCITT-FALSE of header and payload
+//
+// Sequence number is incremented for every frame so lost frames can be counted.
+// In binary mode "d\n" enables AnalogBlock frames instead of text debug lines.
+class ESPSensorFrameParser
+{
+public:
+    static constexpr int BufferSize = 4096;
+
+    static constexpr quint16 Magic = 0x5AE5;
+    static constexpr int HeaderSize = 8;
+    static constexpr int TrailerSize = 2;
+
+    static constexpr int MaxAnalogSamples = 32;
+
+    enum class FrameType : quint8
+    {
+        // u32 timestamp ms, u32 half rotations, f32 travelled mm, f32 speed m/s
+        Reading = 1,
+
+        // u32 first sample timestamp us, u16 sample period us, u16 count,
+        // u16 samples[MaxAnalogSamples]
+        AnalogBlock = 2
+    };
+
+    static constexpr int ReadingPayloadSize = 16;
+    static constexpr int AnalogBlockPayloadSize = 8 + MaxAnalogSamples * 2;
+
+    struct Frame
+    {
+        FrameType type = FrameType::Reading;
+        quint32 sequence = 0;
+
+        // Reading
+        quint32 timestamp = 0;
+        quint32 halfRotations = 0;
+        double travelledMillimeters = 0;
+        double metersPerSecond = 0;
+
+        // AnalogBlock
+        quint32 firstSampleMicros = 0;
+        quint16 samplePeriodMicros = 0;
+        int sampleCount = 0;
+        quint16 samples[MaxAnalogSamples];
+    };
+
+    ESPSensorFrameParser();
+
+    // Read at most writeSpace() bytes in writeBuffer() then commitWrite()
+    inline char *writeBuffer() { return mBuffer + mSize; }
+    inline int writeSpace() const { return BufferSize - mSize; }
+    void commitWrite(int size);
+
+    // Returns false when there are no more complete frames
+    bool nextFrame(Frame& out);
+
+    void clear();
+
+    // Frames missing according to sequence numbers
+    inline quint64 lostFrames() const { return mLostFrames; }
+
+    // Frames discarded because of bad CRC
+    inline quint64 crcErrors() const { return mCrcErrors; }
+
+    static quint16 crc16(const uchar *data, int size);
+
+private:
+    static int payloadSize(quint8 type);
+    void compact();
+
+private:
+    char mBuffer[BufferSize];
+    int mSize = 0;
+    int mReadPos = 0;
+
+    bool mHasSequence = false;
+    quint32 mNextSequence = 0;
+
+    quint64 mLostFrames = 0;
+    quint64 mCrcErrors = 0;
+};
+
+#endif // ESPSENSORFRAMEPARSER_H
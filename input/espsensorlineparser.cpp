@@ -0,0 +1,146 @@
+#include "espsensorlineparser.h"
+
+#include <charconv>
+#include <cstring>
+
+#ifndef __cpp_lib_to_chars
+#include <QByteArray>
+#endif
+
+template <typename T>
+static bool parseInteger(const char *first, const char *last, T& out)
+{
+    const auto result = std::from_chars(first, last, out);
+    return result.ec == std::errc() && result.ptr == last;
+}
+
+static bool parseDouble(const char *first, const char *last, double& out)
+{
+#ifdef __cpp_lib_to_chars
+    const auto result = std::from_chars(first, last, out);
+    return result.ec == std::errc() && result.ptr == last;
+#else
+    // Standard library without floating point from_chars, raw data is not copied
+    bool ok = false;
+    out = QByteArray::fromRawData(first, int(last - first)).toDouble(&ok);
+    return ok;
+#endif
+}
+
+ESPSensorLineParser::ESPSensorLineParser()
+{
+
+}
+
+void ESPSensorLineParser::commitWrite(int size)
+{
+    mSize = qMin(mSize + size, int(BufferSize));
+}
+
+bool ESPSensorLineParser::nextRecord(Record &out)
+{
+    while(true)
+    {
+        const char *begin = mBuffer + mReadPos;
+        const char *end = static_cast<const char *>(memchr(begin, '\n', mSize - mReadPos));
+        if(!end)
+        {
+            compact();
+            return false;
+        }
+
+        mReadPos = int(end - mBuffer) + 1;
+
+        if(mSkipToNewLine)
+        {
+            // Tail of an overlong line
+            mSkipToNewLine = false;
+            continue;
+        }
+
+        if(end > begin && end[-1] == '\r')
+            end--;
+
+        out = Record();
+        out.line = begin;
+        out.lineLength = int(end - begin);
+
+        constexpr int MaxTokens = 4;
+        const char *tokens[MaxTokens + 1];
+        const char *tokenEnds[MaxTokens + 1];
+        int tokenCount = 0;
+
+        const char *p = begin;
+        while(p < end && tokenCount <= MaxTokens)
+        {
+            while(p < end && *p == ' ')
+                p++;
+            if(p == end)
+                break;
+
+            tokens[tokenCount] = p;
+            while(p < end && *p != ' ')
+                p++;
+            tokenEnds[tokenCount] = p;
+            tokenCount++;
+        }
+
+        if(tokenCount == 4)
+        {
+            if(parseInteger(tokens[0], tokenEnds[0], out.timestamp)
+                    && parseInteger(tokens[1], tokenEnds[1], out.halfRotations)
+                    && parseDouble(tokens[2], tokenEnds[2], out.travelledMillimeters)
+                    && parseDouble(tokens[3], tokenEnds[3], out.metersPerSecond))
+            {
+                out.type = RecordType::Reading;
+            }
+        }
+        else if(tokenCount == 2 && out.lineLength == 5 && memcmp(begin, "BIN 1", 5) == 0)
+        {
+            out.type = RecordType::BinaryModeAck;
+        }
+        else if(tokenCount == 2)
+        {
+            if(parseInteger(tokens[0], tokenEnds[0], out.halfRotations)
+                    && parseInteger(tokens[1], tokenEnds[1], out.sensorValue))
+            {
+                out.type = RecordType::SensorValue;
+            }
+        }
+
+        return true;
+    }
+}
+
+void ESPSensorLineParser::clear()
+{
+    mSize = 0;
+    mReadPos = 0;
+    mSkipToNewLine = false;
+}
+
+void ESPSensorLineParser::compact()
+{
+    if(mSkipToNewLine)
+    {
+        // Still inside overlong line
+        mSize = 0;
+        mReadPos = 0;
+        return;
+    }
+
+    if(mReadPos == 0 && mSize == BufferSize)
+    {
+        // No new line in whole buffer, drop it
+        mOverlongLines++;
+        mSkipToNewLine = true;
+        mSize = 0;
+        return;
+    }
+
+    const int remaining = mSize - mReadPos;
+    if(remaining > 0 && mReadPos > 0)
+        memmove(mBuffer, mBuffer + mReadPos, remaining);
+    mSize = remaining;
+    mReadPos = 0;
+}
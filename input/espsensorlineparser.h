@@ -0,0 +1,73 @@
+#ifndef ESPSENSORLINEPARSER_H
+#define ESPSENSORLINEPARSER_H
+
+#include <QtGlobal>
+
+// Streaming parser of ESP sensor text protocol.
+// Bytes are read directly in a fixed buffer and lines are tokenized in place,
+// partial lines are kept until next read.
+//
+// "TIMESTAMP HALF_ROTATIONS TRAVELLED_MM SPEED_MPS" is a reading
+// "HALF_ROTATIONS SENSOR_VALUE" is debug output
+// "BIN 1" acknowledges switch to binary mode, see espsensorframeparser.h
+class ESPSensorLineParser
+{
+public:
+    static constexpr int BufferSize = 1024;
+
+    enum class RecordType
+    {
+        Invalid = 0,
+        Reading,
+        SensorValue,
+        BinaryModeAck
+    };
+
+    struct Record
+    {
+        RecordType type = RecordType::Invalid;
+
+        qint64 timestamp = 0;
+        qint64 halfRotations = 0;
+        double travelledMillimeters = 0;
+        double metersPerSecond = 0;
+
+        int sensorValue = 0;
+
+        // Line without terminator, valid until next write
+        const char *line = nullptr;
+        int lineLength = 0;
+    };
+
+    ESPSensorLineParser();
+
+    // Read at most writeSpace() bytes in writeBuffer() then commitWrite()
+    inline char *writeBuffer() { return mBuffer + mSize; }
+    inline int writeSpace() const { return BufferSize - mSize; }
+    void commitWrite(int size);
+
+    // Returns false when there are no more complete lines
+    bool nextRecord(Record& out);
+
+    void clear();
+
+    // Data after last returned line, used when stream switches to binary
+    inline const char *remainingData() const { return mBuffer + mReadPos; }
+    inline int remainingSize() const { return mSize - mReadPos; }
+
+    // Lines longer than buffer, they are discarded
+    inline quint64 overlongLines() const { return mOverlongLines; }
+
+private:
+    void compact();
+
+private:
+    char mBuffer[BufferSize];
+    int mSize = 0;
+    int mReadPos = 0;
+
+    bool mSkipToNewLine = false;
+    quint64 mOverlongLines = 0;
+};
+
+#endif // ESPSENSORLINEPARSER_H
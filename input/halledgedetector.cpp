@@ -0,0 +1,154 @@
+#include "halledgedetector.h"
+
+// Index of first sample outside [lo, hi], count if none.
+// Most samples do not change state, blocks are scanned without
+// branches so compiler can vectorize them
+static int findOutsideRange(const quint16 *samples, int count, quint16 lo, quint16 hi)
+{
+    constexpr int BlockSize = 16;
+
+    int i = 0;
+    for(; i + BlockSize <= count; i += BlockSize)
+    {
+        int outside = 0;
+        for(int j = 0; j < BlockSize; j++)
+            outside |= int(samples[i + j] < lo) | int(samples[i + j] > hi);
+
+        if(outside)
+            break;
+    }
+
+    for(; i < count; i++)
+    {
+        if(samples[i] < lo || samples[i] > hi)
+            return i;
+    }
+
+    return count;
+}
+
+static quint16 clampThreshold(int value)
+{
+    return quint16(qBound(0, value, 0xFFFF));
+}
+
+HallEdgeDetector::HallEdgeDetector()
+{
+
+}
+
+HallEdgeDetector::Thresholds HallEdgeDetector::thresholds() const
+{
+    return mThresholds;
+}
+
+void HallEdgeDetector::setThresholds(const Thresholds &newThresholds)
+{
+    mThresholds = newThresholds;
+}
+
+void HallEdgeDetector::reset()
+{
+    mZone = Pole::None;
+    mLastPole = Pole::None;
+    mHalfRotations = 0;
+    mHasPrevSample = false;
+}
+
+void HallEdgeDetector::process(const quint16 *samples, int count, double firstSampleMicros,
+                               double samplePeriodMicros, QVector<Edge> &out)
+{
+    processImpl(samples, count,
+                [firstSampleMicros, samplePeriodMicros](int i)
+                {
+                    return firstSampleMicros + i * samplePeriodMicros;
+                }, out);
+}
+
+void HallEdgeDetector::process(const quint16 *samples, const double *micros, int count, QVector<Edge> &out)
+{
+    processImpl(samples, count, [micros](int i) { return micros[i]; }, out);
+}
+
+template <typename TimeFn>
+void HallEdgeDetector::processImpl(const quint16 *samples, int count, TimeFn timeAt, QVector<Edge> &out)
+{
+    if(count <= 0)
+        return;
+
+    const quint16 highEnter = clampThreshold(mThresholds.highEnter);
+    const quint16 highExit = clampThreshold(mThresholds.highExit);
+    const quint16 lowEnter = clampThreshold(mThresholds.lowEnter);
+    const quint16 lowExit = clampThreshold(mThresholds.lowExit);
+
+    int i = 0;
+    while(i < count)
+    {
+        // Values which keep current state
+        quint16 lo = 0;
+        quint16 hi = 0xFFFF;
+        switch (mZone)
+        {
+        case Pole::None:
+            lo = highEnter;
+            hi = lowEnter;
+            break;
+        case Pole::High:
+            hi = highExit;
+            break;
+        case Pole::Low:
+            lo = lowExit;
+            break;
+        }
+
+        i += findOutsideRange(samples + i, count - i, lo, hi);
+        if(i == count)
+            break;
+
+        const quint16 value = samples[i];
+
+        if(mZone != Pole::None)
+        {
+            // Left pole zone
+            mZone = Pole::None;
+            i++;
+            continue;
+        }
+
+        const Pole pole = value < highEnter ? Pole::High : Pole::Low;
+        mZone = pole;
+
+        if(pole != mLastPole)
+        {
+            const double t1 = timeAt(i);
+            double t = t1;
+
+            const bool hasPrev = i > 0 || mHasPrevSample;
+            if(hasPrev)
+            {
+                // Linear interpolation of threshold crossing
+                const double v0 = i > 0 ? samples[i - 1] : mPrevSample;
+                const double t0 = i > 0 ? timeAt(i - 1) : mPrevMicros;
+                const double threshold = pole == Pole::High ? highEnter : lowEnter;
+
+                if(v0 != value)
+                {
+                    const double frac = qBound(0.0, (threshold - v0) / (double(value) - v0), 1.0);
+                    t = t0 + frac * (t1 - t0);
+                }
+            }
+
+            if(mLastPole != Pole::None)
+                mHalfRotations++;
+            mLastPole = pole;
+
+            out.append({t, pole});
+        }
+
+        i++;
+    }
+
+    mPrevSample = samples[count - 1];
+    mPrevMicros = timeAt(count - 1);
+    mHasPrevSample = true;
+}
@@ -0,0 +1,71 @@
+#ifndef HALLEDGEDETECTOR_H
+#define HALLEDGEDETECTOR_H
+
+#include <QVector>
+
+// Host side version of ESP sensor threshold logic, runs on raw ADC waveform.
+// Magnet poles move the value in opposite directions:
+// High pole zone is entered below highEnter and left above highExit,
+// Low pole zone is entered above lowEnter and left below lowExit.
+// Entering the zone of the other pole is a half rotation. Edge time is
+// interpolated between the two samples around the enter threshold.
+class HallEdgeDetector
+{
+public:
+    struct Thresholds
+    {
+        int highEnter = 0;
+        int highExit = 0;
+        int lowEnter = 0;
+        int lowExit = 0;
+    };
+
+    enum class Pole
+    {
+        None = 0,
+        High,
+        Low
+    };
+
+    struct Edge
+    {
+        double micros;
+        Pole pole;
+    };
+
+    HallEdgeDetector();
+
+    Thresholds thresholds() const;
+    void setThresholds(const Thresholds& newThresholds);
+
+    // Forget previous samples, keeps thresholds
+    void reset();
+
+    // Equally spaced samples, edges are appended to out.
+    // Consecutive calls continue the same waveform.
+    void process(const quint16 *samples, int count, double firstSampleMicros,
+                 double samplePeriodMicros, QVector<Edge>& out);
+
+    // Samples with their own timestamp, i.e. read from a capture file
+    void process(const quint16 *samples, const double *micros, int count, QVector<Edge>& out);
+
+    // Pole changes since reset, first pole is not counted
+    inline qint64 halfRotations() const { return mHalfRotations; }
+
+private:
+    template <typename TimeFn>
+    void processImpl(const quint16 *samples, int count, TimeFn timeAt, QVector<Edge>& out);
+
+private:
+    Thresholds mThresholds;
+
+    Pole mZone = Pole::None;
+    Pole mLastPole = Pole::None;
+    qint64 mHalfRotations = 0;
+
+    bool mHasPrevSample = false;
+    quint16 mPrevSample = 0;
+    double mPrevMicros = 0;
+};
+
+#endif // HALLEDGEDETECTOR_H
@@ -1,7 +1,50 @@
 #include "ispeedsensor.h"
 
+#include "../utils/monotonicclock.h"
+
 ISpeedSensor::ISpeedSensor(QObject *parent)
     : QObject{parent}
+    , mReadings(ReadingsCapacity)
+    , mWaveform(WaveformCapacity)
+{
+
+}
+
+int ISpeedSensor::takeReadings(SpeedSample *out, int maxCount)
+{
+    return mReadings.take(out, maxCount);
+}
+
+int ISpeedSensor::takeWaveform(WaveformBlock *out, int maxCount)
+{
+    return mWaveform.take(out, maxCount);
+}
+
+quint64 ISpeedSensor::overrunCount() const
+{
+    return mReadings.overruns();
+}
+
+void ISpeedSensor::publishReading(double metersPerSecond, double travelledMillimeters, qint64 timestampMicros)
+{
+    publishReading(metersPerSecond, travelledMillimeters, timestampMicros, monotonicMicros());
+}
+
+void ISpeedSensor::publishReading(double metersPerSecond, double travelledMillimeters, qint64 timestampMicros, qint64 hostMicros)
 {
+    SpeedSample sample;
+    sample.timestampMicros = timestampMicros;
+    sample.hostMicros = hostMicros;
+    sample.metersPerSecond = metersPerSecond;
+    sample.travelledMillimeters = travelledMillimeters;
 
+    if(mReadings.push(sample))
+        emit readingsAvailable();
+}
+
+void ISpeedSensor::publishWaveform(const WaveformBlock &block)
+{
+    // Waveform is best effort, lost blocks are not reported
+    if(mWaveform.push(block))
+        emit waveformAvailable();
 }
@@ -4,15 +4,65 @@
 #include <QObject>
 
 #include "../commandstation/utils.h"
+#include "../utils/spscringbuffer.h"
 
+struct SpeedSample
+{
+    qint64 timestampMicros = 0; // Sensor clock
+    qint64 hostMicros = 0; // When it was received, see monotonicMicros()
+    double metersPerSecond = 0;
+    double travelledMillimeters = 0;
+};
+
+// Equally spaced raw sensor values, same clock as SpeedSample timestamps
+struct WaveformBlock
+{
+    static constexpr int MaxSamples = 32;
+
+    qint64 firstSampleMicros = 0;
+    int samplePeriodMicros = 0;
+    int count = 0;
+    quint16 samples[MaxSamples];
+};
+
+// Readings are published in a lock free ring instead of one signal each.
+// Sensor thread is the only producer, a single consumer drains it
+// when readingsAvailable() is emitted.
+// Sensors which can stream their raw signal also publish waveform blocks.
 class ISpeedSensor : public QObject
 {
     Q_OBJECT
 public:
+    static constexpr int ReadingsCapacity = 4096;
+    static constexpr int WaveformCapacity = 1024;
+
     explicit ISpeedSensor(QObject *parent = nullptr);
 
+    // Consumer side, returns number of samples copied to out.
+    // Keep calling until it returns less than maxCount
+    int takeReadings(SpeedSample *out, int maxCount);
+    int takeWaveform(WaveformBlock *out, int maxCount);
+
+    // Readings dropped because ring was full
+    quint64 overrunCount() const;
+
 signals:
-    void speedReading(double metersPerSecond, double travelledMillimeters, qint64 timestampMilliSec);
+    // Emitted once after consumer drained the ring and new readings arrive
+    void readingsAvailable();
+    void waveformAvailable();
+
+protected:
+    // Producer side, reception is stamped with monotonicMicros()
+    void publishReading(double metersPerSecond, double travelledMillimeters, qint64 timestampMicros);
+
+    // For sensors driven by another clock (i.e. simulation), hostMicros
+    // must be on same scale as monotonicMicros()
+    void publishReading(double metersPerSecond, double travelledMillimeters, qint64 timestampMicros, qint64 hostMicros);
+    void publishWaveform(const WaveformBlock& block);
+
+private:
+    SpscNotifyingRing<SpeedSample> mReadings;
+    SpscNotifyingRing<WaveformBlock> mWaveform;
 };
 
 #endif // ISPEEDSENSOR_H
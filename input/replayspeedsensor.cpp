@@ -0,0 +1,12 @@
+#include "replayspeedsensor.h"
+
+ReplaySpeedSensor::ReplaySpeedSensor(QObject *parent)
+    : ISpeedSensor{parent}
+{
+
+}
+
+void ReplaySpeedSensor::replayReading(double metersPerSecond, double travelledMillimeters, qint64 timestampMicros)
+{
+    publishReading(metersPerSecond, travelledMillimeters, timestampMicros);
+}
@@ -0,0 +1,16 @@
+#ifndef REPLAYSPEEDSENSOR_H
+#define REPLAYSPEEDSENSOR_H
+
+#include "ispeedsensor.h"
+
+// Publishes sensor readings of a recorded run, driven by ReplayEngine
+class ReplaySpeedSensor : public ISpeedSensor
+{
+    Q_OBJECT
+public:
+    explicit ReplaySpeedSensor(QObject *parent = nullptr);
+
+    void replayReading(double metersPerSecond, double travelledMillimeters, qint64 timestampMicros);
+};
+
+#endif // REPLAYSPEEDSENSOR_H
@@ -0,0 +1,12 @@
+#include "simulatedspeedsensor.h"
+
+SimulatedSpeedSensor::SimulatedSpeedSensor(QObject *parent)
+    : ISpeedSensor{parent}
+{
+
+}
+
+void SimulatedSpeedSensor::simulateReading(double metersPerSecond, double travelledMillimeters, qint64 timestampMicros, qint64 hostMicros)
+{
+    publishReading(metersPerSecond, travelledMillimeters, timestampMicros, hostMicros);
+}
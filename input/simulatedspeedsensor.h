@@ -0,0 +1,17 @@
+#ifndef SIMULATEDSPEEDSENSOR_H
+#define SIMULATEDSPEEDSENSOR_H
+
+#include "ispeedsensor.h"
+
+// Publishes hall edge readings of a virtual locomotive, driven by LayoutSimulator
+class SimulatedSpeedSensor : public ISpeedSensor
+{
+    Q_OBJECT
+public:
+    explicit SimulatedSpeedSensor(QObject *parent = nullptr);
+
+    // Stamped with simulation clock instead of host clock, like command feedback
+    void simulateReading(double metersPerSecond, double travelledMillimeters, qint64 timestampMicros, qint64 hostMicros);
+};
+
+#endif // SIMULATEDSPEEDSENSOR_H
@@ -11,31 +11,35 @@ public:
     MockSeries(QObject *parent = nullptr) : IDataSeries(parent) {}
 
     DataSeriesType getType() const override { return DataSeriesType::Unknown; };
-    int getPointCount() const override { return mPoints.size(); };
-    QPointF getPointAt(int index) const override { return mPoints.value(index, QPointF()); };
+    int getPointCount() const override { return mPoints.count(); };
+    QPointF getPointAt(int index) const override { return mPoints.value(index); };
+    DataSeriesSpan getSpan(int first, int count) const override { return mPoints.span(first, count); };
     QString getPointTooltip(int index) const override { return QString(); };
 
 
     void addPoint(int index, const QPointF& p)
     {
-        mPoints.insert(index, p);
-        emit pointAdded(index, p);
+        mPoints.insert(index, p.x(), p.y());
+        if(index == mPoints.count() - 1)
+            notifyPointsAppended(index, 1);
+        else
+            notifyReset();
     }
 
     void updatePoint(int index, const QPointF& p)
     {
-        mPoints[index] = p;
-        emit pointChanged(index, p);
+        mPoints.replace(index, p.x(), p.y());
+        notifyPointsChanged(index, 1);
     }
 
     void removePoint(int index)
     {
-        mPoints.removeAt(index);
-        emit pointRemoved(index);
+        mPoints.remove(index);
+        notifyPointsRemoved(index, 1);
     }
 
 private:
-    QVector<QPointF> mPoints;
+    DataSeriesStorage mPoints;
 };
 
 void printSeries(IDataSeries *s)
@@ -53,7 +57,7 @@ int main(int argc, char *argv[])
 {
     // MockSeries mock;
 
-    // MovingAverageSeries avg(3);
+    // MovingAverageSeries avg(3, MovingAverageSeries::Alignment::Centered);
     // avg.setSource(&mock);
 
     // mock.addPoint(0, {0, 1});
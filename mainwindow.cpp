@@ -2,6 +2,8 @@
 #include "./ui_mainwindow.h"
 
 #include "recorder/recordingmanager.h"
+#include "recorder/recordingsessionmanager.h"
+#include "recorder/seriessnapshothub.h"
 #include "view/locomotiverecordingview.h"
 
 #include "view/locospeedcurveview.h"
@@ -11,16 +13,34 @@
 #include "commandstation/dummycommandstation.h"
 #include "input/espanaloghallsensor.h"
 #include "commandstation/backends/z21commandstation.h"
+#include "commandstation/commandscheduler.h"
 
 #include "input/espanaloghallconfigwidget.h"
 
+#include "recorder/replayengine.h"
+#include "input/replayspeedsensor.h"
+#include "commandstation/replaycommandstation.h"
+
+#include "simulation/layoutsimulator.h"
+#include "input/simulatedspeedsensor.h"
+#include "commandstation/simulatedcommandstation.h"
+
 #include <QHBoxLayout>
 
 #include <QTabWidget>
 #include <QLabel>
 
+#include <QThread>
+
 #include <QPointer>
 #include <QInputDialog>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QFileInfo>
+#include <QLineEdit>
+#include <QHostAddress>
+
+#include <QDebug>
 
 #include "view/traintab.h"
 #include "train/locomotivepool.h"
@@ -32,6 +52,17 @@
 #include "recorder/series/requestedspeedstepseries.h"
 #include "recorder/series/sensortravelleddistanceseries.h"
 
+// Each section records to its own file, next to the first one
+static QString sectionFileName(const QString& fileName, int address)
+{
+    if(fileName.isEmpty())
+        return fileName;
+
+    QFileInfo info(fileName);
+    return info.path() + QLatin1String("/") + info.completeBaseName()
+            + QLatin1String("_loco%1.").arg(address) + info.suffix();
+}
+
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
@@ -41,13 +72,54 @@ MainWindow::MainWindow(QWidget *parent)
     testStatusLabel = new QLabel(this);
     statusBar()->addPermanentWidget(testStatusLabel);
 
-    mSpeedSensor = new ESPAnalogHallSensor(this);
-    // mSpeedSensor = new DummySpeedSensor(this);
+    mAcquisitionThread = new QThread(this);
+    mAcquisitionThread->setObjectName("Acquisition");
+
+    mAnalysisThread = new QThread(this);
+    mAnalysisThread->setObjectName("Analysis");
+
+    // No parent, they get moved to acquisition thread
+    // mSpeedSensor = new DummySpeedSensor;
     // mCommandStation = new DummyCommandStation;
-    mCommandStation = new Z21CommandStation(this);
+
+    const QString simulateLayout = qEnvironmentVariable("MSR_SIMULATE_LAYOUT");
+    if(!simulateLayout.isEmpty())
+    {
+        // Value is address of locomotive on sensor
+        mLayoutSimulator = new LayoutSimulator;
+        const int sensorAddress = simulateLayout.toInt();
+        if(sensorAddress > 0)
+            mLayoutSimulator->setSensorAddress(sensorAddress);
+
+        mCommandStation = mLayoutSimulator->commandStation();
+        mRecordingSensor = mLayoutSimulator->speedSensor();
+    }
+    else
+    {
+        mSpeedSensor = new ESPAnalogHallSensor;
+        mRecordingSensor = mSpeedSensor;
+
+        Z21CommandStation *z21 = new Z21CommandStation;
+        const QString z21Station = qEnvironmentVariable("MSR_Z21_STATION");
+        if(!z21Station.isEmpty())
+        {
+            // i.e. msr-z21sim on 127.0.0.1, any free local port
+            z21->setStationAddress(QHostAddress(z21Station), 21105);
+            z21->bind(QHostAddress::AnyIPv4, 0);
+        }
+        else
+        {
+            z21->bind(QHostAddress("192.168.1.196"), 21105);
+        }
+        mCommandStation = z21;
+    }
+
+    // Train ramps go through scheduler, recording talks to station directly
+    mCommandScheduler = new CommandScheduler;
+    mCommandScheduler->setCommandStation(mCommandStation);
 
     LocomotivePool *mPool = new LocomotivePool(this);
-    mPool->setCommandStation(mCommandStation);
+    mPool->setCommandStation(mCommandScheduler);
 
     mRecView = new LocomotiveRecordingView;
     mSpeedCurveView = new LocoSpeedCurveView;
@@ -70,23 +142,23 @@ MainWindow::MainWindow(QWidget *parent)
     TrainTab *trainTab = new TrainTab(mPool);
     mTabWidget->addTab(trainTab, tr("Train"));
 
-    ESPAnalogHallConfigWidget *mConfig = new ESPAnalogHallConfigWidget;
-    mConfig->setSensor(mSpeedSensor);
-    mTabWidget->addTab(mConfig, tr("ESP Sensor"));
-
-    mRecManager = new RecordingManager(this);
+    if(mSpeedSensor)
+    {
+        ESPAnalogHallConfigWidget *mConfig = new ESPAnalogHallConfigWidget;
+        mConfig->setSensor(mSpeedSensor);
+        mTabWidget->addTab(mConfig, tr("ESP Sensor"));
+    }
 
-    // connect(mCommandStation, &DummyCommandStation::locomotiveSpeedFeedback, mSpeedSensor,
-    //         [this](int /*address*/, int speedStep)
-    //         {
-    //             mSpeedSensor->simulateSpeedStep(speedStep);
-    //         });
+    mRecManager = new RecordingManager;
 
     mRecManager->setCommandStation(mCommandStation);
-    mRecManager->setSpeedSensor(mSpeedSensor);
+    mRecManager->setSpeedSensor(mRecordingSensor);
+
+    // Hub must see series before RecordingManager leaves GUI thread
+    mSeriesHub = new SeriesSnapshotHub(mRecManager, this);
 
-    mRecView->setRecMgr(mRecManager);
-    mSpeedCurveView->setRecMgr(mRecManager);
+    mRecView->setSeriesHub(mSeriesHub);
+    mSpeedCurveView->setSeriesHub(mSeriesHub);
     //mSpeedCurveView->setSpeedCurve(mSpeedCurve);
 
     // Sync label with intial state
@@ -95,31 +167,73 @@ MainWindow::MainWindow(QWidget *parent)
     connect(mRecManager, &RecordingManager::stateChanged,
             this, &MainWindow::onRecMgrStateChanged);
 
+    // First section, more can be added later
+    mSessionManager = new RecordingSessionManager;
+    mSessionManager->setCommandStation(mCommandStation);
+    mSessionManager->addSession(mRecManager);
+
+    mCommandScheduler->moveToThread(mAcquisitionThread);
+
+    if(mLayoutSimulator)
+    {
+        // Owns its sensor and command station
+        // Simulated layout has a single sensor, no other sections
+        ui->actionAdd_Measuring_Section->setEnabled(false);
+        mLayoutSimulator->moveToThread(mAcquisitionThread);
+        connect(mAcquisitionThread, &QThread::finished, mLayoutSimulator, &QObject::deleteLater);
+        QMetaObject::invokeMethod(mLayoutSimulator, &LayoutSimulator::start, Qt::QueuedConnection);
+    }
+    else
+    {
+        mSpeedSensor->moveToThread(mAcquisitionThread);
+        connect(mAcquisitionThread, &QThread::finished, mSpeedSensor, &QObject::deleteLater);
+
+        mCommandStation->moveToThread(mAcquisitionThread);
+        connect(mAcquisitionThread, &QThread::finished, mCommandStation, &QObject::deleteLater);
+    }
+
+    connect(mAcquisitionThread, &QThread::finished, mCommandScheduler, &QObject::deleteLater);
+
+    mRecManager->moveToThread(mAnalysisThread);
+    connect(mAnalysisThread, &QThread::finished, mRecManager, &QObject::deleteLater);
+
+    mSessionManager->moveToThread(mAnalysisThread);
+    connect(mAnalysisThread, &QThread::finished, mSessionManager, &QObject::deleteLater);
+
+    mAcquisitionThread->start();
+    mAnalysisThread->start();
+
     connect(ui->actionStart, &QAction::triggered,
             this, &MainWindow::startTest);
 
+    connect(ui->actionReplay_Capture, &QAction::triggered,
+            this, &MainWindow::replayCapture);
+
+    connect(ui->actionAdd_Measuring_Section, &QAction::triggered,
+            this, &MainWindow::addMeasuringSection);
+
     connect(ui->actionStop, &QAction::triggered, this,
             [this]()
             {
-                mRecManager->stop();
+                QMetaObject::invokeMethod(mSessionManager, &RecordingSessionManager::stopAll);
             });
 
     connect(ui->actionNext_Step, &QAction::triggered, this,
             [this]()
             {
-                mRecManager->goToNextStep();
+                QMetaObject::invokeMethod(mRecManager, [this]() { mRecManager->goToNextStep(); });
             });
 
     connect(ui->actionOther_5_seconds, &QAction::triggered, this,
             [this]()
             {
-                mRecManager->setCustomTimeForCurrentStep(5000);
+                QMetaObject::invokeMethod(mRecManager, [this]() { mRecManager->setCustomTimeForCurrentStep(5000); });
             });
 
     connect(ui->actionEmergency_Stop, &QAction::triggered, this,
             [this]()
             {
-                mRecManager->emergencyStop();
+                QMetaObject::invokeMethod(mSessionManager, &RecordingSessionManager::emergencyStopAll);
                 //mSpeedSensor->stop();
             });
 
@@ -130,12 +244,27 @@ MainWindow::MainWindow(QWidget *parent)
         if(name.isEmpty())
             return;
 
-        int windowSz = QInputDialog::getInt(this, tr("Moving Average"), tr("Window size:"), 0, 1, 100, 2);
+        int windowSz = QInputDialog::getInt(this, tr("Moving Average"), tr("Window size:"), 0, 1, 100, 1);
+
+        const QStringList alignments = {tr("Centered"), tr("Trailing (live)")};
+        bool ok = false;
+        QString alignStr = QInputDialog::getItem(this, tr("Moving Average"), tr("Window alignment:"),
+                                                 alignments, 0, false, &ok);
+        if(!ok)
+            return;
 
-        MovingAverageSeries *mv = new MovingAverageSeries(windowSz, mRecManager);
-        mv->setName(name);
-        mv->setSource(mRecManager->rawSensorSeries());
-        mRecManager->registerSeries(mv);
+        MovingAverageSeries::Alignment alignment = MovingAverageSeries::Alignment::Centered;
+        if(alignStr == alignments.at(1))
+            alignment = MovingAverageSeries::Alignment::Trailing;
+
+        // Series must be created in RecordingManager thread
+        QMetaObject::invokeMethod(mRecManager, [this, name, windowSz, alignment]()
+        {
+            MovingAverageSeries *mv = new MovingAverageSeries(windowSz, alignment, mRecManager);
+            mv->setName(name);
+            mv->setSource(mRecManager->rawSensorSeries());
+            mRecManager->registerSeries(mv);
+        });
     });
 
     connect(ui->actionAdd_Total_Average, &QAction::triggered, this,
@@ -147,64 +276,311 @@ MainWindow::MainWindow(QWidget *parent)
 
         int accelMillis = QInputDialog::getInt(this, tr("Total Step Average"), tr("Acceleration Millis:"), 1000, 0, 10000, 100);
 
-        TotalStepAverageSeries *s = new TotalStepAverageSeries(mRecManager);
-        s->setName(name);
-        s->setAccelerationMilliseconds(accelMillis);
-        s->setTravelledSource(mRecManager->sensorTravelledSeries());
-        s->setRecvStepSeries(mRecManager->recvStepSeries());
-        s->setReqStepSeries(mRecManager->reqStepSeries());
-        mRecManager->registerSeries(s);
+        QMetaObject::invokeMethod(mRecManager, [this, name, accelMillis]()
+        {
+            TotalStepAverageSeries *s = new TotalStepAverageSeries(mRecManager);
+            s->setName(name);
+            s->setAccelerationMilliseconds(accelMillis);
+            s->setTravelledSource(mRecManager->sensorTravelledSeries());
+            s->setRecvStepSeries(mRecManager->recvStepSeries());
+            s->setReqStepSeries(mRecManager->reqStepSeries());
+            mRecManager->registerSeries(s);
+        });
     });
 }
 
 MainWindow::~MainWindow()
 {
+    // RecordingManager stops locomotive on destruction
+    // so command station must still be running
+    mAnalysisThread->quit();
+    mAnalysisThread->wait();
+
+    mAcquisitionThread->quit();
+    mAcquisitionThread->wait();
+
     delete ui;
 }
 
 void MainWindow::startTest()
 {
+    int address = 0;
+    int stepTime = 0;
+    int startStep = 0;
+    QString captureFile;
+    bool adaptive = false;
+    int maxStepTime = 0;
+    double tolerance = 0;
+    bool sparse = false;
+    int stride = 0;
+    QString mappingFile;
+    bool bidirectional = false;
+    int blockSize = 0;
+
+    QMetaObject::invokeMethod(mRecManager, [&]()
+    {
+        address = mRecManager->getLocomotiveDCCAddress();
+        stepTime = mRecManager->defaultStepTimeMillis();
+        startStep = mRecManager->startingDCCStep();
+        captureFile = mRecManager->captureFileName();
+        adaptive = mRecManager->adaptiveStepTime();
+        maxStepTime = mRecManager->maxStepTimeMillis();
+        tolerance = mRecManager->steadySpeedTolerance();
+        sparse = mRecManager->sparseSweep();
+        stride = mRecManager->sweepPlanner()->coarseStride();
+        mappingFile = mRecManager->speedMappingFileName();
+        bidirectional = mRecManager->bidirectional();
+        blockSize = mRecManager->directionBlockSize();
+    }, Qt::BlockingQueuedConnection);
+
     QPointer<StartTestDlg> dlg = new StartTestDlg(this);
-    dlg->setLocoAddress(mRecManager->getLocomotiveDCCAddress());
-    dlg->setDefaultStepTime(mRecManager->defaultStepTimeMillis());
-    dlg->setStartingDCCStep(mRecManager->startingDCCStep());
+    dlg->setLocoAddress(address);
+    dlg->setDefaultStepTime(stepTime);
+    dlg->setStartingDCCStep(startStep);
+    dlg->setCaptureFile(captureFile);
+    dlg->setAdaptiveStepTime(adaptive);
+    dlg->setMaxStepTime(maxStepTime);
+    dlg->setSteadyTolerance(tolerance);
+    dlg->setSparseSweep(sparse);
+    dlg->setCoarseStride(stride);
+    dlg->setSpeedMappingFile(mappingFile);
+    dlg->setBidirectional(bidirectional);
+    dlg->setDirectionBlockSize(blockSize);
 
     if(dlg->exec() != QDialog::Accepted || !dlg)
         return;
 
-    mRecManager->setLocomotiveDCCAddress(dlg->getLocoAddress());
-    mRecManager->setDefaultStepTimeMillis(dlg->getDefaultStepTime());
-    mRecManager->setStartingDCCStep(dlg->getStartingDCCStep());
+    address = dlg->getLocoAddress();
+    stepTime = dlg->getDefaultStepTime();
+    startStep = dlg->getStartingDCCStep();
+    captureFile = dlg->getCaptureFile();
+    adaptive = dlg->getAdaptiveStepTime();
+    maxStepTime = dlg->getMaxStepTime();
+    tolerance = dlg->getSteadyTolerance();
+    sparse = dlg->getSparseSweep();
+    stride = dlg->getCoarseStride();
+    mappingFile = dlg->getSpeedMappingFile();
+    bidirectional = dlg->getBidirectional();
+    blockSize = dlg->getDirectionBlockSize();
 
-    mSpeedSensor->resetTravelledCount();
+    delete dlg;
+
+    // Capture writer never overwrites, ask here
+    if(!captureFile.isEmpty() && QFileInfo::exists(captureFile))
+    {
+        const auto ret = QMessageBox::question(this, tr("Start Test"),
+                                               tr("Capture file %1 already exists.\nOverwrite it?").arg(captureFile));
+        if(ret != QMessageBox::Yes)
+            return;
+
+        if(!QFile::remove(captureFile))
+        {
+            QMessageBox::warning(this, tr("Start Test"), tr("Cannot remove %1").arg(captureFile));
+            return;
+        }
+    }
+
+    if(mSpeedSensor)
+        mSpeedSensor->resetTravelledCount();
 
     //mSpeedSensor->start();
-    bool started = mRecManager->start();
+    QMetaObject::invokeMethod(mSessionManager, [=]()
+    {
+        mRecManager->setLocomotiveDCCAddress(address);
+
+        // Other sections keep their locomotive but follow same test plan
+        for(RecordingManager *session : mSessionManager->sessions())
+        {
+            const int sessionAddress = session->getLocomotiveDCCAddress();
+            const bool isFirst = session == mRecManager;
+
+            session->setDefaultStepTimeMillis(stepTime);
+            session->setStartingDCCStep(startStep);
+            session->setCaptureFileName(isFirst ? captureFile : sectionFileName(captureFile, sessionAddress));
+            session->setAdaptiveStepTime(adaptive);
+            session->setMaxStepTimeMillis(maxStepTime);
+            session->setSteadySpeedTolerance(tolerance);
+            session->setSparseSweep(sparse);
+            session->sweepPlanner()->setCoarseStride(stride);
+            session->setSpeedMappingFileName(isFirst ? mappingFile : sectionFileName(mappingFile, sessionAddress));
+            session->setBidirectional(bidirectional);
+            session->setDirectionBlockSize(blockSize);
+        }
+
+        if(!mSessionManager->startAll())
+            qWarning() << "Not all sections were started";
+    });
+}
 
+void MainWindow::addMeasuringSection()
+{
+    if(mRecState != int(RecordingManager::State::Stopped))
+        return;
 
-    // if(started)
-    // {
-    //     mSpeedCurveView->setTargedSpeedCurve(mSpeedSensor->speedCurve());
-    // }
-    // else
-    // {
-    //     mSpeedSensor->stop();
-    // }
+    bool ok = false;
+    const int address = QInputDialog::getInt(this, tr("Add Measuring Section"), tr("Loco Address:"),
+                                             3, 1, 9999, 1, &ok);
+    if(!ok)
+        return;
 
-    delete dlg;
+    // Each section has its own ESP sensor
+    const QString addressStr = QInputDialog::getText(this, tr("Add Measuring Section"), tr("Sensor Address:"),
+                                                     QLineEdit::Normal,
+                                                     QLatin1String(ESPAnalogHallSensor::DefaultAddress), &ok);
+    if(!ok)
+        return;
+
+    QHostAddress sensorAddress;
+    quint16 sensorPort = ESPAnalogHallSensor::DefaultPort;
+    const QStringList addressParts = addressStr.trimmed().split(QLatin1Char(':'));
+    if(addressParts.size() == 2)
+        sensorPort = addressParts.at(1).toUShort(&ok);
+    if(addressParts.size() > 2 || !ok || sensorPort == 0 || !sensorAddress.setAddress(addressParts.first()))
+    {
+        QMessageBox::warning(this, tr("Add Measuring Section"), tr("Invalid sensor address: %1").arg(addressStr));
+        return;
+    }
+
+    mSectionCount++;
+
+    // No parent, they get moved to their threads
+    ESPAnalogHallSensor *sensor = new ESPAnalogHallSensor;
+    RecordingManager *session = new RecordingManager;
+    session->setLocomotiveDCCAddress(address);
+    session->setSpeedSensor(sensor);
+
+    SeriesSnapshotHub *hub = new SeriesSnapshotHub(session, this);
+
+    LocomotiveRecordingView *view = new LocomotiveRecordingView;
+    view->setSeriesHub(hub);
+    mTabWidget->addTab(view, tr("Section %1 (Loco %2)").arg(mSectionCount).arg(address));
+
+    ESPAnalogHallConfigWidget *config = new ESPAnalogHallConfigWidget;
+    config->setSensor(sensor);
+    config->setSensorAddress(sensorAddress, sensorPort);
+    mTabWidget->addTab(config, tr("ESP Sensor %1 (%2)").arg(mSectionCount).arg(sensorAddress.toString()));
+
+    sensor->moveToThread(mAcquisitionThread);
+    connect(mAcquisitionThread, &QThread::finished, sensor, &QObject::deleteLater);
+
+    session->moveToThread(mAnalysisThread);
+    connect(mAnalysisThread, &QThread::finished, session, &QObject::deleteLater);
+
+    QMetaObject::invokeMethod(mSessionManager, [this, session]()
+    {
+        if(!mSessionManager->addSession(session))
+            qWarning() << "Section not added, locomotive is already recorded";
+    });
+}
+
+void MainWindow::replayCapture()
+{
+    if(mReplay || mRecState != int(RecordingManager::State::Stopped))
+        return;
+
+    int address = 0;
+    QString captureFile;
+
+    QMetaObject::invokeMethod(mRecManager, [&]()
+    {
+        address = mRecManager->getLocomotiveDCCAddress();
+        captureFile = mRecManager->captureFileName();
+    }, Qt::BlockingQueuedConnection);
+
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Replay Run Capture"),
+                                                    captureFile,
+                                                    tr("Run Capture (*.msrcap)"));
+    if(fileName.isEmpty())
+        return;
+
+    bool ok = false;
+    address = QInputDialog::getInt(this, tr("Replay Run Capture"), tr("Loco Address:"),
+                                   address, 1, 9999, 1, &ok);
+    if(!ok)
+        return;
+
+    const QStringList pacings = {tr("Real time"), tr("2x"), tr("10x"), tr("As fast as possible")};
+    QString pacingStr = QInputDialog::getItem(this, tr("Replay Run Capture"), tr("Speed:"),
+                                              pacings, 0, false, &ok);
+    if(!ok)
+        return;
+
+    // No parent, it gets moved to analysis thread
+    ReplayEngine *engine = new ReplayEngine;
+    if(!engine->open(fileName))
+    {
+        QMessageBox::warning(this, tr("Cannot Replay Capture"), engine->errorString());
+        delete engine;
+        return;
+    }
+
+    switch (pacings.indexOf(pacingStr))
+    {
+    case 1:
+        engine->setPacing(ReplayEngine::Pacing::Scaled, 2);
+        break;
+    case 2:
+        engine->setPacing(ReplayEngine::Pacing::Scaled, 10);
+        break;
+    case 3:
+        engine->setPacing(ReplayEngine::Pacing::AsFastAsPossible);
+        break;
+    default:
+        engine->setPacing(ReplayEngine::Pacing::RealTime);
+        break;
+    }
+
+    mReplay = engine;
+    mReplay->moveToThread(mAnalysisThread);
+    connect(mAnalysisThread, &QThread::finished, mReplay, &QObject::deleteLater);
+
+    QMetaObject::invokeMethod(mRecManager, [this, engine, address]()
+    {
+        mRecManager->setLocomotiveDCCAddress(address);
+        mRecManager->setSpeedSensor(engine->speedSensor());
+        mRecManager->setCommandStation(engine->commandStation());
+        mRecManager->setReplayEngine(engine);
+
+        if(!mRecManager->start())
+            QMetaObject::invokeMethod(this, &MainWindow::endReplay);
+    });
 }
 
-void MainWindow::onRecMgrStateChanged(int /*newState*/)
+void MainWindow::endReplay()
 {
+    if(!mReplay)
+        return;
+
+    // Restore real devices
+    QMetaObject::invokeMethod(mRecManager, [this]()
+    {
+        mRecManager->setReplayEngine(nullptr);
+        mRecManager->setSpeedSensor(mRecordingSensor);
+        mRecManager->setCommandStation(mCommandStation);
+    });
+
+    // Queued after restore, engine is not used anymore
+    mReplay->deleteLater();
+    mReplay = nullptr;
+}
+
+void MainWindow::onRecMgrStateChanged(int newState)
+{
+    // Queued from analysis thread, do not query RecordingManager directly
+    mRecState = newState;
+
+    if(mReplay && newState == int(RecordingManager::State::Stopped))
+        endReplay();
+
     QString stateName;
 
-    switch(mRecManager->state())
+    switch(RecordingManager::State(newState))
     {
     case RecordingManager::State::Stopped:
         stateName = tr("Test Stopped");
         break;
     case RecordingManager::State::Running:
-        stateName = tr("Test RUNNING");
+        stateName = mReplay ? tr("Replaying Capture") : tr("Test RUNNING");
         break;
     case RecordingManager::State::WaitingToStop:
         stateName = tr("Stopping Test...");
@@ -213,6 +589,6 @@ void MainWindow::onRecMgrStateChanged(int /*newState*/)
 
     testStatusLabel->setText(stateName);
 
-    // if(mRecManager->state() == RecordingManager::State::Stopped)
+    // if(newState == int(RecordingManager::State::Stopped))
     //     mSpeedSensor->stop();
 }
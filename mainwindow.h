@@ -8,15 +8,22 @@ namespace Ui { class MainWindow; }
 QT_END_NAMESPACE
 
 class RecordingManager;
+class RecordingSessionManager;
+class SeriesSnapshotHub;
 class LocomotiveRecordingView;
 
 class LocoSpeedCurveView;
 
 class DummySpeedSensor;
 class ESPAnalogHallSensor;
+class ISpeedSensor;
 class ICommandStation;
+class CommandScheduler;
+class ReplayEngine;
+class LayoutSimulator;
 
 class QTabWidget;
+class QThread;
 
 class QLabel;
 
@@ -30,20 +37,42 @@ public:
 
 private slots:
     void startTest();
+    void replayCapture();
+    void addMeasuringSection();
     void onRecMgrStateChanged(int newState);
 
+private:
+    void endReplay();
+
 private:
     Ui::MainWindow *ui;
 
+    // Sensor and command station sockets
+    QThread *mAcquisitionThread;
+
+    // RecordingManager and its series
+    QThread *mAnalysisThread;
+
     LocomotiveRecordingView *mRecView;
     RecordingManager *mRecManager;
+    RecordingSessionManager *mSessionManager;
+    int mSectionCount = 1;
+    SeriesSnapshotHub *mSeriesHub;
+    int mRecState = 0;
 
     LocoSpeedCurveView *mSpeedCurveView;
 
-    ESPAnalogHallSensor *mSpeedSensor;
+    ESPAnalogHallSensor *mSpeedSensor = nullptr;
     // DummySpeedSensor *mSpeedSensor;
     ICommandStation *mCommandStation;
 
+    // Sensor used for recording, ESP or simulated one
+    ISpeedSensor *mRecordingSensor;
+    LayoutSimulator *mLayoutSimulator = nullptr;
+    CommandScheduler *mCommandScheduler;
+
+    ReplayEngine *mReplay = nullptr;
+
     QTabWidget *mTabWidget;
 
     QLabel *testStatusLabel;
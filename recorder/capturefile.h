@@ -0,0 +1,97 @@
+#ifndef CAPTUREFILE_H
+#define CAPTUREFILE_H
+
+#include <QtGlobal>
+
+// Binary run capture layout, all values little endian:
+//
+//   FileHeader
+//   ChunkHeader + payload, repeated (append only)
+//   FooterHeader + IndexEntry for each chunk
+//   Trailer
+//
+// Chunk payload is column major: "count" doubles for each column.
+// Column 0 is always time in seconds since run start.
+// If the file was not closed properly the footer is missing,
+// chunks can still be found by walking chunk headers.
+
+namespace CaptureFile {
+
+constexpr quint32 Version = 1;
+
+constexpr char HeaderMagic[8] = {'M', 'S', 'R', 'C', 'A', 'P', 'T', '1'};
+constexpr char TrailerMagic[8] = {'M', 'S', 'R', 'C', 'E', 'N', 'D', '1'};
+
+constexpr quint32 ChunkMagic = 0x4B4E4843;  // "CHNK"
+constexpr quint32 FooterMagic = 0x58444E49; // "INDX"
+
+// Rows buffered before a chunk is written
+constexpr int ChunkRows = 4096;
+
+enum Stream : quint16
+{
+    RawSpeed = 0,       // time, meters per second
+    TravelledDistance,  // time, millimeters
+    RequestedStep,      // time, step
+    ReceivedStep,       // time, step
+    LocoFeedback,       // time, address, step, direction
+    HallWaveform,       // time, raw sensor value
+    NStreams
+};
+
+constexpr quint16 columnsForStream(quint16 stream)
+{
+    return stream == LocoFeedback ? 4 : 2;
+}
+
+struct FileHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 headerSize;
+    qint64 startTimestampMs; // Wall clock, only for display
+    quint32 flags;
+    quint32 reserved;
+};
+
+struct ChunkHeader
+{
+    quint32 magic;
+    quint16 stream;
+    quint16 columns;
+    quint32 count;
+    quint32 reserved;
+};
+
+struct FooterHeader
+{
+    quint32 magic;
+    quint32 entryCount;
+};
+
+struct IndexEntry
+{
+    qint64 offset; // Of ChunkHeader
+    quint16 stream;
+    quint16 columns;
+    quint32 count;
+    double firstTime;
+    double lastTime;
+};
+
+struct Trailer
+{
+    qint64 footerOffset;
+    char magic[8];
+};
+
+// Keep payload doubles 8 byte aligned
+static_assert(sizeof(FileHeader) == 32, "FileHeader size");
+static_assert(sizeof(ChunkHeader) == 16, "ChunkHeader size");
+static_assert(sizeof(FooterHeader) == 8, "FooterHeader size");
+static_assert(sizeof(IndexEntry) == 32, "IndexEntry size");
+static_assert(sizeof(Trailer) == 16, "Trailer size");
+
+} // namespace CaptureFile
+
+#endif // CAPTUREFILE_H
@@ -0,0 +1,237 @@
+#include "capturereader.h"
+
+#include "series/capturedseries.h"
+
+#include <cstring>
+
+using namespace CaptureFile;
+
+CaptureReader::CaptureReader()
+{
+
+}
+
+CaptureReader::~CaptureReader()
+{
+    close();
+}
+
+bool CaptureReader::open(const QString &fileName)
+{
+    close();
+
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    // Doubles are used directly from mapped memory
+    mErrorString = QLatin1String("Capture files are not supported on big endian hosts");
+    return false;
+#endif
+
+    mFile.setFileName(fileName);
+    if(!mFile.open(QFile::ReadOnly))
+    {
+        mErrorString = mFile.errorString();
+        return false;
+    }
+
+    mSize = mFile.size();
+    if(mSize < qint64(sizeof(FileHeader)))
+    {
+        mErrorString = QLatin1String("File too small");
+        close();
+        return false;
+    }
+
+    mData = mFile.map(0, mSize);
+    if(!mData)
+    {
+        mErrorString = mFile.errorString();
+        close();
+        return false;
+    }
+
+    FileHeader header;
+    memcpy(&header, mData, sizeof(header));
+    if(memcmp(header.magic, HeaderMagic, sizeof(header.magic)) != 0 || header.version != Version)
+    {
+        mErrorString = QLatin1String("Not a capture file or unsupported version");
+        close();
+        return false;
+    }
+
+    if(!readIndex())
+    {
+        // File was not closed properly, walk chunks instead
+        mChunks.clear();
+        mRecovered = true;
+        scanChunks();
+    }
+
+    return true;
+}
+
+void CaptureReader::close()
+{
+    mChunks.clear();
+
+    if(mData)
+    {
+        mFile.unmap(mData);
+        mData = nullptr;
+    }
+
+    mFile.close();
+    mSize = 0;
+    mRecovered = false;
+}
+
+QString CaptureReader::errorString() const
+{
+    return mErrorString;
+}
+
+qint64 CaptureReader::startTimestampMs() const
+{
+    if(!mData)
+        return 0;
+
+    FileHeader header;
+    memcpy(&header, mData, sizeof(header));
+    return header.startTimestampMs;
+}
+
+QVector<CaptureReader::Chunk> CaptureReader::chunks(Stream stream) const
+{
+    QVector<Chunk> result;
+    for(const Chunk& chunk : mChunks)
+    {
+        if(chunk.stream == stream)
+            result.append(chunk);
+    }
+    return result;
+}
+
+int CaptureReader::pointCount(Stream stream) const
+{
+    int count = 0;
+    for(const Chunk& chunk : mChunks)
+    {
+        if(chunk.stream == stream)
+            count += chunk.count;
+    }
+    return count;
+}
+
+CapturedSeries *CaptureReader::createSeries(Stream stream, int column, QObject *parent) const
+{
+    DataSeriesType type = DataSeriesType::Unknown;
+    switch (stream)
+    {
+    case CaptureFile::RawSpeed:
+        type = DataSeriesType::SensorRawData;
+        break;
+    case CaptureFile::TravelledDistance:
+        type = DataSeriesType::TravelledDistance;
+        break;
+    case CaptureFile::RequestedStep:
+        type = DataSeriesType::RequestedSpeedStep;
+        break;
+    case CaptureFile::ReceivedStep:
+        type = DataSeriesType::ReceivedSpeedStep;
+        break;
+    default:
+        break;
+    }
+
+    CapturedSeries *series = new CapturedSeries(type, parent);
+    for(const Chunk& chunk : mChunks)
+    {
+        if(chunk.stream != stream || column >= chunk.columns)
+            continue;
+
+        // No copy, series points to mapped file
+        series->addChunk(chunk.column(0), chunk.column(column), chunk.count);
+    }
+
+    return series;
+}
+
+bool CaptureReader::readIndex()
+{
+    if(mSize < qint64(sizeof(FileHeader) + sizeof(FooterHeader) + sizeof(Trailer)))
+        return false;
+
+    Trailer trailer;
+    memcpy(&trailer, mData + mSize - sizeof(Trailer), sizeof(trailer));
+    if(memcmp(trailer.magic, TrailerMagic, sizeof(trailer.magic)) != 0)
+        return false;
+
+    const qint64 footerOffset = trailer.footerOffset;
+    if(footerOffset < qint64(sizeof(FileHeader))
+            || footerOffset + qint64(sizeof(FooterHeader)) > mSize - qint64(sizeof(Trailer)))
+        return false;
+
+    FooterHeader footer;
+    memcpy(&footer, mData + footerOffset, sizeof(footer));
+    if(footer.magic != FooterMagic)
+        return false;
+
+    const qint64 entriesOffset = footerOffset + sizeof(FooterHeader);
+    if(entriesOffset + qint64(footer.entryCount) * qint64(sizeof(IndexEntry)) > mSize - qint64(sizeof(Trailer)))
+        return false;
+
+    mChunks.reserve(footer.entryCount);
+
+    for(quint32 i = 0; i < footer.entryCount; i++)
+    {
+        IndexEntry entry;
+        memcpy(&entry, mData + entriesOffset + i * sizeof(IndexEntry), sizeof(entry));
+
+        if(!addChunk(entry.offset, entry.stream, entry.columns, entry.count))
+            return false;
+    }
+
+    return true;
+}
+
+void CaptureReader::scanChunks()
+{
+    qint64 offset = sizeof(FileHeader);
+
+    while(offset + qint64(sizeof(ChunkHeader)) <= mSize)
+    {
+        ChunkHeader header;
+        memcpy(&header, mData + offset, sizeof(header));
+        if(header.magic != ChunkMagic)
+            break; // Footer or truncated data
+
+        if(!addChunk(offset, header.stream, header.columns, header.count))
+            break; // Last chunk was not completely written
+
+        offset += sizeof(ChunkHeader) + qint64(header.columns) * header.count * sizeof(double);
+    }
+}
+
+bool CaptureReader::addChunk(qint64 offset, quint16 stream, quint16 columns, quint32 count)
+{
+    if(stream >= NStreams || columns != columnsForStream(stream))
+    {
+        mErrorString = QLatin1String("Invalid chunk");
+        return false;
+    }
+
+    const qint64 payloadOffset = offset + sizeof(ChunkHeader);
+    const qint64 payloadSize = qint64(columns) * count * sizeof(double);
+    if(offset < qint64(sizeof(FileHeader)) || payloadOffset + payloadSize > mSize)
+    {
+        mErrorString = QLatin1String("Chunk exceeds file size");
+        return false;
+    }
+
+    Chunk chunk;
+    chunk.stream = stream;
+    chunk.columns = columns;
+    chunk.count = int(count);
+    chunk.data = reinterpret_cast<const double *>(mData + payloadOffset);
+    mChunks.append(chunk);
+    return true;
+}
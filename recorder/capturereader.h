@@ -0,0 +1,64 @@
+#ifndef CAPTUREREADER_H
+#define CAPTUREREADER_H
+
+#include <QFile>
+#include <QVector>
+
+#include "capturefile.h"
+
+class QObject;
+class CapturedSeries;
+
+// Maps a binary capture file in memory, see capturefile.h
+// Series created by reader point to mapped memory, so they
+// must be deleted before reader is closed
+class CaptureReader
+{
+public:
+    struct Chunk
+    {
+        quint16 stream = 0;
+        quint16 columns = 0;
+        int count = 0;
+        const double *data = nullptr;
+
+        inline const double *column(int c) const { return data + qsizetype(c) * count; }
+    };
+
+    CaptureReader();
+    ~CaptureReader();
+
+    bool open(const QString& fileName);
+    void close();
+
+    inline bool isOpen() const { return mData != nullptr; }
+    QString errorString() const;
+
+    // True if file was not closed properly and chunks were scanned
+    inline bool isRecovered() const { return mRecovered; }
+
+    qint64 startTimestampMs() const;
+
+    QVector<Chunk> chunks(CaptureFile::Stream stream) const;
+    int pointCount(CaptureFile::Stream stream) const;
+
+    // Expose a column of stream as series, time is used as X
+    CapturedSeries *createSeries(CaptureFile::Stream stream, int column, QObject *parent = nullptr) const;
+
+private:
+    bool readIndex();
+    void scanChunks();
+    bool addChunk(qint64 offset, quint16 stream, quint16 columns, quint32 count);
+
+private:
+    QFile mFile;
+    uchar *mData = nullptr;
+    qint64 mSize = 0;
+
+    QString mErrorString;
+    bool mRecovered = false;
+
+    QVector<Chunk> mChunks;
+};
+
+#endif // CAPTUREREADER_H
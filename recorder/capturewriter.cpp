@@ -0,0 +1,189 @@
+#include "capturewriter.h"
+
+#include <QDateTime>
+
+#include <cstring>
+
+using namespace CaptureFile;
+
+CaptureWriter::CaptureWriter()
+{
+
+}
+
+CaptureWriter::~CaptureWriter()
+{
+    close();
+}
+
+bool CaptureWriter::open(const QString &fileName)
+{
+    close();
+
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    // Doubles are written as in memory
+    mErrorString = QLatin1String("Capture files are not supported on big endian hosts");
+    return false;
+#endif
+
+    mFile.setFileName(fileName);
+    if(!mFile.open(QFile::WriteOnly | QFile::NewOnly))
+    {
+        mErrorString = mFile.exists() ? QLatin1String("File already exists") : mFile.errorString();
+        return false;
+    }
+
+    mErrorString.clear();
+    mWriteFailed = false;
+
+    FileHeader header;
+    memcpy(header.magic, HeaderMagic, sizeof(header.magic));
+    header.version = Version;
+    header.headerSize = sizeof(FileHeader);
+    header.startTimestampMs = QDateTime::currentMSecsSinceEpoch();
+    header.flags = 0;
+    header.reserved = 0;
+
+    if(!writeData(&header, sizeof(header)))
+    {
+        mFile.close();
+        return false;
+    }
+
+    for(int i = 0; i < NStreams; i++)
+    {
+        for(int c = 0; c < columnsForStream(i); c++)
+            mBuffers[i][c].reserve(ChunkRows);
+    }
+
+    mIndex.clear();
+    return true;
+}
+
+bool CaptureWriter::close()
+{
+    if(!mFile.isOpen())
+        return !mWriteFailed;
+
+    flush();
+
+    // Write index so readers do not need to scan chunks
+    const qint64 footerOffset = mFile.pos();
+
+    FooterHeader footer;
+    footer.magic = FooterMagic;
+    footer.entryCount = mIndex.size();
+    writeData(&footer, sizeof(footer));
+    writeData(mIndex.constData(), qint64(mIndex.size()) * sizeof(IndexEntry));
+
+    Trailer trailer;
+    trailer.footerOffset = footerOffset;
+    memcpy(trailer.magic, TrailerMagic, sizeof(trailer.magic));
+    writeData(&trailer, sizeof(trailer));
+
+    // Buffered data is written on close
+    if(!mFile.flush() && !mWriteFailed)
+    {
+        mErrorString = mFile.errorString();
+        mWriteFailed = true;
+    }
+
+    mFile.close();
+    mIndex.clear();
+    return !mWriteFailed;
+}
+
+QString CaptureWriter::errorString() const
+{
+    return mErrorString;
+}
+
+void CaptureWriter::appendPoint(Stream stream, double seconds, double value)
+{
+    const double row[2] = {seconds, value};
+    appendRow(stream, row);
+}
+
+void CaptureWriter::appendLocoFeedback(double seconds, int address, int step, int direction)
+{
+    const double row[4] = {seconds, double(address), double(step), double(direction)};
+    appendRow(LocoFeedback, row);
+}
+
+void CaptureWriter::flush()
+{
+    if(!mFile.isOpen())
+        return;
+
+    for(int i = 0; i < NStreams; i++)
+        writeChunk(i);
+
+    if(!mWriteFailed && !mFile.flush())
+    {
+        mErrorString = mFile.errorString();
+        mWriteFailed = true;
+    }
+}
+
+void CaptureWriter::appendRow(quint16 stream, const double *values)
+{
+    if(!mFile.isOpen())
+        return;
+
+    const int columns = columnsForStream(stream);
+    for(int c = 0; c < columns; c++)
+        mBuffers[stream][c].append(values[c]);
+
+    if(mBuffers[stream][0].size() >= ChunkRows)
+        writeChunk(stream);
+}
+
+void CaptureWriter::writeChunk(quint16 stream)
+{
+    QVector<double> *buffers = mBuffers[stream];
+    const int count = buffers[0].size();
+    if(count == 0)
+        return;
+
+    const quint16 columns = columnsForStream(stream);
+
+    IndexEntry entry;
+    entry.offset = mFile.pos();
+    entry.stream = stream;
+    entry.columns = columns;
+    entry.count = count;
+    entry.firstTime = buffers[0].first();
+    entry.lastTime = buffers[0].last();
+    mIndex.append(entry);
+
+    ChunkHeader header;
+    header.magic = ChunkMagic;
+    header.stream = stream;
+    header.columns = columns;
+    header.count = count;
+    header.reserved = 0;
+    writeData(&header, sizeof(header));
+
+    for(int c = 0; c < columns; c++)
+    {
+        writeData(buffers[c].constData(), qint64(count) * sizeof(double));
+
+        // Keep capacity for next chunk
+        buffers[c].resize(0);
+    }
+}
+
+bool CaptureWriter::writeData(const void *data, qint64 size)
+{
+    if(mWriteFailed)
+        return false;
+
+    if(mFile.write(reinterpret_cast<const char *>(data), size) != size)
+    {
+        mErrorString = mFile.errorString();
+        mWriteFailed = true;
+        return false;
+    }
+
+    return true;
+}
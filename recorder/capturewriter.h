@@ -0,0 +1,49 @@
+#ifndef CAPTUREWRITER_H
+#define CAPTUREWRITER_H
+
+#include <QFile>
+#include <QVector>
+
+#include "capturefile.h"
+
+// Streams a run to a binary capture file, see capturefile.h
+class CaptureWriter
+{
+public:
+    CaptureWriter();
+    ~CaptureWriter();
+
+    // Existing files are never overwritten
+    bool open(const QString& fileName);
+
+    // Returns false if any write failed, see errorString()
+    bool close();
+
+    inline bool isOpen() const { return mFile.isOpen(); }
+    QString errorString() const;
+
+    void appendPoint(CaptureFile::Stream stream, double seconds, double value);
+    void appendLocoFeedback(double seconds, int address, int step, int direction);
+
+    // Write all buffered rows, even if chunks are not full
+    void flush();
+
+private:
+    void appendRow(quint16 stream, const double *values);
+    void writeChunk(quint16 stream);
+
+    // On first failure error is stored and next writes are skipped
+    bool writeData(const void *data, qint64 size);
+
+private:
+    QFile mFile;
+    QString mErrorString;
+    bool mWriteFailed = false;
+
+    // Column buffers for each stream
+    QVector<double> mBuffers[CaptureFile::NStreams][4];
+
+    QVector<CaptureFile::IndexEntry> mIndex;
+};
+
+#endif // CAPTUREWRITER_H
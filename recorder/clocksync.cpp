@@ -0,0 +1,114 @@
+#include "clocksync.h"
+
+#include <QtMath>
+
+ClockSync::ClockSync()
+{
+    mWindows.reserve(MaxWindows);
+}
+
+void ClockSync::reset()
+{
+    mWindows.clear();
+    mFirstWindow = 0;
+    mHasCurrent = false;
+    mHasEstimate = false;
+    mLastDevice = 0;
+    mRefDevice = 0;
+    mOffset = 0;
+    mDrift = 0;
+}
+
+void ClockSync::addSample(double deviceMicros, qint64 hostMicros)
+{
+    const double offset = double(hostMicros) - deviceMicros;
+
+    if(mHasEstimate)
+    {
+        // Device clock went back (i.e. sensor rebooted) or jumped forward
+        const bool wentBack = deviceMicros < mLastDevice;
+        const bool tooEarly = toHostMicros(deviceMicros) - double(hostMicros) > ResetThresholdMicros;
+        if(wentBack || tooEarly)
+            reset();
+    }
+    mLastDevice = deviceMicros;
+
+    if(mHasCurrent && deviceMicros - mCurrentStart >= WindowMicros)
+    {
+        // Close current window
+        if(mWindows.size() < MaxWindows)
+        {
+            mWindows.append(mCurrent);
+        }
+        else
+        {
+            mWindows[mFirstWindow] = mCurrent;
+            mFirstWindow = (mFirstWindow + 1) % MaxWindows;
+        }
+
+        mHasCurrent = false;
+        fit();
+    }
+
+    if(!mHasCurrent)
+    {
+        mCurrent = {deviceMicros, offset};
+        mCurrentStart = deviceMicros;
+        mHasCurrent = true;
+    }
+    else if(offset < mCurrent.offset)
+    {
+        mCurrent = {deviceMicros, offset};
+    }
+
+    if(mWindows.size() < 2)
+    {
+        // Not enough windows for drift, use best offset so far
+        double best = mCurrent.offset;
+        for(const WindowMin& w : std::as_const(mWindows))
+            best = qMin(best, w.offset);
+
+        mRefDevice = deviceMicros;
+        mOffset = best;
+        mDrift = 0;
+        mHasEstimate = true;
+    }
+}
+
+double ClockSync::toHostMicros(double deviceMicros) const
+{
+    return deviceMicros + mOffset + mDrift * (deviceMicros - mRefDevice);
+}
+
+void ClockSync::fit()
+{
+    const int n = mWindows.size();
+    if(n < 2)
+        return;
+
+    // Relative to oldest window to keep numbers small
+    const double ref = mWindows.at(mFirstWindow).device;
+
+    double sumX = 0, sumY = 0;
+    for(const WindowMin& w : std::as_const(mWindows))
+    {
+        sumX += w.device - ref;
+        sumY += w.offset;
+    }
+
+    const double meanX = sumX / n;
+    const double meanY = sumY / n;
+
+    double sxx = 0, sxy = 0;
+    for(const WindowMin& w : std::as_const(mWindows))
+    {
+        const double dx = w.device - ref - meanX;
+        sxx += dx * dx;
+        sxy += dx * (w.offset - meanY);
+    }
+
+    mDrift = sxx > 0 ? sxy / sxx : 0;
+    mRefDevice = ref + meanX;
+    mOffset = meanY;
+    mHasEstimate = true;
+}
@@ -0,0 +1,57 @@
+#ifndef CLOCKSYNC_H
+#define CLOCKSYNC_H
+
+#include <QVector>
+
+// Maps a device clock (i.e. ESP sensor) on host monotonic clock.
+// Arrival time is device time plus offset plus a latency which is never negative,
+// so in each window the sample with least (host - device) is the best offset estimate.
+// Offset and drift are a least squares fit of the last window minima.
+class ClockSync
+{
+public:
+    static constexpr double WindowMicros = 2000000;
+    static constexpr int MaxWindows = 60;
+
+    // Sample arrived this much earlier than estimate allows, device clock
+    // jumped forward. Late samples are only latency and are never a reason to reset
+    static constexpr double ResetThresholdMicros = 1000000;
+
+    ClockSync();
+
+    void reset();
+
+    void addSample(double deviceMicros, qint64 hostMicros);
+
+    double toHostMicros(double deviceMicros) const;
+
+    inline bool isValid() const { return mHasEstimate; }
+
+    // Rate of host clock compared to device clock, minus one, in parts per million
+    inline double driftPpm() const { return mDrift * 1000000.0; }
+
+private:
+    void fit();
+
+private:
+    struct WindowMin
+    {
+        double device;
+        double offset;
+    };
+
+    QVector<WindowMin> mWindows;
+    int mFirstWindow = 0; // Oldest in mWindows when full
+
+    WindowMin mCurrent;
+    double mCurrentStart = 0;
+    bool mHasCurrent = false;
+
+    bool mHasEstimate = false;
+    double mLastDevice = 0;
+    double mRefDevice = 0;
+    double mOffset = 0;
+    double mDrift = 0;
+};
+
+#endif // CLOCKSYNC_H
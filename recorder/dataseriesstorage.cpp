@@ -0,0 +1,79 @@
+#include "dataseriesstorage.h"
+
+DataSeriesSpan DataSeriesStorage::span(int first, int count) const
+{
+    DataSeriesSpan s;
+    if(first < 0 || first >= mX.size() || count <= 0)
+        return s;
+
+    s.first = first;
+    s.count = qMin(count, int(mX.size()) - first);
+    s.x = mX.constData() + first;
+    s.y = mY.constData() + first;
+    return s;
+}
+
+void DataSeriesStorage::reserve(int size)
+{
+    ensureCapacity(size);
+}
+
+void DataSeriesStorage::append(double x, double y)
+{
+    ensureCapacity(mX.size() + 1);
+    mX.append(x);
+    mY.append(y);
+}
+
+void DataSeriesStorage::insert(int index, double x, double y)
+{
+    ensureCapacity(mX.size() + 1);
+    mX.insert(index, x);
+    mY.insert(index, y);
+}
+
+void DataSeriesStorage::replace(int index, double x, double y)
+{
+    mX[index] = x;
+    mY[index] = y;
+}
+
+void DataSeriesStorage::setY(int index, double y)
+{
+    mY[index] = y;
+}
+
+void DataSeriesStorage::remove(int first, int count)
+{
+    mX.remove(first, count);
+    mY.remove(first, count);
+}
+
+void DataSeriesStorage::truncate(int size)
+{
+    if(size >= mX.size())
+        return;
+
+    mX.resize(size);
+    mY.resize(size);
+}
+
+void DataSeriesStorage::clear()
+{
+    // Qt 6 QList keeps capacity when not shared
+    mX.clear();
+    mY.clear();
+}
+
+void DataSeriesStorage::ensureCapacity(int size)
+{
+    if(size <= mX.capacity())
+        return;
+
+    // Grow at least by half current capacity, rounded up to granularity
+    int newCapacity = qMax(size, int(mX.capacity() + mX.capacity() / 2));
+    newCapacity = ((newCapacity + CapacityGranularity - 1) / CapacityGranularity) * CapacityGranularity;
+
+    mX.reserve(newCapacity);
+    mY.reserve(newCapacity);
+}
@@ -0,0 +1,72 @@
+#ifndef DATASERIESSTORAGE_H
+#define DATASERIESSTORAGE_H
+
+#include <QVector>
+#include <QPointF>
+
+// Read only view over contiguous series memory
+struct DataSeriesSpan
+{
+    const double *x = nullptr;
+    const double *y = nullptr;
+    int first = 0;
+    int count = 0;
+};
+
+// Columnar point storage: X and Y values are kept in separate contiguous
+// arrays so consumers can iterate them directly instead of per point calls.
+// Each array is a single buffer, growing past capacity reallocates and copies
+// it, so reserve() expected run size up front.
+class DataSeriesStorage
+{
+public:
+    // Capacity is rounded up to a multiple of this
+    static constexpr int CapacityGranularity = 4096;
+
+    DataSeriesStorage() = default;
+
+    inline int count() const { return mX.size(); }
+    inline bool isEmpty() const { return mX.isEmpty(); }
+
+    inline double xAt(int index) const { return mX.at(index); }
+    inline double yAt(int index) const { return mY.at(index); }
+
+    inline QPointF at(int index) const
+    {
+        return QPointF(mX.at(index), mY.at(index));
+    }
+
+    inline QPointF value(int index) const
+    {
+        if(index < 0 || index >= mX.size())
+            return QPointF();
+        return at(index);
+    }
+
+    inline const double *xData() const { return mX.constData(); }
+    inline const double *yData() const { return mY.constData(); }
+
+    DataSeriesSpan span(int first, int count) const;
+
+    void reserve(int size);
+
+    void append(double x, double y);
+    void insert(int index, double x, double y);
+    void replace(int index, double x, double y);
+    void setY(int index, double y);
+
+    void remove(int first, int count = 1);
+    void truncate(int size);
+
+    // Keeps capacity for next run, like Qt 6 QList::clear()
+    void clear();
+
+private:
+    void ensureCapacity(int size);
+
+private:
+    QVector<double> mX;
+    QVector<double> mY;
+};
+
+#endif // DATASERIESSTORAGE_H
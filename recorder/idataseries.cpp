@@ -1,5 +1,8 @@
 #include "idataseries.h"
 
+#include <algorithm>
+#include <limits>
+
 IDataSeries::IDataSeries(QObject *parent)
     : QObject{parent}
 {
@@ -16,6 +19,99 @@ void IDataSeries::setName(const QString &newName)
     mName = newName;
 }
 
+int IDataSeries::lowerBoundByX(double x) const
+{
+    const int count = getPointCount();
+    if(count == 0)
+        return 0;
+
+    const DataSeriesSpan span = getSpan(0, count);
+    if(span.count == count)
+    {
+        // Contiguous storage, search memory directly
+        return std::lower_bound(span.x, span.x + count, x) - span.x;
+    }
+
+    int first = 0;
+    int len = count;
+    while(len > 0)
+    {
+        const int half = len / 2;
+        const int mid = first + half;
+        if(getSpan(mid, 1).x[0] < x)
+        {
+            first = mid + 1;
+            len -= half + 1;
+        }
+        else
+        {
+            len = half;
+        }
+    }
+
+    return first;
+}
+
+int IDataSeries::upperBoundByX(double x) const
+{
+    const int count = getPointCount();
+    if(count == 0)
+        return 0;
+
+    const DataSeriesSpan span = getSpan(0, count);
+    if(span.count == count)
+    {
+        // Contiguous storage, search memory directly
+        return std::upper_bound(span.x, span.x + count, x) - span.x;
+    }
+
+    int first = 0;
+    int len = count;
+    while(len > 0)
+    {
+        const int half = len / 2;
+        const int mid = first + half;
+        if(!(x < getSpan(mid, 1).x[0]))
+        {
+            first = mid + 1;
+            len -= half + 1;
+        }
+        else
+        {
+            len = half;
+        }
+    }
+
+    return first;
+}
+
+DataSeriesStepInterval IDataSeries::stepIntervalAt(double x) const
+{
+    DataSeriesStepInterval interval;
+
+    // Last point at or before x sets current step
+    const int next = upperBoundByX(x);
+    interval.index = next - 1;
+
+    if(interval.index >= 0)
+    {
+        const QPointF pt = getPointAt(interval.index);
+        interval.step = int(pt.y());
+        interval.start = pt.x();
+    }
+    else
+    {
+        interval.start = -std::numeric_limits<double>::infinity();
+    }
+
+    if(next < getPointCount())
+        interval.end = getPointAt(next).x();
+    else
+        interval.end = std::numeric_limits<double>::infinity();
+
+    return interval;
+}
+
 QString IDataSeries::defaultTooltip(const QString& seriesName, int index, const QPointF &point)
 {
     return tr("<b>%1</b><br>"
@@ -26,3 +122,153 @@ QString IDataSeries::defaultTooltip(const QString& seriesName, int index, const
             .arg(index)
             .arg(point.x()).arg(point.y());
 }
+
+void IDataSeries::beginBatch()
+{
+    mBatchDepth++;
+}
+
+void IDataSeries::endBatch()
+{
+    if(mBatchDepth == 0)
+        return;
+
+    mBatchDepth--;
+    if(mBatchDepth == 0)
+        flushPending();
+}
+
+void IDataSeries::notifyPointsAppended(int first, int count)
+{
+    if(count <= 0)
+        return;
+
+    if(!isBatching())
+    {
+        emit pointsAppended(first, count);
+        return;
+    }
+
+    if(mPendingReset)
+        return; // Will be read on reset
+
+    if(mPendingAppendCount && first == mPendingAppendFirst + mPendingAppendCount)
+    {
+        // Extend pending range
+        mPendingAppendCount += count;
+        return;
+    }
+
+    if(mPendingAppendCount)
+    {
+        // Not contiguous, give up and reset
+        mPendingReset = true;
+        return;
+    }
+
+    mPendingAppendFirst = first;
+    mPendingAppendCount = count;
+}
+
+void IDataSeries::notifyPointsChanged(int first, int count)
+{
+    if(count <= 0)
+        return;
+
+    if(!isBatching())
+    {
+        emit pointsChanged(first, count);
+        return;
+    }
+
+    if(mPendingReset)
+        return;
+
+    if(mPendingAppendCount && first >= mPendingAppendFirst)
+    {
+        // Changed points are not yet known to listeners
+        if(first + count <= mPendingAppendFirst + mPendingAppendCount)
+            return;
+
+        mPendingReset = true;
+        return;
+    }
+
+    if(mPendingAppendCount && first + count > mPendingAppendFirst)
+    {
+        // Tail is covered by pending append
+        count = mPendingAppendFirst - first;
+    }
+
+    if(!mPendingChangeCount)
+    {
+        mPendingChangeFirst = first;
+        mPendingChangeCount = count;
+        return;
+    }
+
+    // Merge into a single range
+    const int last = qMax(first + count, mPendingChangeFirst + mPendingChangeCount);
+    mPendingChangeFirst = qMin(first, mPendingChangeFirst);
+    mPendingChangeCount = last - mPendingChangeFirst;
+}
+
+void IDataSeries::notifyPointsRemoved(int first, int count)
+{
+    if(count <= 0)
+        return;
+
+    if(!isBatching())
+    {
+        emit pointsRemoved(first, count);
+        return;
+    }
+
+    if(mPendingAppendCount || mPendingChangeCount)
+    {
+        // Pending indexes are not valid anymore
+        mPendingReset = true;
+    }
+
+    if(mPendingReset)
+        return;
+
+    // Nothing pending, listeners can still apply it in order
+    emit pointsRemoved(first, count);
+}
+
+void IDataSeries::notifyReset()
+{
+    if(!isBatching())
+    {
+        emit reset();
+        return;
+    }
+
+    mPendingReset = true;
+}
+
+void IDataSeries::flushPending()
+{
+    const bool doReset = mPendingReset;
+    const int changeFirst = mPendingChangeFirst;
+    const int changeCount = mPendingChangeCount;
+    const int appendFirst = mPendingAppendFirst;
+    const int appendCount = mPendingAppendCount;
+
+    mPendingReset = false;
+    mPendingChangeCount = 0;
+    mPendingAppendCount = 0;
+
+    if(doReset)
+    {
+        emit reset();
+        return;
+    }
+
+    if(changeCount)
+        emit pointsChanged(changeFirst, changeCount);
+
+    if(appendCount)
+        emit pointsAppended(appendFirst, appendCount);
+}
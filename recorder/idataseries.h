@@ -6,6 +6,8 @@
 #include <QString>
 #include <QPointF>
 
+#include "dataseriesstorage.h"
+
 enum DataSeriesType
 {
     Unknown = 0,
@@ -30,11 +32,14 @@ static const char* DataSeriesType_names[] =
     QT_TRANSLATE_NOOP("IDataSeries", "CurveMapping")
 };
 
-enum DataSeriesAction
+// Step active in [start, end) for series with step values.
+// index is -1 if no step was set before requested time
+struct DataSeriesStepInterval
 {
-    PointAdded = 0,
-    PointChanged,
-    PointRemoved
+    int step = 0;
+    int index = -1;
+    double start = 0;
+    double end = 0;
 };
 
 class IDataSeries : public QObject
@@ -51,6 +56,19 @@ public:
     virtual QPointF getPointAt(int index) const = 0;
     virtual QString getPointTooltip(int index) const = 0;
 
+    // Direct access to point memory starting at first.
+    // Returned span can be shorter than count if storage is not contiguous,
+    // so callers must loop until they consumed all points they need.
+    virtual DataSeriesSpan getSpan(int first, int count) const = 0;
+
+    // Lookups by X value, they require non-decreasing X like timestamps.
+    // Return first index with X >= x and X > x respectively
+    int lowerBoundByX(double x) const;
+    int upperBoundByX(double x) const;
+
+    // For step series, get step active at x and its time interval
+    DataSeriesStepInterval stepIntervalAt(double x) const;
+
     static QString defaultTooltip(const QString &seriesName, int index, const QPointF& point);
 
     inline static QString trType(DataSeriesType t)
@@ -58,13 +76,41 @@ public:
         return tr(DataSeriesType_names[int(t)]);
     }
 
+    // Collect notifications until matching endBatch().
+    // Batches can be nested, signals are emitted by outermost endBatch()
+    void beginBatch();
+    void endBatch();
+    inline bool isBatching() const { return mBatchDepth > 0; }
+
 signals:
-    void pointAdded(int index, const QPointF& point);
-    void pointRemoved(int index);
-    void pointChanged(int index, const QPointF& newPoint);
+    // Points are already stored when signals are emitted
+    void pointsAppended(int first, int count);
+    void pointsChanged(int first, int count);
+    void pointsRemoved(int first, int count);
+
+    // All points changed, re-read whole series
+    void reset();
+
+protected:
+    void notifyPointsAppended(int first, int count);
+    void notifyPointsChanged(int first, int count);
+    void notifyPointsRemoved(int first, int count);
+    void notifyReset();
+
+private:
+    void flushPending();
 
 private:
     QString mName;
+
+    int mBatchDepth = 0;
+    bool mPendingReset = false;
+
+    int mPendingAppendFirst = 0;
+    int mPendingAppendCount = 0;
+
+    int mPendingChangeFirst = 0;
+    int mPendingChangeCount = 0;
 };
 
 #endif // IDATASERIES_H
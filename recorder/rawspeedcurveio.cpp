@@ -1,5 +1,7 @@
 #include "rawspeedcurveio.h"
 
+#include "speedcurvefile.h"
+
 #include <QFile>
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -80,25 +82,22 @@ bool RawSpeedCurveIO::readCurveFromFile(const QString &fileName, QLineSeries *se
     return true;
 }
 
-bool RawSpeedCurveIO::saveCurveToFile(const QString &fileName, QLineSeries *series)
+static QVector<double> curveFromSeries(QLineSeries *series)
 {
-    QFile f(fileName);
-    if(!f.open(QFile::WriteOnly))
-        return false;
-
-    QJsonObject obj;
-    obj[QLatin1String("name")] = series->name();
-
-    QJsonArray arr;
-    for(int step = 0; step <= 126 && step < series->count(); step++)
+    QVector<double> curve;
+    curve.reserve(SpeedCurveFile::CurveSize);
+    for(int step = 0; step < SpeedCurveFile::CurveSize && step < series->count(); step++)
     {
-        arr.append(QJsonValue(series->at(step).y()));
+        curve.append(series->at(step).y());
     }
+    return curve;
+}
 
-    obj[QLatin1String("curve_array")] = arr;
-
-    QJsonDocument doc(obj);
-    f.write(doc.toJson());
+bool RawSpeedCurveIO::saveCurveToFile(const QString &fileName, QLineSeries *series, QLineSeries *reverseSeries)
+{
+    QVector<double> reverseCurve;
+    if(reverseSeries)
+        reverseCurve = curveFromSeries(reverseSeries);
 
-    return true;
+    return SpeedCurveFile::saveCurveArray(fileName, series->name(), curveFromSeries(series), reverseCurve);
 }
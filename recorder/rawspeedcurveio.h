@@ -8,7 +8,9 @@ class RawSpeedCurveIO
 {
 public:
     static bool readCurveFromFile(const QString& fileName, QLineSeries *series);
-    static bool saveCurveToFile(const QString& fileName, QLineSeries *series);
+    // Optional reverse curve is saved in same file
+    static bool saveCurveToFile(const QString& fileName, QLineSeries *series,
+                                QLineSeries *reverseSeries = nullptr);
 };
 
 #endif // RAWSPEEDCURVEIO_H
@@ -10,10 +10,23 @@
 #include "series/sensortravelleddistanceseries.h"
 #include "series/dataseriescurvemapping.h"
 
+#include "capturewriter.h"
+#include "speedcurvefile.h"
+#include "replayengine.h"
+#include "recordingsessionmanager.h"
+
+#include "../utils/monotonicclock.h"
+
 #include <QTimerEvent>
 
 #include <QDebug>
 
+// Reverse is stored as negative step in step series
+static inline int signedStep(int step, LocomotiveDirection direction)
+{
+    return direction == LocomotiveDirection::Reverse ? -step : step;
+}
+
 RecordingManager::RecordingManager(QObject *parent)
     : QObject{parent}
 {
@@ -36,45 +49,157 @@ RecordingManager::~RecordingManager()
     stopInternal();
 }
 
-void RecordingManager::onNewSpeedReading(double metersPerSecond, double travelledMillimeters, qint64 timestampMilliSec)
+void RecordingManager::onSpeedReadingsAvailable()
 {
-    if(mState == State::Stopped)
+    if(!mSpeedSensor)
         return;
 
-    if(mStartTimestamp == -1)
+    constexpr int BatchSize = 256;
+    SpeedSample batch[BatchSize];
+
+    int count = 0;
+    do
     {
-        // Reset time reference
-        mStartTimestamp = timestampMilliSec;
-    }
+        count = mSpeedSensor->takeReadings(batch, BatchSize);
 
-    timestampMilliSec -= mStartTimestamp;
+        if(!mReplay)
+        {
+            // Keep clock synced also when stopped so it is ready on start
+            for(int i = 0; i < count; i++)
+                mSensorClock.addSample(double(batch[i].timestampMicros), batch[i].hostMicros);
+        }
 
-    mRawSensorSeries->addPoint(metersPerSecond, timestampMilliSec / 1000.0);
-    mSensorTravelledSeries->addPoint(travelledMillimeters, timestampMilliSec / 1000.0);
+        // Drain also when stopped so stale readings do not fill the ring
+        if(mState != State::Stopped && count > 0)
+            addSpeedReadings(batch, count);
+    }
+    while(count == BatchSize);
 
-    qDebug() << "READ:" << timestampMilliSec << metersPerSecond << travelledMillimeters;
+    const quint64 overruns = mSpeedSensor->overrunCount();
+    if(overruns != mLastSensorOverruns)
+    {
+        if(mState != State::Stopped)
+            mLostSensorReadings += overruns - mLastSensorOverruns;
 
-    //TODO: direction
+        qWarning() << "Sensor readings lost:" << overruns - mLastSensorOverruns
+                   << "total this run:" << mLostSensorReadings;
+        mLastSensorOverruns = overruns;
+    }
 
     if(mState == State::WaitingToStop)
         tryStopInternal();
 }
 
-void RecordingManager::onLocomotiveSpeedFeedback(int address, int speedStep, LocomotiveDirection direction)
+void RecordingManager::onSensorWaveformAvailable()
+{
+    if(!mSpeedSensor)
+        return;
+
+    constexpr int BatchSize = 64;
+    WaveformBlock batch[BatchSize];
+
+    int count = 0;
+    do
+    {
+        count = mSpeedSensor->takeWaveform(batch, BatchSize);
+
+        // Waveform is only stored in capture
+        if(!mCapture || mState == State::Stopped || !mSensorClock.isValid())
+            continue;
+
+        for(int b = 0; b < count; b++)
+        {
+            const WaveformBlock& block = batch[b];
+            const double firstSeconds = sensorToRunSeconds(block.firstSampleMicros);
+            const double periodSeconds = block.samplePeriodMicros / 1000000.0;
+            for(int i = 0; i < block.count; i++)
+            {
+                const double seconds = firstSeconds + i * periodSeconds;
+                if(seconds >= 0)
+                    mCapture->appendPoint(CaptureFile::HallWaveform, seconds, block.samples[i]);
+            }
+        }
+    }
+    while(count == BatchSize);
+}
+
+void RecordingManager::addSpeedReadings(const SpeedSample *samples, int count)
+{
+    if(!mSensorBatchTimerId)
+    {
+        // Start a new burst, listeners get notified when timer fires
+        mRawSensorSeries->beginBatch();
+        mSensorTravelledSeries->beginBatch();
+        mSensorBatchTimerId = startTimer(mSensorBatchMillis);
+    }
+
+    for(int i = 0; i < count; i++)
+    {
+        const SpeedSample& sample = samples[i];
+
+        // Measured by sensor before run started
+        const double seconds = sensorToRunSeconds(double(sample.timestampMicros));
+        if(seconds < 0)
+            continue;
+
+        mRawSensorSeries->addPoint(sample.metersPerSecond, seconds);
+        mSensorTravelledSeries->addPoint(sample.travelledMillimeters, seconds);
+
+        if((mAdaptiveStepTime || mSparseSweep) && !mReplay && !mReqStepIsPending
+                && mState == State::Running
+                && seconds - mStepStartSeconds >= mMinStepTimeMillis / 1000.0)
+        {
+            // Locomotive reached new speed, do not wait for timer
+            if(mSteadyDetector.addSample(sample.metersPerSecond)
+                    && mAdaptiveStepTime && !currentTimerIsCustom)
+                goToNextStep();
+        }
+
+        if(mCapture)
+        {
+            mCapture->appendPoint(CaptureFile::RawSpeed, seconds, sample.metersPerSecond);
+            mCapture->appendPoint(CaptureFile::TravelledDistance, seconds, sample.travelledMillimeters);
+        }
+    }
+
+    // Sensor speed has no sign, direction is taken from received step
+}
+
+void RecordingManager::onLocomotiveSpeedFeedback(int address, int speedStep, LocomotiveDirection direction,
+                                                  bool /*wasQueued*/, qint64 hostMicros)
 {
-    if(mState == State::Stopped || address != locomotiveDCCAddress)
+    if(mState == State::Stopped)
         return;
 
-    int oldRecvStep = actualDCCStep;
+    // Time of reception, not of this queued call
+    const double seconds = hostToRunSeconds(hostMicros);
+
+    if(mCapture)
+    {
+        // Only feedback of this session locomotive when routed by
+        // RecordingSessionManager, otherwise all of command station
+        mCapture->appendLocoFeedback(seconds, address, speedStep, int(direction));
+    }
+
+    if(address != locomotiveDCCAddress)
+        return;
+
+    const int oldRecvStep = signedStep(actualDCCStep, actualDirection);
     actualDCCStep = speedStep;
+    actualDirection = direction;
+    const int newRecvStep = signedStep(actualDCCStep, actualDirection);
 
-    if(mReqStepIsPending && actualDCCStep == requestedDCCStep)
+    if(mReqStepIsPending && actualDCCStep == requestedDCCStep && actualDirection == requestedDirection)
         mReqStepIsPending = false;
 
-    mRecvStepSeries->addPoint(oldRecvStep, mElapsed.elapsed() / 1000.0);
-    mRecvStepSeries->addPoint(actualDCCStep, mElapsed.elapsed() / 1000.0);
+    mRecvStepSeries->addPoint(oldRecvStep, seconds);
+    mRecvStepSeries->addPoint(newRecvStep, seconds);
 
-    //TODO: direction
+    if(mCapture)
+    {
+        mCapture->appendPoint(CaptureFile::ReceivedStep, seconds, oldRecvStep);
+        mCapture->appendPoint(CaptureFile::ReceivedStep, seconds, newRecvStep);
+    }
 
     if(mState == State::WaitingToStop)
         tryStopInternal();
@@ -87,20 +212,53 @@ void RecordingManager::onSeriesDestroyed(QObject *s)
     emit seriesUnregistered(series);
 }
 
-void RecordingManager::requestStepInternal(int step)
+void RecordingManager::onReplayStepRequested(int step)
+{
+    if(mState == State::Stopped)
+        return;
+
+    // Recorded stream already contains final stop request
+    requestStepInternal(qAbs(step), step < 0 ? LocomotiveDirection::Reverse : LocomotiveDirection::Forward);
+}
+
+void RecordingManager::onReplayFinished()
+{
+    if(mState == State::Stopped)
+        return;
+
+    setState(State::WaitingToStop);
+    stopInternal();
+}
+
+void RecordingManager::requestStepInternal(int step, LocomotiveDirection direction)
 {
-    int oldStep = requestedDCCStep;
+    const int oldStep = signedStep(requestedDCCStep, requestedDirection);
     requestedDCCStep = step;
+    requestedDirection = direction;
+    const int newStep = signedStep(requestedDCCStep, requestedDirection);
+
+    mSteadyDetector.reset();
+    mStepStartSeconds = hostToRunSeconds(monotonicMicros());
 
     if(mCommandStation)
     {
-        mReqStepSeries->addPoint(oldStep, mElapsed.elapsed() / 1000.0);
-        mReqStepSeries->addPoint(requestedDCCStep, mElapsed.elapsed() / 1000.0);
+        const double seconds = hostToRunSeconds(monotonicMicros());
+        mReqStepSeries->addPoint(oldStep, seconds);
+        mReqStepSeries->addPoint(newStep, seconds);
+
+        if(mCapture)
+        {
+            mCapture->appendPoint(CaptureFile::RequestedStep, seconds, oldStep);
+            mCapture->appendPoint(CaptureFile::RequestedStep, seconds, newStep);
+
+            // Write previous step to disk, at most one step is lost on crash
+            mCapture->flush();
+        }
 
         mReqStepIsPending = true;
         mCommandStation->setLocomotiveSpeed(locomotiveDCCAddress,
                                             requestedDCCStep,
-                                            LocomotiveDirection::Forward);
+                                            requestedDirection);
     }
 }
 
@@ -129,6 +287,46 @@ void RecordingManager::tryStopInternal()
     stopInternal();
 }
 
+QString RecordingManager::captureFileName() const
+{
+    return mCaptureFileName;
+}
+
+void RecordingManager::setCaptureFileName(const QString &newCaptureFileName)
+{
+    mCaptureFileName = newCaptureFileName;
+}
+
+ReplayEngine *RecordingManager::replayEngine() const
+{
+    return mReplay;
+}
+
+void RecordingManager::setReplayEngine(ReplayEngine *newReplayEngine)
+{
+    if(mState != State::Stopped)
+        return;
+
+    if(mReplay)
+    {
+        disconnect(mReplay, &ReplayEngine::stepRequested, this, &RecordingManager::onReplayStepRequested);
+        disconnect(mReplay, &ReplayEngine::finished, this, &RecordingManager::onReplayFinished);
+    }
+
+    mReplay = newReplayEngine;
+
+    if(mReplay)
+    {
+        connect(mReplay, &ReplayEngine::stepRequested, this, &RecordingManager::onReplayStepRequested);
+        connect(mReplay, &ReplayEngine::finished, this, &RecordingManager::onReplayFinished);
+    }
+}
+
+quint64 RecordingManager::lostSensorReadings() const
+{
+    return mLostSensorReadings;
+}
+
 int RecordingManager::defaultStepTimeMillis() const
 {
     return mDefaultStepTimeMillis;
@@ -141,23 +339,206 @@ void RecordingManager::setDefaultStepTimeMillis(int newDefaultStepTimeMillis)
     mDefaultStepTimeMillis = newDefaultStepTimeMillis;
 }
 
+bool RecordingManager::adaptiveStepTime() const
+{
+    return mAdaptiveStepTime;
+}
+
+void RecordingManager::setAdaptiveStepTime(bool newAdaptiveStepTime)
+{
+    mAdaptiveStepTime = newAdaptiveStepTime;
+}
+
+int RecordingManager::minStepTimeMillis() const
+{
+    return mMinStepTimeMillis;
+}
+
+void RecordingManager::setMinStepTimeMillis(int newMinStepTimeMillis)
+{
+    mMinStepTimeMillis = qBound(0, newMinStepTimeMillis, mMaxStepTimeMillis);
+}
+
+int RecordingManager::maxStepTimeMillis() const
+{
+    return mMaxStepTimeMillis;
+}
+
+void RecordingManager::setMaxStepTimeMillis(int newMaxStepTimeMillis)
+{
+    if((newMaxStepTimeMillis < 1000) || (newMaxStepTimeMillis > 60000))
+        return;
+    mMaxStepTimeMillis = newMaxStepTimeMillis;
+    mMinStepTimeMillis = qMin(mMinStepTimeMillis, mMaxStepTimeMillis);
+}
+
+double RecordingManager::steadySpeedTolerance() const
+{
+    return mSteadyDetector.relativeTolerance();
+}
+
+void RecordingManager::setSteadySpeedTolerance(double relativeTolerance)
+{
+    mSteadyDetector.setRelativeTolerance(relativeTolerance);
+}
+
+int RecordingManager::stepTimerMillis() const
+{
+    // In adaptive mode timer is only the upper limit
+    return mAdaptiveStepTime ? mMaxStepTimeMillis : mDefaultStepTimeMillis;
+}
+
+bool RecordingManager::sparseSweep() const
+{
+    return mSparseSweep;
+}
+
+void RecordingManager::setSparseSweep(bool newSparseSweep)
+{
+    if(mState != State::Stopped)
+        return;
+    mSparseSweep = newSparseSweep;
+}
+
+SweepPlanner *RecordingManager::sweepPlanner()
+{
+    return &mSweepPlanner;
+}
+
+QString RecordingManager::speedMappingFileName() const
+{
+    return mSpeedMappingFileName;
+}
+
+void RecordingManager::setSpeedMappingFileName(const QString &newSpeedMappingFileName)
+{
+    mSpeedMappingFileName = newSpeedMappingFileName;
+}
+
+bool RecordingManager::bidirectional() const
+{
+    return mBidirectional;
+}
+
+void RecordingManager::setBidirectional(bool newBidirectional)
+{
+    if(mState != State::Stopped)
+        return;
+    mBidirectional = newBidirectional;
+}
+
+int RecordingManager::directionBlockSize() const
+{
+    return mDirectionBlockSize;
+}
+
+void RecordingManager::setDirectionBlockSize(int newDirectionBlockSize)
+{
+    if(newDirectionBlockSize < 1 || newDirectionBlockSize > 126)
+        return;
+    mDirectionBlockSize = newDirectionBlockSize;
+}
+
+void RecordingManager::advanceStep()
+{
+    if(!mSparseSweep)
+    {
+        if(!mBidirectional)
+        {
+            requestStep(requestedDCCStep + 1);
+            return;
+        }
+
+        // Walk block forward, then same block in reverse
+        const int blockLastStep = qMin(mBlockFirstStep + mDirectionBlockSize - 1, 126);
+        if(requestedDCCStep < blockLastStep)
+        {
+            requestStepInternal(requestedDCCStep + 1, requestedDirection);
+        }
+        else if(requestedDirection == LocomotiveDirection::Forward)
+        {
+            requestStepInternal(mBlockFirstStep, LocomotiveDirection::Reverse);
+        }
+        else
+        {
+            mBlockFirstStep = blockLastStep + 1;
+            requestStep(mBlockFirstStep);
+        }
+        return;
+    }
+
+    // Speed at end of step, only if it settled
+    const bool steady = !mReqStepIsPending && mSteadyDetector.isSteady();
+
+    // Planner refines on forward curve, each planned step is also measured in reverse
+    if(mBidirectional && requestedDirection == LocomotiveDirection::Forward)
+    {
+        mForwardSteady = steady;
+        mForwardSpeed = steady ? mSteadyDetector.mean() : 0;
+        requestStepInternal(requestedDCCStep, LocomotiveDirection::Reverse);
+        return;
+    }
+
+    if(!mBidirectional && steady)
+    {
+        mSweepPlanner.addMeasurement(requestedDCCStep, mSteadyDetector.mean());
+    }
+    else if(mBidirectional && steady && mForwardSteady)
+    {
+        // Both directions settled
+        mSweepPlanner.addMeasurement(requestedDCCStep, mForwardSpeed);
+        mReverseMeasurements.insert(requestedDCCStep, mSteadyDetector.mean());
+    }
+    else
+    {
+        // Measure again later, in both directions if bidirectional
+        mSweepPlanner.remeasure(requestedDCCStep);
+    }
+
+    const int step = mSweepPlanner.nextStep();
+    if(step < 0)
+    {
+        stop();
+        return;
+    }
+
+    requestStep(step);
+}
+
+void RecordingManager::saveSpeedMapping()
+{
+    if(mSpeedMappingFileName.isEmpty() || mSweepPlanner.measurements().isEmpty())
+        return;
+
+    const QString name = tr("Sparse sweep %1").arg(locomotiveDCCAddress);
+    if(!SpeedCurveFile::saveSpeedMapping(mSpeedMappingFileName, name, locomotiveDCCAddress,
+                                         mSweepPlanner.measurements(), mReverseMeasurements))
+    {
+        qWarning() << "Cannot save speed mapping:" << mSpeedMappingFileName;
+        return;
+    }
+
+    qDebug() << "Sparse sweep:" << mSweepPlanner.measurements().size()
+             << "steps measured of" << mSweepPlanner.requestedCount() << "requested";
+}
+
 void RecordingManager::goToNextStep()
 {
-    if(mState != State::Running)
+    if(mState != State::Running || mReplay)
         return;
 
     // Restart timer for next step
     killTimer(mStepTimerId);
-    mStepTimerId = startTimer(mDefaultStepTimeMillis);
+    mStepTimerId = startTimer(stepTimerMillis());
     currentTimerIsCustom = false;
 
     // Go to next step directly
-    requestStep(requestedDCCStep + 1);
+    advanceStep();
 }
 
 void RecordingManager::setCustomTimeForCurrentStep(int millis)
 {
-    if(mState != State::Running)
+    if(mState != State::Running || mReplay)
         return;
 
     // Restart timer for current step
@@ -209,7 +590,7 @@ void RecordingManager::requestStep(int step)
         return;
     }
 
-    requestStepInternal(step);
+    requestStepInternal(step, LocomotiveDirection::Forward);
 }
 
 QVector<IDataSeries *> RecordingManager::getSeries() const
@@ -263,7 +644,7 @@ int RecordingManager::getLocomotiveDCCAddress() const
 
 void RecordingManager::setLocomotiveDCCAddress(int newLocomotiveDCCAddress)
 {
-    if(locomotiveDCCAddress <= 0 || locomotiveDCCAddress > 9999)
+    if(newLocomotiveDCCAddress <= 0 || newLocomotiveDCCAddress > 9999)
         return;
     locomotiveDCCAddress = newLocomotiveDCCAddress;
 }
@@ -272,13 +653,13 @@ void RecordingManager::timerEvent(QTimerEvent *e)
 {
     if(e->timerId() == mStepTimerId && mStepTimerId)
     {
-        requestStep(requestedDCCStep + 1);
+        advanceStep();
 
         if(currentTimerIsCustom)
         {
             // Reset to default timer for next step
             killTimer(mStepTimerId);
-            mStepTimerId = startTimer(mDefaultStepTimeMillis);
+            mStepTimerId = startTimer(stepTimerMillis());
             currentTimerIsCustom = false;
         }
         return;
@@ -288,6 +669,11 @@ void RecordingManager::timerEvent(QTimerEvent *e)
         stopInternal();
         return;
     }
+    else if(e->timerId() == mSensorBatchTimerId && mSensorBatchTimerId)
+    {
+        endSensorBatch();
+        return;
+    }
 
     QObject::timerEvent(e);
 }
@@ -300,6 +686,8 @@ bool RecordingManager::start()
         return false;
     }
 
+    endSensorBatch();
+
     mRecvStepSeries->clear();
     mReqStepSeries->clear();
     mRawSensorSeries->clear();
@@ -307,17 +695,70 @@ bool RecordingManager::start()
 
     actualDCCStep = 0;
     requestedDCCStep = 0;
+    actualDirection = LocomotiveDirection::Forward;
+    requestedDirection = LocomotiveDirection::Forward;
     mReqStepIsPending = false;
 
-    mStartTimestamp = -1;
+    mLostSensorReadings = 0;
+
+    if(mReplay)
+    {
+        if(!mReplay->isOpen())
+            return false;
+
+        // Recorded size is known exactly
+        const CaptureReader *reader = mReplay->reader();
+        mRecvStepSeries->reserve(reader->pointCount(CaptureFile::ReceivedStep));
+        mReqStepSeries->reserve(reader->pointCount(CaptureFile::RequestedStep));
+        mRawSensorSeries->reserve(reader->pointCount(CaptureFile::RawSpeed));
+        mSensorTravelledSeries->reserve(reader->pointCount(CaptureFile::TravelledDistance));
+
+        // No step timer and no capture, engine drives the run
+        setState(State::Running);
+        mReplay->start();
+        return true;
+    }
+
+    // Reserve expected run size up front to avoid reallocating while recording
+    // Sensor readings arrive roughly every 100 ms, steps have start and end points
+    const int stepCount = (126 - mStartingDCCStep + 1) * (mBidirectional ? 2 : 1);
+    const int expectedReadings = stepCount * mDefaultStepTimeMillis / 100;
+    mRecvStepSeries->reserve(stepCount * 2 + 2);
+    mReqStepSeries->reserve(stepCount * 2 + 2);
+    mRawSensorSeries->reserve(expectedReadings);
+    mSensorTravelledSeries->reserve(expectedReadings);
+
+    if(!mCaptureFileName.isEmpty())
+    {
+        mCapture = new CaptureWriter;
+        if(!mCapture->open(mCaptureFileName))
+        {
+            qWarning() << "Cannot open capture file:" << mCaptureFileName << mCapture->errorString();
+            delete mCapture;
+            mCapture = nullptr;
+        }
+    }
 
     currentTimerIsCustom = false;
-    mStepTimerId = startTimer(mDefaultStepTimeMillis);
+    mStepTimerId = startTimer(stepTimerMillis());
 
-    mElapsed.start();
+    mRunStartMicros = monotonicMicros();
 
     setState(State::Running);
-    requestStep(mStartingDCCStep);
+
+    mBlockFirstStep = mStartingDCCStep;
+
+    if(mSparseSweep)
+    {
+        mReverseMeasurements.clear();
+        mForwardSteady = false;
+        mSweepPlanner.start(mStartingDCCStep, 126);
+        requestStep(mSweepPlanner.nextStep());
+    }
+    else
+    {
+        requestStep(mStartingDCCStep);
+    }
 
     return true;
 }
@@ -327,6 +768,15 @@ void RecordingManager::stop()
     if(mState != State::Running)
         return;
 
+    if(mReplay)
+    {
+        // Recorded data ends here, nothing else to wait for
+        mReplay->stop();
+        setState(State::WaitingToStop);
+        stopInternal();
+        return;
+    }
+
     if(mStepTimerId)
     {
         killTimer(mStepTimerId);
@@ -344,8 +794,8 @@ void RecordingManager::stop()
     }
     mForceStopTimerId = startTimer(5000);
 
-    // Stop the locomotive
-    requestStepInternal(0);
+    // Stop the locomotive, keep direction
+    requestStepInternal(0, requestedDirection);
 }
 
 void RecordingManager::stopInternal()
@@ -353,6 +803,19 @@ void RecordingManager::stopInternal()
     if(mState != State::WaitingToStop)
         return;
 
+    endSensorBatch();
+
+    if(mSparseSweep && !mReplay)
+        saveSpeedMapping();
+
+    if(mCapture)
+    {
+        if(!mCapture->close())
+            qWarning() << "Capture file is incomplete:" << mCaptureFileName << mCapture->errorString();
+        delete mCapture;
+        mCapture = nullptr;
+    }
+
     if(mForceStopTimerId)
     {
         killTimer(mForceStopTimerId);
@@ -362,6 +825,33 @@ void RecordingManager::stopInternal()
     setState(State::Stopped);
 }
 
+void RecordingManager::endSensorBatch()
+{
+    if(!mSensorBatchTimerId)
+        return;
+
+    killTimer(mSensorBatchTimerId);
+    mSensorBatchTimerId = 0;
+
+    mRawSensorSeries->endBatch();
+    mSensorTravelledSeries->endBatch();
+}
+
+double RecordingManager::hostToRunSeconds(qint64 hostMicros) const
+{
+    if(mReplay)
+        return mReplay->elapsedMicros() / 1000000.0;
+    return (hostMicros - mRunStartMicros) / 1000000.0;
+}
+
+double RecordingManager::sensorToRunSeconds(double sensorMicros) const
+{
+    // Replay sensor already uses replay clock
+    if(mReplay)
+        return sensorMicros / 1000000.0;
+    return (mSensorClock.toHostMicros(sensorMicros) - mRunStartMicros) / 1000000.0;
+}
+
 void RecordingManager::emergencyStop()
 {
     stop();
@@ -381,12 +871,28 @@ ISpeedSensor *RecordingManager::speedSensor() const
 void RecordingManager::setSpeedSensor(ISpeedSensor *newSpeedSensor)
 {
     if(mSpeedSensor)
-        disconnect(mSpeedSensor, &ISpeedSensor::speedReading, this, &RecordingManager::onNewSpeedReading);
+    {
+        disconnect(mSpeedSensor, &ISpeedSensor::readingsAvailable, this, &RecordingManager::onSpeedReadingsAvailable);
+        disconnect(mSpeedSensor, &ISpeedSensor::waveformAvailable, this, &RecordingManager::onSensorWaveformAvailable);
+    }
 
     mSpeedSensor = newSpeedSensor;
 
     if(mSpeedSensor)
-        connect(mSpeedSensor, &ISpeedSensor::speedReading, this, &RecordingManager::onNewSpeedReading);
+    {
+        // Only count readings lost from now on
+        mLastSensorOverruns = mSpeedSensor->overrunCount();
+
+        // Different clock
+        mSensorClock.reset();
+
+        connect(mSpeedSensor, &ISpeedSensor::readingsAvailable, this, &RecordingManager::onSpeedReadingsAvailable);
+        connect(mSpeedSensor, &ISpeedSensor::waveformAvailable, this, &RecordingManager::onSensorWaveformAvailable);
+
+        // Data published before connection would never be notified again
+        QMetaObject::invokeMethod(this, &RecordingManager::onSpeedReadingsAvailable, Qt::QueuedConnection);
+        QMetaObject::invokeMethod(this, &RecordingManager::onSensorWaveformAvailable, Qt::QueuedConnection);
+    }
 }
 
 ICommandStation *RecordingManager::commandStation() const
@@ -401,6 +907,7 @@ void RecordingManager::setCommandStation(ICommandStation *newCommandStation)
 
     mCommandStation = newCommandStation;
 
-    if(mCommandStation)
+    // Shared command station feedback is forwarded by session manager
+    if(mCommandStation && !(mSession && mSession->commandStation() == mCommandStation))
         connect(mCommandStation, &ICommandStation::locomotiveSpeedFeedback, this, &RecordingManager::onLocomotiveSpeedFeedback);
 }
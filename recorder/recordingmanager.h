@@ -2,12 +2,15 @@
 #define RECORDINGMANAGER_H
 
 #include <QObject>
-#include <QElapsedTimer>
 
 #include "../commandstation/utils.h"
+#include "clocksync.h"
+#include "steadystatedetector.h"
+#include "sweepplanner.h"
 
 class ICommandStation;
 class ISpeedSensor;
+struct SpeedSample;
 
 class IDataSeries;
 class RequestedSpeedStepSeries;
@@ -15,6 +18,10 @@ class ReceivedSpeedStepSeries;
 class RawSensorDataSeries;
 class SensorTravelledDistanceSeries;
 
+class CaptureWriter;
+class ReplayEngine;
+class RecordingSessionManager;
+
 class RecordingManager : public QObject
 {
     Q_OBJECT
@@ -61,11 +68,62 @@ public:
     int defaultStepTimeMillis() const;
     void setDefaultStepTimeMillis(int newDefaultStepTimeMillis);
 
+    // Go to next step as soon as speed is steady, but not before min
+    // and not after max step time. Default step time is not used
+    bool adaptiveStepTime() const;
+    void setAdaptiveStepTime(bool newAdaptiveStepTime);
+
+    int minStepTimeMillis() const;
+    void setMinStepTimeMillis(int newMinStepTimeMillis);
+
+    int maxStepTimeMillis() const;
+    void setMaxStepTimeMillis(int newMaxStepTimeMillis);
+
+    // Relative to mean speed, i.e. 0.02 is 2%
+    double steadySpeedTolerance() const;
+    void setSteadySpeedTolerance(double relativeTolerance);
+
+    // Measure only steps chosen by planner instead of all steps,
+    // result is saved as sparse speed mapping when run stops
+    bool sparseSweep() const;
+    void setSparseSweep(bool newSparseSweep);
+
+    SweepPlanner *sweepPlanner();
+
+    // Empty to not save speed mapping of sparse sweep
+    QString speedMappingFileName() const;
+    void setSpeedMappingFileName(const QString &newSpeedMappingFileName);
+
+    // Record each block of steps forward and then again in reverse,
+    // so locomotive comes back and a short track is enough.
+    // Reverse steps are stored as negative values in step series
+    bool bidirectional() const;
+    void setBidirectional(bool newBidirectional);
+
+    int directionBlockSize() const;
+    void setDirectionBlockSize(int newDirectionBlockSize);
+
     void goToNextStep();
     void setCustomTimeForCurrentStep(int millis);
 
     State state() const;
 
+    // Stream next runs to this file, empty to disable
+    QString captureFileName() const;
+    void setCaptureFileName(const QString &newCaptureFileName);
+
+    // When set, next run follows recorded steps and clock of replay engine
+    // Sensor and command station should be the replay ones
+    ReplayEngine *replayEngine() const;
+    void setReplayEngine(ReplayEngine *newReplayEngine);
+
+    // Sensor readings dropped during current or last run
+    // because we did not drain them fast enough
+    quint64 lostSensorReadings() const;
+
+    // Set when recording together with other sessions
+    inline RecordingSessionManager *session() const { return mSession; }
+
 signals:
     void seriesRegistered(IDataSeries *s);
     void seriesUnregistered(IDataSeries *s);
@@ -77,19 +135,38 @@ public slots:
     void emergencyStop();
 
 private slots:
-    void onNewSpeedReading(double metersPerSecond, double travelledMillimeters, qint64 timestampMilliSec);
-    void onLocomotiveSpeedFeedback(int address, int speedStep, LocomotiveDirection direction);
+    void onSpeedReadingsAvailable();
+    void onSensorWaveformAvailable();
+    void onLocomotiveSpeedFeedback(int address, int speedStep, LocomotiveDirection direction,
+                                   bool wasQueued, qint64 hostMicros);
 
     void onSeriesDestroyed(QObject *s);
 
+    void onReplayStepRequested(int step);
+    void onReplayFinished();
+
 private:
-    void requestStepInternal(int step);
+    friend class RecordingSessionManager;
+
+    void requestStepInternal(int step, LocomotiveDirection direction);
+    void advanceStep();
+    void saveSpeedMapping();
 
     void setState(State newState);
 
     void tryStopInternal();
     void stopInternal();
 
+    void addSpeedReadings(const SpeedSample *samples, int count);
+    void endSensorBatch();
+
+    int stepTimerMillis() const;
+
+    // All points use host clock, relative to run start.
+    // Sensor times are mapped on host clock by mSensorClock
+    double hostToRunSeconds(qint64 hostMicros) const;
+    double sensorToRunSeconds(double sensorMicros) const;
+
 private:
     ICommandStation *mCommandStation = nullptr;
     ISpeedSensor *mSpeedSensor = nullptr;
@@ -97,17 +174,44 @@ private:
     int locomotiveDCCAddress = 3;
     int requestedDCCStep = 0;
     int actualDCCStep = 0;
+    LocomotiveDirection requestedDirection = LocomotiveDirection::Forward;
+    LocomotiveDirection actualDirection = LocomotiveDirection::Forward;
     bool mReqStepIsPending = false;
 
     int mStartingDCCStep = 1;
     int mDefaultStepTimeMillis = 3000;
     bool currentTimerIsCustom = false;
 
+    bool mAdaptiveStepTime = false;
+    int mMinStepTimeMillis = 1000;
+    int mMaxStepTimeMillis = 10000;
+    SteadyStateDetector mSteadyDetector;
+    double mStepStartSeconds = 0;
+
+    bool mBidirectional = false;
+    int mDirectionBlockSize = 4;
+    int mBlockFirstStep = 1;
+
+    bool mSparseSweep = false;
+    SweepPlanner mSweepPlanner;
+    QMap<int, double> mReverseMeasurements;
+
+    // Forward pass of bidirectional sparse step, stored with reverse one
+    bool mForwardSteady = false;
+    double mForwardSpeed = 0;
+    QString mSpeedMappingFileName;
+
     int mStepTimerId = 0;
-    qint64 mStartTimestamp = -1;
 
     int mForceStopTimerId = 0;
 
+    // Sensor readings arriving within this window are notified together
+    int mSensorBatchMillis = 50;
+    int mSensorBatchTimerId = 0;
+
+    quint64 mLastSensorOverruns = 0;
+    quint64 mLostSensorReadings = 0;
+
     QVector<IDataSeries *> mSeries;
 
     RequestedSpeedStepSeries *mReqStepSeries;
@@ -117,7 +221,15 @@ private:
 
     State mState = State::Stopped;
 
-    QElapsedTimer mElapsed;
+    qint64 mRunStartMicros = 0;
+    ClockSync mSensorClock;
+
+    QString mCaptureFileName;
+    CaptureWriter *mCapture = nullptr;
+
+    ReplayEngine *mReplay = nullptr;
+
+    RecordingSessionManager *mSession = nullptr;
 };
 
 #endif // RECORDINGMANAGER_H
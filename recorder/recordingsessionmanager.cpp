@@ -0,0 +1,166 @@
+#include "recordingsessionmanager.h"
+
+#include "recordingmanager.h"
+
+#include "../commandstation/icommandstation.h"
+
+#include <QDebug>
+
+RecordingSessionManager::RecordingSessionManager(QObject *parent)
+    : QObject{parent}
+{
+
+}
+
+RecordingSessionManager::~RecordingSessionManager()
+{
+    // Sessions outliving us connect to command station directly again
+    while(!mSessions.isEmpty())
+        removeSession(mSessions.last());
+}
+
+bool RecordingSessionManager::addSession(RecordingManager *session)
+{
+    if(mSessions.contains(session))
+        return true;
+
+    RecordingManager *other = sessionForAddress(session->getLocomotiveDCCAddress());
+    if(other)
+    {
+        qWarning() << "Locomotive" << session->getLocomotiveDCCAddress() << "is already recorded by another session";
+        return false;
+    }
+
+    if(session->mSession)
+        session->mSession->removeSession(session);
+
+    // Drop direct connection, feedback will come from us
+    session->setCommandStation(nullptr);
+    session->mSession = this;
+    session->setCommandStation(mCommandStation);
+
+    connect(session, &QObject::destroyed, this, &RecordingSessionManager::onSessionDestroyed);
+    mSessions.append(session);
+
+    emit sessionsChanged();
+    return true;
+}
+
+void RecordingSessionManager::removeSession(RecordingManager *session)
+{
+    if(!mSessions.removeOne(session))
+        return;
+
+    disconnect(session, &QObject::destroyed, this, &RecordingSessionManager::onSessionDestroyed);
+
+    ICommandStation *station = session->commandStation();
+    session->setCommandStation(nullptr);
+    session->mSession = nullptr;
+    session->setCommandStation(station);
+
+    emit sessionsChanged();
+}
+
+RecordingManager *RecordingSessionManager::sessionForAddress(int address) const
+{
+    for(RecordingManager *session : mSessions)
+    {
+        if(session->getLocomotiveDCCAddress() == address)
+            return session;
+    }
+    return nullptr;
+}
+
+ICommandStation *RecordingSessionManager::commandStation() const
+{
+    return mCommandStation;
+}
+
+void RecordingSessionManager::setCommandStation(ICommandStation *newCommandStation)
+{
+    ICommandStation *oldCommandStation = mCommandStation;
+
+    if(mCommandStation)
+        disconnect(mCommandStation, &ICommandStation::locomotiveSpeedFeedback, this, &RecordingSessionManager::onLocomotiveSpeedFeedback);
+
+    mCommandStation = newCommandStation;
+
+    if(mCommandStation)
+        connect(mCommandStation, &ICommandStation::locomotiveSpeedFeedback, this, &RecordingSessionManager::onLocomotiveSpeedFeedback);
+
+    for(RecordingManager *session : std::as_const(mSessions))
+    {
+        // Leave sessions which are replaying a capture alone
+        if(session->commandStation() == oldCommandStation)
+            session->setCommandStation(mCommandStation);
+    }
+}
+
+int RecordingSessionManager::runningCount() const
+{
+    int count = 0;
+    for(RecordingManager *session : mSessions)
+    {
+        if(session->state() != RecordingManager::State::Stopped)
+            count++;
+    }
+    return count;
+}
+
+bool RecordingSessionManager::startAll()
+{
+    if(runningCount() > 0)
+        return false;
+
+    // Feedback could not be told apart
+    for(int i = 0; i < mSessions.size(); i++)
+    {
+        const int address = mSessions.at(i)->getLocomotiveDCCAddress();
+        for(int j = i + 1; j < mSessions.size(); j++)
+        {
+            if(mSessions.at(j)->getLocomotiveDCCAddress() == address)
+            {
+                qWarning() << "Cannot start sessions, locomotive" << address << "is used twice";
+                return false;
+            }
+        }
+    }
+
+    bool ok = true;
+    for(RecordingManager *session : std::as_const(mSessions))
+    {
+        if(!session->start())
+            ok = false;
+    }
+
+    return ok;
+}
+
+void RecordingSessionManager::stopAll()
+{
+    for(RecordingManager *session : std::as_const(mSessions))
+        session->stop();
+}
+
+void RecordingSessionManager::emergencyStopAll()
+{
+    for(RecordingManager *session : std::as_const(mSessions))
+        session->emergencyStop();
+}
+
+void RecordingSessionManager::onLocomotiveSpeedFeedback(int address, int speedStep, LocomotiveDirection direction,
+                                                        bool wasQueued, qint64 hostMicros)
+{
+    RecordingManager *session = sessionForAddress(address);
+    if(!session || session->commandStation() != mCommandStation)
+        return;
+
+    session->onLocomotiveSpeedFeedback(address, speedStep, direction, wasQueued, hostMicros);
+}
+
+void RecordingSessionManager::onSessionDestroyed(QObject *obj)
+{
+    // Already destroyed, only remove pointer
+    if(mSessions.removeOne(static_cast<RecordingManager *>(obj)))
+        emit sessionsChanged();
+}
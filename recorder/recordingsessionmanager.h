@@ -0,0 +1,58 @@
+#ifndef RECORDINGSESSIONMANAGER_H
+#define RECORDINGSESSIONMANAGER_H
+
+#include <QObject>
+#include <QVector>
+
+#include "../commandstation/utils.h"
+
+class ICommandStation;
+class RecordingManager;
+
+// Runs several RecordingManager sessions at the same time, one for each
+// measuring section, each with its own locomotive address, sensor and series.
+// Sessions share one command station: feedback is received once here
+// and forwarded to the session recording that address.
+// Must live in same thread of its sessions.
+class RecordingSessionManager : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RecordingSessionManager(QObject *parent = nullptr);
+    ~RecordingSessionManager();
+
+    // Session command station is replaced by the shared one
+    bool addSession(RecordingManager *session);
+    void removeSession(RecordingManager *session);
+
+    inline const QVector<RecordingManager *>& sessions() const { return mSessions; }
+
+    // Session recording this address, if any
+    RecordingManager *sessionForAddress(int address) const;
+
+    ICommandStation *commandStation() const;
+    void setCommandStation(ICommandStation *newCommandStation);
+
+    int runningCount() const;
+
+public slots:
+    // Fails if a session is running or two sessions share an address
+    bool startAll();
+    void stopAll();
+    void emergencyStopAll();
+
+signals:
+    void sessionsChanged();
+
+private slots:
+    void onLocomotiveSpeedFeedback(int address, int speedStep, LocomotiveDirection direction,
+                                   bool wasQueued, qint64 hostMicros);
+    void onSessionDestroyed(QObject *obj);
+
+private:
+    ICommandStation *mCommandStation = nullptr;
+
+    QVector<RecordingManager *> mSessions;
+};
+
+#endif // RECORDINGSESSIONMANAGER_H
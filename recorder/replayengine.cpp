@@ -0,0 +1,267 @@
+#include "replayengine.h"
+
+#include "../input/replayspeedsensor.h"
+#include "../commandstation/replaycommandstation.h"
+
+#include <QTimerEvent>
+
+#include <limits>
+
+// Real time pacing resolution
+static constexpr int ReplayTickMillis = 10;
+
+// Events dispatched before returning to event loop when not paced
+static constexpr int MaxEventsPerTick = 4096;
+
+void ReplayEngine::Cursor::reset(const QVector<CaptureReader::Chunk> &newChunks)
+{
+    chunks = newChunks;
+    chunkIdx = 0;
+    row = 0;
+
+    // Skip empty chunks
+    while(chunkIdx < chunks.size() && chunks.at(chunkIdx).count == 0)
+        chunkIdx++;
+}
+
+void ReplayEngine::Cursor::advance()
+{
+    row++;
+    while(chunkIdx < chunks.size() && row >= chunks.at(chunkIdx).count)
+    {
+        chunkIdx++;
+        row = 0;
+    }
+}
+
+ReplayEngine::ReplayEngine(QObject *parent)
+    : QObject{parent}
+{
+    mSpeedSensor = new ReplaySpeedSensor(this);
+    mCommandStation = new ReplayCommandStation(this);
+}
+
+ReplayEngine::~ReplayEngine()
+{
+    close();
+}
+
+bool ReplayEngine::open(const QString &fileName)
+{
+    close();
+
+    if(!mReader.open(fileName))
+        return false;
+
+    rewind();
+    return true;
+}
+
+void ReplayEngine::close()
+{
+    stop();
+
+    // Cursors point to mapped memory
+    mSpeed.reset({});
+    mTravelled.reset({});
+    mReqStep.reset({});
+    mFeedback.reset({});
+
+    mReader.close();
+}
+
+QString ReplayEngine::errorString() const
+{
+    return mReader.errorString();
+}
+
+const CaptureReader *ReplayEngine::reader() const
+{
+    return &mReader;
+}
+
+ReplaySpeedSensor *ReplayEngine::speedSensor() const
+{
+    return mSpeedSensor;
+}
+
+ReplayCommandStation *ReplayEngine::commandStation() const
+{
+    return mCommandStation;
+}
+
+ReplayEngine::Pacing ReplayEngine::pacing() const
+{
+    return mPacing;
+}
+
+double ReplayEngine::speedFactor() const
+{
+    return mSpeedFactor;
+}
+
+void ReplayEngine::setPacing(Pacing newPacing, double newSpeedFactor)
+{
+    mPacing = newPacing;
+    mSpeedFactor = qMax(newSpeedFactor, 0.01);
+}
+
+qint64 ReplayEngine::elapsedMillis() const
+{
+    return mCurrentMicros / 1000;
+}
+
+void ReplayEngine::timerEvent(QTimerEvent *e)
+{
+    if(e->timerId() == mTimerId && mTimerId)
+    {
+        if(mPacing == Pacing::AsFastAsPossible)
+        {
+            const double noLimit = std::numeric_limits<double>::infinity();
+            for(int i = 0; i < MaxEventsPerTick && mRunning; i++)
+            {
+                if(!dispatchNext(noLimit))
+                    break;
+            }
+        }
+        else
+        {
+            double factor = mPacing == Pacing::Scaled ? mSpeedFactor : 1.0;
+            const double untilSeconds = mWallClock.elapsed() / 1000.0 * factor;
+            while(mRunning && dispatchNext(untilSeconds))
+                ;
+        }
+
+        if(mRunning && isAtEnd())
+            finish();
+        return;
+    }
+
+    QObject::timerEvent(e);
+}
+
+void ReplayEngine::start()
+{
+    stop();
+
+    if(!isOpen())
+        return;
+
+    rewind();
+    mRunning = true;
+
+    if(mPacing == Pacing::AsFastAsPossible)
+        mTimerId = startTimer(0);
+    else
+        mTimerId = startTimer(ReplayTickMillis, Qt::PreciseTimer);
+
+    mWallClock.start();
+}
+
+void ReplayEngine::stop()
+{
+    if(mTimerId)
+    {
+        killTimer(mTimerId);
+        mTimerId = 0;
+    }
+
+    mRunning = false;
+}
+
+void ReplayEngine::runToEnd()
+{
+    if(!mRunning)
+        return;
+
+    if(mTimerId)
+    {
+        killTimer(mTimerId);
+        mTimerId = 0;
+    }
+
+    const double noLimit = std::numeric_limits<double>::infinity();
+    while(mRunning && dispatchNext(noLimit))
+        ;
+
+    if(mRunning)
+        finish();
+}
+
+void ReplayEngine::rewind()
+{
+    mSpeed.reset(mReader.chunks(CaptureFile::RawSpeed));
+    mTravelled.reset(mReader.chunks(CaptureFile::TravelledDistance));
+    mReqStep.reset(mReader.chunks(CaptureFile::RequestedStep));
+    mFeedback.reset(mReader.chunks(CaptureFile::LocoFeedback));
+    mCurrentMicros = 0;
+}
+
+bool ReplayEngine::dispatchNext(double untilSeconds)
+{
+    // Pick earliest event, on same time keep order in which
+    // RecordingManager usually records them: request, feedback, sensor
+    Cursor *next = nullptr;
+    double nextTime = untilSeconds;
+
+    for(Cursor *c : {&mReqStep, &mFeedback, &mSpeed})
+    {
+        if(c->atEnd() || (c == &mSpeed && mTravelled.atEnd()))
+            continue;
+
+        const double t = c->time();
+        if(next ? t < nextTime : t <= nextTime)
+        {
+            next = c;
+            nextTime = t;
+        }
+    }
+
+    if(!next)
+        return false;
+
+    mCurrentMicros = qRound64(nextTime * 1000000.0);
+
+    if(next == &mReqStep)
+    {
+        // Requests are stored as old step, new step pairs
+        mReqStep.advance();
+        if(mReqStep.atEnd())
+            return true; // Truncated capture, drop last half pair
+
+        const int step = int(mReqStep.value(1));
+        mReqStep.advance();
+        emit stepRequested(step);
+    }
+    else if(next == &mFeedback)
+    {
+        const int address = int(mFeedback.value(1));
+        const int step = int(mFeedback.value(2));
+        const LocomotiveDirection direction = LocomotiveDirection(int(mFeedback.value(3)));
+        mFeedback.advance();
+        mCommandStation->replayFeedback(address, step, direction);
+    }
+    else
+    {
+        // Raw speed and travelled distance are recorded together
+        const double metersPerSecond = mSpeed.value(1);
+        const double travelledMillimeters = mTravelled.value(1);
+        mSpeed.advance();
+        mTravelled.advance();
+        mSpeedSensor->replayReading(metersPerSecond, travelledMillimeters, mCurrentMicros);
+    }
+
+    return true;
+}
+
+bool ReplayEngine::isAtEnd() const
+{
+    const bool sensorAtEnd = mSpeed.atEnd() || mTravelled.atEnd();
+    return sensorAtEnd && mReqStep.atEnd() && mFeedback.atEnd();
+}
+
+void ReplayEngine::finish()
+{
+    stop();
+    emit finished();
+}
@@ -0,0 +1,113 @@
+#ifndef REPLAYENGINE_H
+#define REPLAYENGINE_H
+
+#include <QObject>
+#include <QElapsedTimer>
+
+#include "capturereader.h"
+
+class ReplaySpeedSensor;
+class ReplayCommandStation;
+
+// Plays back a capture file (see capturefile.h) through a replay sensor
+// and command station, so RecordingManager and all derived series can be
+// run again on past data without a layout.
+// Events are dispatched in recording order, the replay clock is set to
+// event time before each dispatch so results do not depend on pacing.
+class ReplayEngine : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Pacing
+    {
+        RealTime = 0,
+        Scaled,           // Real time multiplied by speed factor
+        AsFastAsPossible  // Big batches, event loop still runs between them
+    };
+
+    explicit ReplayEngine(QObject *parent = nullptr);
+    ~ReplayEngine();
+
+    bool open(const QString& fileName);
+    void close();
+
+    inline bool isOpen() const { return mReader.isOpen(); }
+    QString errorString() const;
+
+    const CaptureReader *reader() const;
+
+    ReplaySpeedSensor *speedSensor() const;
+    ReplayCommandStation *commandStation() const;
+
+    Pacing pacing() const;
+    double speedFactor() const;
+
+    // Takes effect on next start
+    void setPacing(Pacing newPacing, double newSpeedFactor = 1.0);
+
+    // Replay clock, time of last dispatched event since run start.
+    // Micros keep sub millisecond sensor timestamps, millis are for display
+    inline qint64 elapsedMicros() const { return mCurrentMicros; }
+    qint64 elapsedMillis() const;
+
+    inline bool isRunning() const { return mRunning; }
+
+    void timerEvent(QTimerEvent *e) override;
+
+signals:
+    // Recorded step request, emitted before it's feedback
+    // Negative step means reverse direction
+    void stepRequested(int step);
+
+    // All events were dispatched
+    void finished();
+
+public slots:
+    void start();
+    void stop();
+
+    // Dispatch all remaining events now, ignoring pacing.
+    // Useful to benchmark analysis chain
+    void runToEnd();
+
+private:
+    struct Cursor
+    {
+        QVector<CaptureReader::Chunk> chunks;
+        int chunkIdx = 0;
+        int row = 0;
+
+        void reset(const QVector<CaptureReader::Chunk> &newChunks);
+        void advance();
+
+        inline bool atEnd() const { return chunkIdx >= chunks.size(); }
+        inline double value(int column) const { return chunks.at(chunkIdx).column(column)[row]; }
+        inline double time() const { return value(0); }
+    };
+
+    void rewind();
+    bool dispatchNext(double untilSeconds);
+    bool isAtEnd() const;
+    void finish();
+
+private:
+    CaptureReader mReader;
+
+    ReplaySpeedSensor *mSpeedSensor;
+    ReplayCommandStation *mCommandStation;
+
+    Cursor mSpeed;
+    Cursor mTravelled;
+    Cursor mReqStep;
+    Cursor mFeedback;
+
+    Pacing mPacing = Pacing::RealTime;
+    double mSpeedFactor = 1.0;
+
+    int mTimerId = 0;
+    QElapsedTimer mWallClock;
+    qint64 mCurrentMicros = 0;
+    bool mRunning = false;
+};
+
+#endif // REPLAYENGINE_H
@@ -0,0 +1,84 @@
+#include "capturedseries.h"
+
+#include <algorithm>
+
+CapturedSeries::CapturedSeries(DataSeriesType type, QObject *parent)
+    : IDataSeries{parent}
+    , mType(type)
+{
+    setName(tr("Captured %1").arg(trType(mType)));
+}
+
+DataSeriesType CapturedSeries::getType() const
+{
+    return mType;
+}
+
+int CapturedSeries::getPointCount() const
+{
+    return mPointCount;
+}
+
+QPointF CapturedSeries::getPointAt(int index) const
+{
+    const int chunkIdx = chunkForIndex(index);
+    if(chunkIdx < 0)
+        return QPointF();
+
+    const Chunk& chunk = mChunks.at(chunkIdx);
+    const int i = index - chunk.first;
+    return QPointF(chunk.x[i], chunk.y[i]);
+}
+
+QString CapturedSeries::getPointTooltip(int index) const
+{
+    if(index < 0 || index >= mPointCount)
+        return QString();
+
+    return IDataSeries::defaultTooltip(name(), index, getPointAt(index));
+}
+
+DataSeriesSpan CapturedSeries::getSpan(int first, int count) const
+{
+    DataSeriesSpan span;
+
+    const int chunkIdx = chunkForIndex(first);
+    if(chunkIdx < 0 || count <= 0)
+        return span;
+
+    // Span cannot cross chunk boundary
+    const Chunk& chunk = mChunks.at(chunkIdx);
+    const int offset = first - chunk.first;
+
+    span.first = first;
+    span.count = qMin(count, chunk.count - offset);
+    span.x = chunk.x + offset;
+    span.y = chunk.y + offset;
+    return span;
+}
+
+void CapturedSeries::addChunk(const double *x, const double *y, int count)
+{
+    if(count <= 0)
+        return;
+
+    Chunk chunk;
+    chunk.x = x;
+    chunk.y = y;
+    chunk.first = mPointCount;
+    chunk.count = count;
+    mChunks.append(chunk);
+
+    mPointCount += count;
+    notifyPointsAppended(chunk.first, count);
+}
+
+int CapturedSeries::chunkForIndex(int index) const
+{
+    if(index < 0 || index >= mPointCount)
+        return -1;
+
+    auto it = std::upper_bound(mChunks.cbegin(), mChunks.cend(), index,
+                               [](int idx, const Chunk& chunk) { return idx < chunk.first; });
+    return int(it - mChunks.cbegin()) - 1;
+}
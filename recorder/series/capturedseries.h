@@ -0,0 +1,41 @@
+#ifndef CAPTUREDSERIES_H
+#define CAPTUREDSERIES_H
+
+#include "../idataseries.h"
+
+#include <QVector>
+
+// Read only series over chunks of external memory (i.e. a mapped capture file)
+class CapturedSeries : public IDataSeries
+{
+    Q_OBJECT
+public:
+    explicit CapturedSeries(DataSeriesType type, QObject *parent = nullptr);
+
+    DataSeriesType getType() const override;
+    int getPointCount() const override;
+    QPointF getPointAt(int index) const override;
+    QString getPointTooltip(int index) const override;
+    DataSeriesSpan getSpan(int first, int count) const override;
+
+    // Memory must stay valid for series lifetime
+    void addChunk(const double *x, const double *y, int count);
+
+private:
+    int chunkForIndex(int index) const;
+
+private:
+    struct Chunk
+    {
+        const double *x;
+        const double *y;
+        int first;
+        int count;
+    };
+    QVector<Chunk> mChunks;
+
+    DataSeriesType mType;
+    int mPointCount = 0;
+};
+
+#endif // CAPTUREDSERIES_H
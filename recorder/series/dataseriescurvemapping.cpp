@@ -8,9 +8,45 @@ DataSeriesCurveMapping::DataSeriesCurveMapping(QObject *parent)
     setName(tr("Mapping"));
 }
 
-void DataSeriesCurveMapping::onSourcePointAdded(int indexAdded, const QPointF &point)
+void DataSeriesCurveMapping::onSourcePointsAppended()
 {
+    const int oldCount = mPoints.count();
     mLastSourceIdx = calculateAvg(mLastSourceIdx);
+    notifyPointsAppended(oldCount, mPoints.count() - oldCount);
+}
+
+void DataSeriesCurveMapping::onSourcePointsChanged(int first, int count)
+{
+    // Each point maps on its own, update only changed ones
+    const int last = qMin(first + count, mPoints.count()) - 1;
+    remapRange(first, last);
+    notifyPointsChanged(first, last - first + 1);
+}
+
+void DataSeriesCurveMapping::onSourcePointsRemoved(int first, int count)
+{
+    if(first >= mPoints.count())
+        return;
+
+    count = qMin(count, mPoints.count() - first);
+    mPoints.remove(first, count);
+
+    if(mLastSourceIdx > first)
+        mLastSourceIdx = qMax(first, mLastSourceIdx - count);
+
+    notifyPointsRemoved(first, count);
+}
+
+void DataSeriesCurveMapping::onRecvStepPointsAppended(int first)
+{
+    // A late step change can affect samples already mapped after it
+    remapFromRecvStep(first);
+}
+
+void DataSeriesCurveMapping::onRecvStepPointsChanged(int first)
+{
+    // Previous step interval end might have changed too
+    remapFromRecvStep(qMax(0, first - 1));
 }
 
 void DataSeriesCurveMapping::onSourceDestroyed(QObject *source)
@@ -22,25 +58,20 @@ void DataSeriesCurveMapping::onSourceDestroyed(QObject *source)
     else
         return;
 
-    int oldSize = mPoints.size();
-    for(int i = oldSize - 1; i >= 0; i--)
-    {
-        emit pointRemoved(i);
-    }
     mPoints.clear();
+    mInterval = DataSeriesStepInterval();
+    notifyReset();
 }
 
 void DataSeriesCurveMapping::recalculate()
 {
-    int oldSize = mPoints.size();
-    for(int i = oldSize - 1; i >= 0; i--)
-    {
-        emit pointRemoved(i);
-    }
     mPoints.clear();
+    mInterval = DataSeriesStepInterval();
 
     mLastSourceIdx = 0;
     mLastSourceIdx = calculateAvg(mLastSourceIdx);
+
+    notifyReset();
 }
 
 int DataSeriesCurveMapping::calculateAvg(int fromSourceIdx)
@@ -49,35 +80,83 @@ int DataSeriesCurveMapping::calculateAvg(int fromSourceIdx)
         return fromSourceIdx;
 
     int sourceIdx = fromSourceIdx;
-    int recvIdx = 0;
 
-    int step = 0;
+    const int sourceCount = mSource->getPointCount();
+    mPoints.reserve(sourceCount);
 
-    for(; sourceIdx < mSource->getPointCount(); sourceIdx++)
+    while(sourceIdx < sourceCount)
     {
-        QPointF pt = mSource->getPointAt(sourceIdx);
+        // Iterate source memory directly
+        const DataSeriesSpan span = mSource->getSpan(sourceIdx, sourceCount - sourceIdx);
+        if(!span.count)
+            break;
 
-        for(; recvIdx < mRecvStepSeries->getPointCount(); recvIdx++)
+        for(int i = 0; i < span.count; i++)
         {
-            QPointF stepPt = mRecvStepSeries->getPointAt(recvIdx);
+            const double ptX = span.x[i];
 
-            if(stepPt.x() > pt.x())
+            if(ptX < mInterval.start || ptX >= mInterval.end)
             {
-                recvIdx--;
-                break;
+                // Step changed, find new one
+                mInterval = mRecvStepSeries->stepIntervalAt(ptX);
             }
 
-            step = int(stepPt.y());
+            mPoints.append(mInterval.step, span.y[i]);
         }
 
-        QPointF result(step, pt.y());
-        mPoints.append(result);
-        emit pointAdded(mPoints.size() - 1, result);
+        sourceIdx += span.count;
     }
 
     return sourceIdx;
 }
 
+void DataSeriesCurveMapping::remapRange(int first, int last)
+{
+    if(!mSource || !mRecvStepSeries)
+        return;
+
+    int sourceIdx = first;
+    while(sourceIdx <= last)
+    {
+        const DataSeriesSpan span = mSource->getSpan(sourceIdx, last - sourceIdx + 1);
+        if(!span.count)
+            break;
+
+        for(int i = 0; i < span.count; i++)
+        {
+            const double ptX = span.x[i];
+
+            if(ptX < mInterval.start || ptX >= mInterval.end)
+                mInterval = mRecvStepSeries->stepIntervalAt(ptX);
+
+            mPoints.replace(sourceIdx + i, mInterval.step, span.y[i]);
+        }
+
+        sourceIdx += span.count;
+    }
+}
+
+void DataSeriesCurveMapping::remapFromRecvStep(int recvIdx)
+{
+    // Cached interval is not valid anymore
+    mInterval = DataSeriesStepInterval();
+
+    if(!mSource || !mRecvStepSeries)
+        return;
+
+    // Remap samples from this step time onwards
+    recvIdx = qMin(recvIdx, mRecvStepSeries->getPointCount() - 1);
+    int first = 0;
+    if(recvIdx >= 0)
+        first = mSource->lowerBoundByX(mRecvStepSeries->getPointAt(recvIdx).x());
+    const int last = mPoints.count() - 1;
+    if(first > last)
+        return;
+
+    remapRange(first, last);
+    notifyPointsChanged(first, last - first + 1);
+}
+
 IDataSeries *DataSeriesCurveMapping::recvStep() const
 {
     return mRecvStepSeries;
@@ -87,8 +166,10 @@ void DataSeriesCurveMapping::setRecvStep(IDataSeries *newRecvStep)
 {
     if(mRecvStepSeries)
     {
-        disconnect(mRecvStepSeries, &IDataSeries::pointChanged, this, &DataSeriesCurveMapping::recalculate);
-        disconnect(mRecvStepSeries, &IDataSeries::pointRemoved, this, &DataSeriesCurveMapping::recalculate);
+        disconnect(mRecvStepSeries, &IDataSeries::pointsAppended, this, &DataSeriesCurveMapping::onRecvStepPointsAppended);
+        disconnect(mRecvStepSeries, &IDataSeries::pointsChanged, this, &DataSeriesCurveMapping::onRecvStepPointsChanged);
+        disconnect(mRecvStepSeries, &IDataSeries::pointsRemoved, this, &DataSeriesCurveMapping::onRecvStepPointsChanged);
+        disconnect(mRecvStepSeries, &IDataSeries::reset, this, &DataSeriesCurveMapping::recalculate);
         disconnect(mRecvStepSeries, &QObject::destroyed, this, &DataSeriesCurveMapping::onSourceDestroyed);
     }
 
@@ -96,8 +177,10 @@ void DataSeriesCurveMapping::setRecvStep(IDataSeries *newRecvStep)
 
     if(mRecvStepSeries)
     {
-        connect(mRecvStepSeries, &IDataSeries::pointChanged, this, &DataSeriesCurveMapping::recalculate);
-        connect(mRecvStepSeries, &IDataSeries::pointRemoved, this, &DataSeriesCurveMapping::recalculate);
+        connect(mRecvStepSeries, &IDataSeries::pointsAppended, this, &DataSeriesCurveMapping::onRecvStepPointsAppended);
+        connect(mRecvStepSeries, &IDataSeries::pointsChanged, this, &DataSeriesCurveMapping::onRecvStepPointsChanged);
+        connect(mRecvStepSeries, &IDataSeries::pointsRemoved, this, &DataSeriesCurveMapping::onRecvStepPointsChanged);
+        connect(mRecvStepSeries, &IDataSeries::reset, this, &DataSeriesCurveMapping::recalculate);
         connect(mRecvStepSeries, &QObject::destroyed, this, &DataSeriesCurveMapping::onSourceDestroyed);
     }
 
@@ -113,9 +196,10 @@ void DataSeriesCurveMapping::setSource(IDataSeries *newSource)
 {
     if(mSource)
     {
-        disconnect(mSource, &IDataSeries::pointAdded, this, &DataSeriesCurveMapping::onSourcePointAdded);
-        disconnect(mSource, &IDataSeries::pointChanged, this, &DataSeriesCurveMapping::recalculate);
-        disconnect(mSource, &IDataSeries::pointRemoved, this, &DataSeriesCurveMapping::recalculate);
+        disconnect(mSource, &IDataSeries::pointsAppended, this, &DataSeriesCurveMapping::onSourcePointsAppended);
+        disconnect(mSource, &IDataSeries::pointsChanged, this, &DataSeriesCurveMapping::onSourcePointsChanged);
+        disconnect(mSource, &IDataSeries::pointsRemoved, this, &DataSeriesCurveMapping::onSourcePointsRemoved);
+        disconnect(mSource, &IDataSeries::reset, this, &DataSeriesCurveMapping::recalculate);
         disconnect(mSource, &QObject::destroyed, this, &DataSeriesCurveMapping::onSourceDestroyed);
     }
 
@@ -125,9 +209,10 @@ void DataSeriesCurveMapping::setSource(IDataSeries *newSource)
     {
         setName(mSource->name());
 
-        connect(mSource, &IDataSeries::pointAdded, this, &DataSeriesCurveMapping::onSourcePointAdded);
-        connect(mSource, &IDataSeries::pointChanged, this, &DataSeriesCurveMapping::recalculate);
-        connect(mSource, &IDataSeries::pointRemoved, this, &DataSeriesCurveMapping::recalculate);
+        connect(mSource, &IDataSeries::pointsAppended, this, &DataSeriesCurveMapping::onSourcePointsAppended);
+        connect(mSource, &IDataSeries::pointsChanged, this, &DataSeriesCurveMapping::onSourcePointsChanged);
+        connect(mSource, &IDataSeries::pointsRemoved, this, &DataSeriesCurveMapping::onSourcePointsRemoved);
+        connect(mSource, &IDataSeries::reset, this, &DataSeriesCurveMapping::recalculate);
         connect(mSource, &QObject::destroyed, this, &DataSeriesCurveMapping::onSourceDestroyed);
     }
 
@@ -141,20 +226,25 @@ DataSeriesType DataSeriesCurveMapping::getType() const
 
 int DataSeriesCurveMapping::getPointCount() const
 {
-    return mPoints.size();
+    return mPoints.count();
 }
 
 QPointF DataSeriesCurveMapping::getPointAt(int index) const
 {
-    return mPoints.value(index, QPointF());
+    return mPoints.value(index);
 }
 
 QString DataSeriesCurveMapping::getPointTooltip(int index) const
 {
-    if(!mSource || index < 0 || index >= mPoints.size())
+    if(!mSource || index < 0 || index >= mPoints.count())
         return QString();
 
 
     QString fullName = name() + QLatin1String(" (%1)").arg(mSource->name());
     return IDataSeries::defaultTooltip(fullName, index, mPoints.at(index));
 }
+
+DataSeriesSpan DataSeriesCurveMapping::getSpan(int first, int count) const
+{
+    return mPoints.span(first, count);
+}
@@ -3,8 +3,6 @@
 
 #include "../idataseries.h"
 
-#include <QVector>
-
 class DataSeriesCurveMapping : public IDataSeries
 {
     Q_OBJECT
@@ -18,26 +16,36 @@ public:
     int getPointCount() const override;
     QPointF getPointAt(int index) const override;
     QString getPointTooltip(int index) const override;
+    DataSeriesSpan getSpan(int first, int count) const override;
 
     IDataSeries *recvStep() const;
     void setRecvStep(IDataSeries *newRecvStep);
 
 private slots:
-    void onSourcePointAdded(int index, const QPointF& point);
+    void onSourcePointsAppended();
+    void onSourcePointsChanged(int first, int count);
+    void onSourcePointsRemoved(int first, int count);
+    void onRecvStepPointsAppended(int first);
+    void onRecvStepPointsChanged(int first);
     void onSourceDestroyed(QObject *source);
 
     void recalculate();
 
 private:
     int calculateAvg(int fromSourceIdx);
+    void remapRange(int first, int last);
+    void remapFromRecvStep(int recvIdx);
 
 private:
     IDataSeries *mSource;
     IDataSeries *mRecvStepSeries;
 
-    QVector<QPointF> mPoints;
+    DataSeriesStorage mPoints;
 
     int mLastSourceIdx = 0;
+
+    // Step cursor, kept between calls while received steps do not change
+    DataSeriesStepInterval mInterval;
 };
 
 #endif // DATASERIESCURVEMAPPING_H
@@ -1,106 +1,235 @@
 #include "movingaverageseries.h"
 
-MovingAverageSeries::MovingAverageSeries(int windowSize, QObject *parent)
+MovingAverageSeries::MovingAverageSeries(int windowSize, Alignment alignment, QObject *parent)
     : IDataSeries{parent}
     , mSource(nullptr)
-    , mWindowSize(windowSize)
+    , mWindowSize(qMax(1, windowSize))
+    , mAlignment(alignment)
 {
-    if((mWindowSize % 2) == 0)
-        mWindowSize++; // We support odd window sizes only for now
+    if(mAlignment == Alignment::Trailing)
+    {
+        mBefore = mWindowSize - 1;
+        mAfter = 0;
+    }
+    else
+    {
+        // Even windows take one more point before
+        mBefore = mWindowSize / 2;
+        mAfter = mWindowSize - 1 - mBefore;
+    }
 
     setName(tr("MovingAvg %1").arg(mWindowSize));
 }
 
-void MovingAverageSeries::onPointAdded(int indexAdded, const QPointF &point)
+int MovingAverageSeries::windowSize() const
 {
-    updateAvg(indexAdded, point, DataSeriesAction::PointAdded);
+    return mWindowSize;
 }
 
-void MovingAverageSeries::onPointChanged(int indexChanged, const QPointF &point)
+MovingAverageSeries::Alignment MovingAverageSeries::alignment() const
 {
-    updateAvg(indexChanged, point, DataSeriesAction::PointChanged);
+    return mAlignment;
 }
 
-void MovingAverageSeries::onPointRemoved(int indexRemoved)
+void MovingAverageSeries::onSourcePointsAppended(int first, int count)
 {
-    updateAvg(indexRemoved, QPointF(), DataSeriesAction::PointRemoved);
+    // Previous points now have enough neighbours on their right
+    const int firstChanged = qMax(0, first - mAfter);
+
+    appendSourcePoints(first, count);
+    updateAvgRunning(firstChanged, mPoints.count() - 1);
+
+    notifyPointsChanged(firstChanged, first - firstChanged);
+    notifyPointsAppended(first, count);
 }
 
-void MovingAverageSeries::onSourceDestroyed()
+void MovingAverageSeries::onSourcePointsChanged(int first, int count)
 {
-    mSource = nullptr;
-
-    int oldSize = mPoints.size();
-    for(int i = oldSize - 1; i >= 0; i--)
+    // Update X values
+    int sourceIndex = first;
+    while(sourceIndex < first + count)
     {
-        emit pointRemoved(i);
+        const DataSeriesSpan span = mSource->getSpan(sourceIndex, first + count - sourceIndex);
+        if(!span.count)
+            break;
+
+        for(int i = 0; i < span.count; i++)
+            mPoints.replace(sourceIndex + i, span.x[i], mPoints.yAt(sourceIndex + i));
+
+        sourceIndex += span.count;
     }
-    mPoints.clear();
+
+    // Out of order change, recalculate affected windows fully
+    resetRunningSum(0);
+
+    const int firstChanged = qMax(0, first - mAfter);
+    const int lastChanged = qMin(mPoints.count() - 1, first + count - 1 + mBefore);
+    updateAvg(firstChanged, lastChanged);
+
+    notifyPointsChanged(firstChanged, lastChanged - firstChanged + 1);
+}
+
+void MovingAverageSeries::onSourcePointsRemoved(int first, int count)
+{
+    // Remove points, then update average of neighbours
+    mPoints.remove(first, count);
+    notifyPointsRemoved(first, count);
+
+    resetRunningSum(0);
+
+    const int firstChanged = qMax(0, first - mAfter);
+    const int lastChanged = qMin(mPoints.count() - 1, first + mBefore - 1);
+    updateAvg(firstChanged, lastChanged);
+
+    notifyPointsChanged(firstChanged, lastChanged - firstChanged + 1);
 }
 
-void MovingAverageSeries::updateAvg(int indexChanged, const QPointF &point, DataSeriesAction action)
+void MovingAverageSeries::onSourceReset()
 {
-    if(indexChanged > mPoints.size())
-        indexChanged = mPoints.size();
+    mPoints.clear();
+    resetRunningSum(0);
 
-    if(action == DataSeriesAction::PointRemoved)
+    if(mSource)
     {
-        // Remove point, then update average
-        mPoints.removeAt(indexChanged);
-        emit pointRemoved(indexChanged);
+        // Rebuilding from start is in order, slide the window
+        appendSourcePoints(0, mSource->getPointCount());
+        updateAvgRunning(0, mPoints.count() - 1);
     }
-    else if(action == DataSeriesAction::PointAdded)
+
+    notifyReset();
+}
+
+void MovingAverageSeries::onSourceDestroyed()
+{
+    mSource = nullptr;
+
+    mPoints.clear();
+    resetRunningSum(0);
+    notifyReset();
+}
+
+void MovingAverageSeries::appendSourcePoints(int first, int count)
+{
+    // Copy X values, average is calculated later
+    mPoints.reserve(first + count);
+
+    int sourceIndex = first;
+    while(sourceIndex < first + count)
     {
-        // Add point but notify later when we have calculated y value
-        mPoints.insert(indexChanged, QPointF(point.x(), 0));
-    }
+        const DataSeriesSpan span = mSource->getSpan(sourceIndex, first + count - sourceIndex);
+        if(!span.count)
+            break;
 
-    const int halfWindow = (mWindowSize - 1) / 2;
-    const int firstItem = qMax(0, indexChanged - halfWindow);
-    const int lastItem = qMin(mPoints.size() - 1, indexChanged + halfWindow);
+        for(int i = 0; i < span.count; i++)
+            mPoints.append(span.x[i], 0);
+
+        sourceIndex += span.count;
+    }
+}
 
-    for(int indexToUpdate = firstItem; indexToUpdate <= lastItem; indexToUpdate++)
+void MovingAverageSeries::updateAvg(int first, int last)
+{
+    for(int indexToUpdate = first; indexToUpdate <= last; indexToUpdate++)
     {
-        const int start = indexToUpdate - halfWindow;
-        const int end = indexToUpdate + halfWindow;
+        const int start = indexToUpdate - mBefore;
+        const int end = indexToUpdate + mAfter;
+
+        double avg = 0;
 
-        if(start < 0 || end >= mPoints.size())
+        if(start >= 0 && end < mPoints.count())
         {
-            // We are too near the end. Cannot calculate average, set y = 0
-            if(mPoints[indexToUpdate].y() != 0 || indexToUpdate == indexChanged)
+            // Sum source values directly from its memory
+            double sum = 0;
+
+            int sourceIndex = start;
+            while(sourceIndex <= end)
             {
-                mPoints[indexToUpdate].ry() = 0;
+                const DataSeriesSpan span = mSource->getSpan(sourceIndex, end - sourceIndex + 1);
+                if(!span.count)
+                    break;
+
+                for(int i = 0; i < span.count; i++)
+                    sum += span.y[i];
 
-                if(indexToUpdate == indexChanged && action == DataSeriesAction::PointAdded)
-                    emit pointAdded(indexToUpdate, mPoints[indexToUpdate]);
-                else
-                    emit pointChanged(indexToUpdate, mPoints[indexToUpdate]);
+                sourceIndex += span.count;
             }
 
-            continue;
+            avg = sum / mWindowSize;
         }
+        // Else we are too near the end. Cannot calculate average, set y = 0
 
-        double sum = 0;
+        mPoints.setY(indexToUpdate, avg);
+    }
+}
+
+void MovingAverageSeries::updateAvgRunning(int first, int last)
+{
+    const int count = mPoints.count();
 
-        for(int sourceIndex = start; sourceIndex <= end; sourceIndex++)
+    for(int indexToUpdate = first; indexToUpdate <= last; indexToUpdate++)
+    {
+        const int start = indexToUpdate - mBefore;
+        const int end = indexToUpdate + mAfter;
+
+        if(start < 0 || end >= count)
         {
-            sum += mSource->getPointAt(sourceIndex).y();
+            // Incomplete window, set y = 0
+            mPoints.setY(indexToUpdate, 0);
+            continue;
         }
 
-        const double avg = sum / mWindowSize;
+        if(start < mSumFirst || start > mSumLast + 1)
+        {
+            // Window is not contiguous with current sum
+            resetRunningSum(start);
+        }
+
+        // Slide window: add new points on the right, drop old ones on the left
+        while(mSumLast < end)
+        {
+            const DataSeriesSpan span = mSource->getSpan(mSumLast + 1, end - mSumLast);
+            if(!span.count)
+                break;
+
+            for(int i = 0; i < span.count; i++)
+                addToRunningSum(span.y[i]);
+
+            mSumLast += span.count;
+        }
 
-        if(mPoints[indexToUpdate].y() != avg || indexToUpdate == indexChanged)
+        while(mSumFirst < start)
         {
-            mPoints[indexToUpdate].ry() = avg;
+            const DataSeriesSpan span = mSource->getSpan(mSumFirst, start - mSumFirst);
+            if(!span.count)
+                break;
+
+            for(int i = 0; i < span.count; i++)
+                addToRunningSum(-span.y[i]);
 
-            if(indexToUpdate == indexChanged && action == DataSeriesAction::PointAdded)
-                emit pointAdded(indexToUpdate, mPoints[indexToUpdate]);
-            else
-                emit pointChanged(indexToUpdate, mPoints[indexToUpdate]);
+            mSumFirst += span.count;
         }
+
+        mPoints.setY(indexToUpdate, mSum / mWindowSize);
     }
 }
 
+void MovingAverageSeries::resetRunningSum(int first)
+{
+    mSum = 0;
+    mSumCompensation = 0;
+    mSumFirst = first;
+    mSumLast = first - 1;
+}
+
+void MovingAverageSeries::addToRunningSum(double value)
+{
+    // Kahan summation, keeps error bounded on long runs
+    const double y = value - mSumCompensation;
+    const double t = mSum + y;
+    mSumCompensation = (t - mSum) - y;
+    mSum = t;
+}
+
 IDataSeries *MovingAverageSeries::source() const
 {
     return mSource;
@@ -110,35 +239,26 @@ void MovingAverageSeries::setSource(IDataSeries *newSource)
 {
     if(mSource)
     {
-        disconnect(mSource, &IDataSeries::pointAdded, this, &MovingAverageSeries::onPointAdded);
-        disconnect(mSource, &IDataSeries::pointChanged, this, &MovingAverageSeries::onPointChanged);
-        disconnect(mSource, &IDataSeries::pointRemoved, this, &MovingAverageSeries::onPointRemoved);
+        disconnect(mSource, &IDataSeries::pointsAppended, this, &MovingAverageSeries::onSourcePointsAppended);
+        disconnect(mSource, &IDataSeries::pointsChanged, this, &MovingAverageSeries::onSourcePointsChanged);
+        disconnect(mSource, &IDataSeries::pointsRemoved, this, &MovingAverageSeries::onSourcePointsRemoved);
+        disconnect(mSource, &IDataSeries::reset, this, &MovingAverageSeries::onSourceReset);
         disconnect(mSource, &QObject::destroyed, this, &MovingAverageSeries::onSourceDestroyed);
-
-        // Clear previous average
-        int oldSize = mPoints.size();
-        for(int i = oldSize - 1; i >= 0; i--)
-        {
-            emit pointRemoved(i);
-        }
-        mPoints.clear();
     }
 
     mSource = newSource;
 
     if(mSource)
     {
-        connect(mSource, &IDataSeries::pointAdded, this, &MovingAverageSeries::onPointAdded);
-        connect(mSource, &IDataSeries::pointChanged, this, &MovingAverageSeries::onPointChanged);
-        connect(mSource, &IDataSeries::pointRemoved, this, &MovingAverageSeries::onPointRemoved);
+        connect(mSource, &IDataSeries::pointsAppended, this, &MovingAverageSeries::onSourcePointsAppended);
+        connect(mSource, &IDataSeries::pointsChanged, this, &MovingAverageSeries::onSourcePointsChanged);
+        connect(mSource, &IDataSeries::pointsRemoved, this, &MovingAverageSeries::onSourcePointsRemoved);
+        connect(mSource, &IDataSeries::reset, this, &MovingAverageSeries::onSourceReset);
         connect(mSource, &QObject::destroyed, this, &MovingAverageSeries::onSourceDestroyed);
-
-        // Build new average
-        for(int i = 0; i < mSource->getPointCount(); i++)
-        {
-            onPointAdded(i, mSource->getPointAt(i));
-        }
     }
+
+    // Build new average
+    onSourceReset();
 }
 
 DataSeriesType MovingAverageSeries::getType() const
@@ -148,20 +268,25 @@ DataSeriesType MovingAverageSeries::getType() const
 
 int MovingAverageSeries::getPointCount() const
 {
-    return mPoints.size();
+    return mPoints.count();
 }
 
 QPointF MovingAverageSeries::getPointAt(int index) const
 {
-    return mPoints.value(index, QPointF());
+    return mPoints.value(index);
 }
 
 QString MovingAverageSeries::getPointTooltip(int index) const
 {
-    if(!mSource || index < 0 || index >= mPoints.size())
+    if(!mSource || index < 0 || index >= mPoints.count())
         return QString();
 
 
     QString fullName = name() + QLatin1String(" (%1)").arg(mSource->name());
     return IDataSeries::defaultTooltip(fullName, index, mPoints.at(index));
 }
+
+DataSeriesSpan MovingAverageSeries::getSpan(int first, int count) const
+{
+    return mPoints.span(first, count);
+}
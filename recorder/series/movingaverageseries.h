@@ -3,13 +3,20 @@
 
 #include "../idataseries.h"
 
-#include <QVector>
-
 class MovingAverageSeries : public IDataSeries
 {
     Q_OBJECT
 public:
-    MovingAverageSeries(int windowSize, QObject *parent = nullptr);
+    enum class Alignment
+    {
+        Centered = 0, // Window around each point, lags half window on live data
+        Trailing      // Window ends on each point, usable while recording
+    };
+
+    MovingAverageSeries(int windowSize, Alignment alignment, QObject *parent = nullptr);
+
+    int windowSize() const;
+    Alignment alignment() const;
 
     IDataSeries *source() const;
     void setSource(IDataSeries *newSource);
@@ -18,22 +25,40 @@ public:
     int getPointCount() const override;
     QPointF getPointAt(int index) const override;
     QString getPointTooltip(int index) const override;
+    DataSeriesSpan getSpan(int first, int count) const override;
 
 private slots:
-    void onPointAdded(int index, const QPointF& point);
-    void onPointChanged(int indexChanged, const QPointF &point);
-    void onPointRemoved(int indexRemoved);
+    void onSourcePointsAppended(int first, int count);
+    void onSourcePointsChanged(int first, int count);
+    void onSourcePointsRemoved(int first, int count);
+    void onSourceReset();
     void onSourceDestroyed();
 
 private:
-    void updateAvg(int index, const QPointF &point, DataSeriesAction action);
+    void appendSourcePoints(int first, int count);
+    void updateAvg(int first, int last);
+    void updateAvgRunning(int first, int last);
+
+    void resetRunningSum(int first);
+    void addToRunningSum(double value);
 
 private:
     IDataSeries *mSource;
 
-    QVector<QPointF> mPoints;
+    DataSeriesStorage mPoints;
 
     int mWindowSize;
+    Alignment mAlignment;
+
+    // Window is [index - mBefore, index + mAfter]
+    int mBefore;
+    int mAfter;
+
+    // Kahan compensated sum of source values in [mSumFirst, mSumLast]
+    double mSum = 0;
+    double mSumCompensation = 0;
+    int mSumFirst = 0;
+    int mSumLast = -1;
 };
 
 #endif // MOVINGAVERAGESERIES_H
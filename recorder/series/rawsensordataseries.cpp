@@ -18,9 +18,7 @@ int RawSensorDataSeries::getPointCount() const
 
 QPointF RawSensorDataSeries::getPointAt(int index) const
 {
-    if(index < 0 || index >= mPoints.count())
-        return QPointF();
-    return mPoints.at(index);
+    return mPoints.value(index);
 }
 
 QString RawSensorDataSeries::getPointTooltip(int index) const
@@ -34,20 +32,24 @@ QString RawSensorDataSeries::getPointTooltip(int index) const
               "Time: %2 s").arg(point.y()).arg(point.x());
 }
 
+DataSeriesSpan RawSensorDataSeries::getSpan(int first, int count) const
+{
+    return mPoints.span(first, count);
+}
+
 void RawSensorDataSeries::addPoint(double speed, double seconds)
 {
-    QPointF point(seconds, speed);
-    mPoints.append(point);
-    emit pointAdded(mPoints.size() - 1, point);
+    mPoints.append(seconds, speed);
+    notifyPointsAppended(mPoints.count() - 1, 1);
 }
 
 void RawSensorDataSeries::clear()
 {
-    int oldSize = mPoints.size();
     mPoints.clear();
-    for(int i = oldSize - 1; i >= 0; i--)
-    {
-        emit pointRemoved(i);
-    }
+    notifyReset();
 }
 
+void RawSensorDataSeries::reserve(int size)
+{
+    mPoints.reserve(size);
+}
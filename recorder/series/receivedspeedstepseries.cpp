@@ -18,9 +18,7 @@ int ReceivedSpeedStepSeries::getPointCount() const
 
 QPointF ReceivedSpeedStepSeries::getPointAt(int index) const
 {
-    if(index < 0 || index >= mPoints.count())
-        return QPointF();
-    return mPoints.at(index);
+    return mPoints.value(index);
 }
 
 QString ReceivedSpeedStepSeries::getPointTooltip(int index) const
@@ -34,19 +32,24 @@ QString ReceivedSpeedStepSeries::getPointTooltip(int index) const
               "Time: %2 s").arg(point.y()).arg(point.x());
 }
 
+DataSeriesSpan ReceivedSpeedStepSeries::getSpan(int first, int count) const
+{
+    return mPoints.span(first, count);
+}
+
 void ReceivedSpeedStepSeries::addPoint(int reqStep, double seconds)
 {
-    QPointF point(seconds, reqStep);
-    mPoints.append(point);
-    emit pointAdded(mPoints.size() - 1, point);
+    mPoints.append(seconds, reqStep);
+    notifyPointsAppended(mPoints.count() - 1, 1);
 }
 
 void ReceivedSpeedStepSeries::clear()
 {
-    int oldSize = mPoints.size();
     mPoints.clear();
-    for(int i = oldSize - 1; i >= 0; i--)
-    {
-        emit pointRemoved(i);
-    }
+    notifyReset();
+}
+
+void ReceivedSpeedStepSeries::reserve(int size)
+{
+    mPoints.reserve(size);
 }
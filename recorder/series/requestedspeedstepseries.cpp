@@ -18,9 +18,7 @@ int RequestedSpeedStepSeries::getPointCount() const
 
 QPointF RequestedSpeedStepSeries::getPointAt(int index) const
 {
-    if(index < 0 || index >= mPoints.count())
-        return QPointF();
-    return mPoints.at(index);
+    return mPoints.value(index);
 }
 
 QString RequestedSpeedStepSeries::getPointTooltip(int index) const
@@ -34,19 +32,24 @@ QString RequestedSpeedStepSeries::getPointTooltip(int index) const
               "Time: %2 s").arg(point.y()).arg(point.x());
 }
 
+DataSeriesSpan RequestedSpeedStepSeries::getSpan(int first, int count) const
+{
+    return mPoints.span(first, count);
+}
+
 void RequestedSpeedStepSeries::addPoint(int reqStep, double seconds)
 {
-    QPointF point(seconds, reqStep);
-    mPoints.append(point);
-    emit pointAdded(mPoints.size() - 1, point);
+    mPoints.append(seconds, reqStep);
+    notifyPointsAppended(mPoints.count() - 1, 1);
 }
 
 void RequestedSpeedStepSeries::clear()
 {
-    int oldSize = mPoints.size();
     mPoints.clear();
-    for(int i = oldSize - 1; i >= 0; i--)
-    {
-        emit pointRemoved(i);
-    }
+    notifyReset();
+}
+
+void RequestedSpeedStepSeries::reserve(int size)
+{
+    mPoints.reserve(size);
 }
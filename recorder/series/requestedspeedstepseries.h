@@ -3,8 +3,6 @@
 
 #include "../idataseries.h"
 
-#include <QVector>
-
 class RecordingManager;
 
 class RequestedSpeedStepSeries : public IDataSeries
@@ -17,12 +15,15 @@ public:
     virtual int getPointCount() const override;
     virtual QPointF getPointAt(int index) const override;
     virtual QString getPointTooltip(int index) const override;
+    virtual DataSeriesSpan getSpan(int first, int count) const override;
 
+    // Negative step means reverse direction
     void addPoint(int reqStep, double seconds);
     void clear();
+    void reserve(int size);
 
 private:
-    QVector<QPointF> mPoints;
+    DataSeriesStorage mPoints;
 };
 
 #endif // REQUESTEDSPEEDSTEPSERIES_H
@@ -18,9 +18,7 @@ int SensorTravelledDistanceSeries::getPointCount() const
 
 QPointF SensorTravelledDistanceSeries::getPointAt(int index) const
 {
-    if(index < 0 || index >= mPoints.count())
-        return QPointF();
-    return mPoints.at(index);
+    return mPoints.value(index);
 }
 
 QString SensorTravelledDistanceSeries::getPointTooltip(int index) const
@@ -34,20 +32,24 @@ QString SensorTravelledDistanceSeries::getPointTooltip(int index) const
               "Time: %2 s").arg(point.y()).arg(point.x());
 }
 
+DataSeriesSpan SensorTravelledDistanceSeries::getSpan(int first, int count) const
+{
+    return mPoints.span(first, count);
+}
+
 void SensorTravelledDistanceSeries::addPoint(double speed, double seconds)
 {
-    QPointF point(seconds, speed);
-    mPoints.append(point);
-    emit pointAdded(mPoints.size() - 1, point);
+    mPoints.append(seconds, speed);
+    notifyPointsAppended(mPoints.count() - 1, 1);
 }
 
 void SensorTravelledDistanceSeries::clear()
 {
-    int oldSize = mPoints.size();
     mPoints.clear();
-    for(int i = oldSize - 1; i >= 0; i--)
-    {
-        emit pointRemoved(i);
-    }
+    notifyReset();
 }
 
+void SensorTravelledDistanceSeries::reserve(int size)
+{
+    mPoints.reserve(size);
+}
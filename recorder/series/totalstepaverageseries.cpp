@@ -1,5 +1,7 @@
 #include "totalstepaverageseries.h"
 
+#include <algorithm>
+
 TotalStepAverageSeries::TotalStepAverageSeries(QObject *parent)
     : IDataSeries{parent}
     , mTravelledSource(nullptr)
@@ -9,39 +11,55 @@ TotalStepAverageSeries::TotalStepAverageSeries(QObject *parent)
     setName(tr("Total Step Avg"));
 }
 
-void TotalStepAverageSeries::onRecvStepPointAdded(int indexAdded, const QPointF &point)
+void TotalStepAverageSeries::onRecvStepPointsAppended(int first, int count)
 {
-    if(indexAdded % 2 == 1)
+    if(count > 1 || first % 2 == 1)
     {
         // Odd Indexes are start steps
-        lastRecvStepIdx = calculateAvg(lastRecvStepIdx);
+        continueCalculation();
     }
 }
 
-void TotalStepAverageSeries::onSensorPointAdded(int indexAdded, const QPointF &point)
+void TotalStepAverageSeries::onSensorPointsAppended()
 {
     if(waitingForMoreSensorData)
     {
         // Continue previously paused calculation
-        lastRecvStepIdx = calculateAvg(lastRecvStepIdx);
+        continueCalculation();
     }
 }
 
-void TotalStepAverageSeries::onReqStepPointAdded(int indexAdded, const QPointF &point)
+void TotalStepAverageSeries::onReqStepPointsAppended(int first, int count)
 {
-    if(waitingForRequestEnd && indexAdded % 2 == 0)
+    if(waitingForRequestEnd && (count > 1 || first % 2 == 0))
     {
         // Even Indexes are end steps
-        lastRecvStepIdx = calculateAvg(lastRecvStepIdx);
+        continueCalculation();
     }
 }
 
-void TotalStepAverageSeries::onPointChanged()
+void TotalStepAverageSeries::onRecvStepPointsChanged(int first)
 {
-    recalculate();
+    auto it = std::lower_bound(mSegments.cbegin(), mSegments.cend(), first,
+                               [](const StepSegment& seg, int idx) { return seg.recvIdx < idx; });
+    invalidateFrom(it - mSegments.cbegin(), first);
 }
 
-void TotalStepAverageSeries::onPointRemoved()
+void TotalStepAverageSeries::onReqStepPointsChanged(int first)
+{
+    auto it = std::lower_bound(mSegments.cbegin(), mSegments.cend(), first,
+                               [](const StepSegment& seg, int idx) { return seg.reqIdx < idx; });
+    invalidateFrom(it - mSegments.cbegin(), lastRecvStepIdx);
+}
+
+void TotalStepAverageSeries::onSensorPointsChanged(int first)
+{
+    auto it = std::lower_bound(mSegments.cbegin(), mSegments.cend(), first,
+                               [](const StepSegment& seg, int idx) { return seg.travelledEnd < idx; });
+    invalidateFrom(it - mSegments.cbegin(), lastRecvStepIdx);
+}
+
+void TotalStepAverageSeries::onSourceReset()
 {
     recalculate();
 }
@@ -57,39 +75,61 @@ void TotalStepAverageSeries::onSourceDestroyed(QObject *source)
     else
         return; // Doesn't belong to us
 
-    int oldSize = mPoints.size();
-    for(int i = oldSize - 1; i >= 0; i--)
+    mPoints.clear();
+    mSegments.clear();
+    notifyReset();
+}
+
+void TotalStepAverageSeries::recalculate()
+{
+    // Clear previous average
+    mPoints.clear();
+    mSegments.clear();
+
+    waitingForMoreSensorData = false;
+    waitingForRequestEnd = false;
+
+    if(mTravelledSource && mReqStepSeries && mRecvStepSeries)
     {
-        emit pointRemoved(i);
+        // Recalculate from start
+        lastRecvStepIdx = calculateAvg(1);
     }
-    mPoints.clear();
+
+    notifyReset();
 }
 
-void TotalStepAverageSeries::updateAvg(int indexChanged, const QPointF &point, DataSeriesAction action)
+void TotalStepAverageSeries::continueCalculation()
 {
-    // TODO: optimize
+    const int oldCount = mPoints.count();
+    lastRecvStepIdx = calculateAvg(lastRecvStepIdx);
+    notifyPointsAppended(oldCount, mPoints.count() - oldCount);
 }
 
-void TotalStepAverageSeries::recalculate()
+void TotalStepAverageSeries::invalidateFrom(int segmentIdx, int recvIdx)
 {
-    // Clear previous average
-    int oldSize = mPoints.size();
-    for(int i = oldSize - 1; i >= 0; i--)
+    if(segmentIdx < mSegments.size())
     {
-        emit pointRemoved(i);
+        // Drop this step and all following ones
+        const StepSegment& seg = mSegments.at(segmentIdx);
+        recvIdx = qMin(recvIdx, seg.recvIdx);
+
+        const int firstRemoved = seg.firstPoint;
+        const int removedCount = mPoints.count() - firstRemoved;
+
+        mSegments.resize(segmentIdx);
+        mPoints.truncate(firstRemoved);
+        notifyPointsRemoved(firstRemoved, removedCount);
     }
-    mPoints.clear();
+
+    lastRecvStepIdx = qMax(1, qMin(lastRecvStepIdx, recvIdx));
 
     waitingForMoreSensorData = false;
     waitingForRequestEnd = false;
 
     if(!mTravelledSource || !mReqStepSeries || !mRecvStepSeries)
-    {
         return;
-    }
 
-    // Recalculate from start
-    lastRecvStepIdx = calculateAvg(1);
+    continueCalculation();
 }
 
 int TotalStepAverageSeries::calculateAvg(int fromRecvIdx)
@@ -99,11 +139,17 @@ int TotalStepAverageSeries::calculateAvg(int fromRecvIdx)
         return 0;
     }
 
-    int travelledIdx = 0;
     int recvStepIdx = fromRecvIdx;
     if(recvStepIdx % 2 != 1)
         recvStepIdx++; // Always use Start received step (Odd indexes)
 
+    // Requested steps are searched starting from previous step end
+    int reqCursor = 0;
+    if(!mSegments.isEmpty())
+        reqCursor = mSegments.last().reqIdx;
+
+    const int travelledCount = mTravelledSource->getPointCount();
+
     for(; recvStepIdx < mRecvStepSeries->getPointCount(); recvStepIdx += 2)
     {
         // For each step we have 2 points (start, end)
@@ -112,77 +158,71 @@ int TotalStepAverageSeries::calculateAvg(int fromRecvIdx)
         QPointF recvStart = mRecvStepSeries->getPointAt(recvStepIdx);
 
         QPointF reqEnd;
-        bool hasEnd = false;
-        for(int reqStepIdx = qMax(0, recvStepIdx - 3); reqStepIdx < mRecvStepSeries->getPointCount(); reqStepIdx += 2)
+        int reqEndIdx = -1;
+        for(int reqStepIdx = reqCursor - reqCursor % 2; reqStepIdx < mReqStepSeries->getPointCount(); reqStepIdx += 2)
         {
             // Even indexes are requested steps end (Just before start of next requested step)
             reqEnd = mReqStepSeries->getPointAt(reqStepIdx);
             if(qFuzzyCompare(reqEnd.y(), recvStart.y()))
             {
-                hasEnd = true;
+                reqEndIdx = reqStepIdx;
                 break;
             }
         }
 
-
-        if(!hasEnd)
+        if(reqEndIdx < 0)
         {
             // Wait for request end
             waitingForRequestEnd = true;
             return recvStepIdx;
         }
 
-        qint64 millisStart = recvStart.x() * 1000 + mAccelerationMilliseconds;
-        qint64 millisEnd = reqEnd.x() * 1000;
+        const double timeStart = recvStart.x() + double(mAccelerationMilliseconds) / 1000.0;
+        const double timeEnd = reqEnd.x();
 
-        if(millisStart > millisEnd)
-            continue;
+        StepSegment seg;
+        seg.recvIdx = recvStepIdx;
+        seg.reqIdx = reqEndIdx;
+        seg.travelledEnd = mSegments.isEmpty() ? 0 : mSegments.last().travelledEnd;
+        seg.firstPoint = mPoints.count();
 
-        QPointF travelledStart, travelledEnd;
-        bool startFound = false;
-
-        for(; travelledIdx < mTravelledSource->getPointCount(); travelledIdx++)
+        if(timeStart > timeEnd)
         {
-            QPointF pt = mTravelledSource->getPointAt(travelledIdx);
-            qint64 ptMillis = pt.x() * 1000;
-
-            if(!startFound && ptMillis >= millisStart)
-            {
-                travelledStart = pt;
-                startFound = true;
-            }
-
-            if(ptMillis > millisEnd)
-                break;
-
-            travelledEnd = pt;
+            mSegments.append(seg);
+            reqCursor = reqEndIdx;
+            continue;
         }
 
-        if(travelledIdx >= mTravelledSource->getPointCount())
+        // First point after step end
+        const int endIdx = mTravelledSource->upperBoundByX(timeEnd);
+        if(endIdx >= travelledCount)
         {
             // Wait for more sensor data to arrive
             waitingForMoreSensorData = true;
             return recvStepIdx;
         }
 
-        if(!startFound || travelledStart == travelledEnd)
+        const int startIdx = mTravelledSource->lowerBoundByX(timeStart);
+
+        seg.travelledEnd = endIdx;
+        mSegments.append(seg);
+        reqCursor = reqEndIdx;
+
+        if(startIdx >= endIdx)
+            continue; // No readings inside step
+
+        const QPointF travelledStart = mTravelledSource->getPointAt(startIdx);
+        const QPointF travelledEnd = mTravelledSource->getPointAt(endIdx - 1);
+
+        if(travelledStart == travelledEnd)
             continue;
 
         double deltaMillimeters = travelledEnd.y() - travelledStart.y();
         double deltaMilliseconds = (travelledEnd.x() - travelledStart.x()) * 1000.0;
         double avgMetersPerSecond = deltaMillimeters / deltaMilliseconds;
 
-        QPointF start = travelledStart;
-        start.ry() = avgMetersPerSecond;
-
-        QPointF end = travelledEnd;
-        end.ry() = avgMetersPerSecond;
-
-        mPoints.append(start);
-        emit pointAdded(mPoints.size() - 1, start);
-
-        mPoints.append(end);
-        emit pointAdded(mPoints.size() - 1, end);
+        mPoints.append(travelledStart.x(), avgMetersPerSecond);
+        mPoints.append(travelledEnd.x(), avgMetersPerSecond);
     }
 
     return recvStepIdx;
@@ -208,9 +248,10 @@ void TotalStepAverageSeries::setRecvStepSeries(IDataSeries *newRecvStepSeries)
 {
     if(mRecvStepSeries)
     {
-        disconnect(mRecvStepSeries, &IDataSeries::pointAdded, this, &TotalStepAverageSeries::onRecvStepPointAdded);
-        disconnect(mRecvStepSeries, &IDataSeries::pointChanged, this, &TotalStepAverageSeries::onPointChanged);
-        disconnect(mRecvStepSeries, &IDataSeries::pointRemoved, this, &TotalStepAverageSeries::onPointRemoved);
+        disconnect(mRecvStepSeries, &IDataSeries::pointsAppended, this, &TotalStepAverageSeries::onRecvStepPointsAppended);
+        disconnect(mRecvStepSeries, &IDataSeries::pointsChanged, this, &TotalStepAverageSeries::onRecvStepPointsChanged);
+        disconnect(mRecvStepSeries, &IDataSeries::pointsRemoved, this, &TotalStepAverageSeries::onRecvStepPointsChanged);
+        disconnect(mRecvStepSeries, &IDataSeries::reset, this, &TotalStepAverageSeries::onSourceReset);
         disconnect(mRecvStepSeries, &QObject::destroyed, this, &TotalStepAverageSeries::onSourceDestroyed);
     }
 
@@ -218,9 +259,10 @@ void TotalStepAverageSeries::setRecvStepSeries(IDataSeries *newRecvStepSeries)
 
     if(mRecvStepSeries)
     {
-        connect(mRecvStepSeries, &IDataSeries::pointAdded, this, &TotalStepAverageSeries::onRecvStepPointAdded);
-        connect(mRecvStepSeries, &IDataSeries::pointChanged, this, &TotalStepAverageSeries::onPointChanged);
-        connect(mRecvStepSeries, &IDataSeries::pointRemoved, this, &TotalStepAverageSeries::onPointRemoved);
+        connect(mRecvStepSeries, &IDataSeries::pointsAppended, this, &TotalStepAverageSeries::onRecvStepPointsAppended);
+        connect(mRecvStepSeries, &IDataSeries::pointsChanged, this, &TotalStepAverageSeries::onRecvStepPointsChanged);
+        connect(mRecvStepSeries, &IDataSeries::pointsRemoved, this, &TotalStepAverageSeries::onRecvStepPointsChanged);
+        connect(mRecvStepSeries, &IDataSeries::reset, this, &TotalStepAverageSeries::onSourceReset);
         connect(mRecvStepSeries, &QObject::destroyed, this, &TotalStepAverageSeries::onSourceDestroyed);
     }
 
@@ -236,9 +278,10 @@ void TotalStepAverageSeries::setReqStepSeries(IDataSeries *newReqStepSeries)
 {
     if(mReqStepSeries)
     {
-        disconnect(mReqStepSeries, &IDataSeries::pointAdded, this, &TotalStepAverageSeries::onReqStepPointAdded);
-        disconnect(mReqStepSeries, &IDataSeries::pointChanged, this, &TotalStepAverageSeries::onPointChanged);
-        disconnect(mReqStepSeries, &IDataSeries::pointRemoved, this, &TotalStepAverageSeries::onPointRemoved);
+        disconnect(mReqStepSeries, &IDataSeries::pointsAppended, this, &TotalStepAverageSeries::onReqStepPointsAppended);
+        disconnect(mReqStepSeries, &IDataSeries::pointsChanged, this, &TotalStepAverageSeries::onReqStepPointsChanged);
+        disconnect(mReqStepSeries, &IDataSeries::pointsRemoved, this, &TotalStepAverageSeries::onReqStepPointsChanged);
+        disconnect(mReqStepSeries, &IDataSeries::reset, this, &TotalStepAverageSeries::onSourceReset);
         disconnect(mReqStepSeries, &QObject::destroyed, this, &TotalStepAverageSeries::onSourceDestroyed);
     }
 
@@ -246,9 +289,10 @@ void TotalStepAverageSeries::setReqStepSeries(IDataSeries *newReqStepSeries)
 
     if(mReqStepSeries)
     {
-        connect(mReqStepSeries, &IDataSeries::pointAdded, this, &TotalStepAverageSeries::onReqStepPointAdded);
-        connect(mReqStepSeries, &IDataSeries::pointChanged, this, &TotalStepAverageSeries::onPointChanged);
-        connect(mReqStepSeries, &IDataSeries::pointRemoved, this, &TotalStepAverageSeries::onPointRemoved);
+        connect(mReqStepSeries, &IDataSeries::pointsAppended, this, &TotalStepAverageSeries::onReqStepPointsAppended);
+        connect(mReqStepSeries, &IDataSeries::pointsChanged, this, &TotalStepAverageSeries::onReqStepPointsChanged);
+        connect(mReqStepSeries, &IDataSeries::pointsRemoved, this, &TotalStepAverageSeries::onReqStepPointsChanged);
+        connect(mReqStepSeries, &IDataSeries::reset, this, &TotalStepAverageSeries::onSourceReset);
         connect(mReqStepSeries, &QObject::destroyed, this, &TotalStepAverageSeries::onSourceDestroyed);
     }
 
@@ -264,9 +308,10 @@ void TotalStepAverageSeries::setTravelledSource(IDataSeries *newSource)
 {
     if(mTravelledSource)
     {
-        disconnect(mTravelledSource, &IDataSeries::pointAdded, this, &TotalStepAverageSeries::onSensorPointAdded);
-        disconnect(mTravelledSource, &IDataSeries::pointChanged, this, &TotalStepAverageSeries::onPointChanged);
-        disconnect(mTravelledSource, &IDataSeries::pointRemoved, this, &TotalStepAverageSeries::onPointRemoved);
+        disconnect(mTravelledSource, &IDataSeries::pointsAppended, this, &TotalStepAverageSeries::onSensorPointsAppended);
+        disconnect(mTravelledSource, &IDataSeries::pointsChanged, this, &TotalStepAverageSeries::onSensorPointsChanged);
+        disconnect(mTravelledSource, &IDataSeries::pointsRemoved, this, &TotalStepAverageSeries::onSensorPointsChanged);
+        disconnect(mTravelledSource, &IDataSeries::reset, this, &TotalStepAverageSeries::onSourceReset);
         disconnect(mTravelledSource, &QObject::destroyed, this, &TotalStepAverageSeries::onSourceDestroyed);
     }
 
@@ -274,9 +319,10 @@ void TotalStepAverageSeries::setTravelledSource(IDataSeries *newSource)
 
     if(mTravelledSource)
     {
-        connect(mTravelledSource, &IDataSeries::pointAdded, this, &TotalStepAverageSeries::onSensorPointAdded);
-        connect(mTravelledSource, &IDataSeries::pointChanged, this, &TotalStepAverageSeries::onPointChanged);
-        connect(mTravelledSource, &IDataSeries::pointRemoved, this, &TotalStepAverageSeries::onPointRemoved);
+        connect(mTravelledSource, &IDataSeries::pointsAppended, this, &TotalStepAverageSeries::onSensorPointsAppended);
+        connect(mTravelledSource, &IDataSeries::pointsChanged, this, &TotalStepAverageSeries::onSensorPointsChanged);
+        connect(mTravelledSource, &IDataSeries::pointsRemoved, this, &TotalStepAverageSeries::onSensorPointsChanged);
+        connect(mTravelledSource, &IDataSeries::reset, this, &TotalStepAverageSeries::onSourceReset);
         connect(mTravelledSource, &QObject::destroyed, this, &TotalStepAverageSeries::onSourceDestroyed);
     }
 
@@ -290,20 +336,25 @@ DataSeriesType TotalStepAverageSeries::getType() const
 
 int TotalStepAverageSeries::getPointCount() const
 {
-    return mPoints.size();
+    return mPoints.count();
 }
 
 QPointF TotalStepAverageSeries::getPointAt(int index) const
 {
-    return mPoints.value(index, QPointF());
+    return mPoints.value(index);
 }
 
 QString TotalStepAverageSeries::getPointTooltip(int index) const
 {
-    if(!mTravelledSource || index < 0 || index >= mPoints.size())
+    if(!mTravelledSource || index < 0 || index >= mPoints.count())
         return QString();
 
 
     QString fullName = name() + QLatin1String(" (%1)").arg(mTravelledSource->name());
     return IDataSeries::defaultTooltip(fullName, index, mPoints.at(index));
 }
+
+DataSeriesSpan TotalStepAverageSeries::getSpan(int first, int count) const
+{
+    return mPoints.span(first, count);
+}
@@ -3,8 +3,6 @@
 
 #include "../idataseries.h"
 
-#include <QVector>
-
 class TotalStepAverageSeries : public IDataSeries
 {
     Q_OBJECT
@@ -18,6 +16,7 @@ public:
     int getPointCount() const override;
     QPointF getPointAt(int index) const override;
     QString getPointTooltip(int index) const override;
+    DataSeriesSpan getSpan(int first, int count) const override;
 
     IDataSeries *reqStepSeries() const;
     void setReqStepSeries(IDataSeries *newReqStepSeries);
@@ -29,16 +28,19 @@ public:
     void setAccelerationMilliseconds(qint64 newAccelerationMilliseconds);
 
 private slots:
-    void onRecvStepPointAdded(int indexAdded, const QPointF& point);
-    void onSensorPointAdded(int indexAdded, const QPointF& point);
-    void onReqStepPointAdded(int indexAdded, const QPointF &point);
-    void onPointChanged();
-    void onPointRemoved();
+    void onRecvStepPointsAppended(int first, int count);
+    void onSensorPointsAppended();
+    void onReqStepPointsAppended(int first, int count);
+    void onRecvStepPointsChanged(int first);
+    void onReqStepPointsChanged(int first);
+    void onSensorPointsChanged(int first);
+    void onSourceReset();
     void onSourceDestroyed(QObject *source);
 
 private:
-    void updateAvg(int index, const QPointF &point, DataSeriesAction action);
     void recalculate();
+    void continueCalculation();
+    void invalidateFrom(int segmentIdx, int recvIdx);
     int calculateAvg(int fromRecvIdx);
 
 private:
@@ -46,7 +48,18 @@ private:
     IDataSeries *mReqStepSeries;
     IDataSeries *mRecvStepSeries;
 
-    QVector<QPointF> mPoints;
+    DataSeriesStorage mPoints;
+
+    // One entry for each calculated step, used to
+    // invalidate only steps affected by source changes
+    struct StepSegment
+    {
+        int recvIdx;      // Received step start index
+        int reqIdx;       // Requested step end index
+        int travelledEnd; // First travelled index after step end
+        int firstPoint;   // First of our points for this step
+    };
+    QVector<StepSegment> mSegments;
 
     qint64 mAccelerationMilliseconds = 1000;
     int lastRecvStepIdx = 1;
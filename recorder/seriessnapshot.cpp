@@ -0,0 +1,256 @@
+#include "seriessnapshot.h"
+
+#include <QTimerEvent>
+
+// Enough for some seconds of all series at full rate
+static constexpr int ChannelCapacity = 16384;
+
+// Deltas copied out of ring at once
+static constexpr int PollBatchSize = 256;
+
+static constexpr int BacklogRetryMillis = 20;
+
+SeriesSnapshotChannel::SeriesSnapshotChannel(DataSeriesType type, const QString &name)
+    : type(type)
+    , name(name)
+    , ring(ChannelCapacity)
+{
+
+}
+
+SeriesSnapshotPublisher::SeriesSnapshotPublisher(IDataSeries *source, const QSharedPointer<SeriesSnapshotChannel> &channel)
+    : QObject{source}
+    , mSource(source)
+    , mChannel(channel)
+{
+    connect(mSource, &IDataSeries::pointsAppended, this, &SeriesSnapshotPublisher::onPointsAppended);
+    connect(mSource, &IDataSeries::pointsChanged, this, &SeriesSnapshotPublisher::onPointsChanged);
+    connect(mSource, &IDataSeries::pointsRemoved, this, &SeriesSnapshotPublisher::onPointsRemoved);
+    connect(mSource, &IDataSeries::reset, this, &SeriesSnapshotPublisher::onReset);
+
+    // Send current points
+    onReset();
+}
+
+SeriesSnapshotPublisher::~SeriesSnapshotPublisher()
+{
+    flushBacklog();
+    mChannel->closed.store(true, std::memory_order_release);
+}
+
+void SeriesSnapshotPublisher::timerEvent(QTimerEvent *e)
+{
+    if(e->timerId() == mRetryTimerId && mRetryTimerId)
+    {
+        if(flushBacklog())
+        {
+            killTimer(mRetryTimerId);
+            mRetryTimerId = 0;
+        }
+        return;
+    }
+
+    QObject::timerEvent(e);
+}
+
+void SeriesSnapshotPublisher::onPointsAppended(int first, int count)
+{
+    pushPoints(SeriesDelta::Append, first, count);
+}
+
+void SeriesSnapshotPublisher::onPointsChanged(int first, int count)
+{
+    pushPoints(SeriesDelta::Change, first, count);
+}
+
+void SeriesSnapshotPublisher::onPointsRemoved(int first, int count)
+{
+    SeriesDelta delta;
+    delta.kind = SeriesDelta::Remove;
+    delta.index = first;
+    delta.count = count;
+    push(delta);
+}
+
+void SeriesSnapshotPublisher::onReset()
+{
+    SeriesDelta delta;
+    delta.kind = SeriesDelta::Reset;
+    push(delta);
+
+    pushPoints(SeriesDelta::Append, 0, mSource->getPointCount());
+}
+
+void SeriesSnapshotPublisher::pushPoints(SeriesDelta::Kind kind, int first, int count)
+{
+    SeriesDelta delta;
+    delta.kind = kind;
+    delta.count = 1;
+
+    const int end = first + count;
+    while(first < end)
+    {
+        const DataSeriesSpan span = mSource->getSpan(first, end - first);
+        if(!span.count)
+            break;
+
+        for(int i = 0; i < span.count; i++)
+        {
+            delta.index = first + i;
+            delta.x = span.x[i];
+            delta.y = span.y[i];
+            push(delta);
+        }
+
+        first += span.count;
+    }
+}
+
+void SeriesSnapshotPublisher::push(const SeriesDelta &delta)
+{
+    // Keep order, after a full ring everything goes to backlog until flushed
+    if(mBacklog.isEmpty() && mChannel->ring.tryPush(delta))
+        return;
+
+    mBacklog.append(delta);
+
+    if(!mRetryTimerId)
+        mRetryTimerId = startTimer(BacklogRetryMillis);
+}
+
+bool SeriesSnapshotPublisher::flushBacklog()
+{
+    while(mBacklogFirst < mBacklog.size())
+    {
+        if(!mChannel->ring.tryPush(mBacklog.at(mBacklogFirst)))
+            return false;
+        mBacklogFirst++;
+    }
+
+    // Keep capacity for next burst
+    mBacklog.resize(0);
+    mBacklogFirst = 0;
+    return true;
+}
+
+SnapshotSeries::SnapshotSeries(const QSharedPointer<SeriesSnapshotChannel> &channel, QObject *parent)
+    : IDataSeries{parent}
+    , mChannel(channel)
+{
+    setName(mChannel->name);
+}
+
+DataSeriesType SnapshotSeries::getType() const
+{
+    return mChannel->type;
+}
+
+int SnapshotSeries::getPointCount() const
+{
+    return mPoints.count();
+}
+
+QPointF SnapshotSeries::getPointAt(int index) const
+{
+    return mPoints.value(index);
+}
+
+QString SnapshotSeries::getPointTooltip(int index) const
+{
+    if(index < 0 || index >= mPoints.count())
+        return QString();
+
+    const QPointF point = mPoints.at(index);
+
+    switch (getType())
+    {
+    case DataSeriesType::RequestedSpeedStep:
+        return tr("Req Step: %1\n"
+                  "Time: %2 s").arg(point.y()).arg(point.x());
+    case DataSeriesType::ReceivedSpeedStep:
+        return tr("Recv Step: %1\n"
+                  "Time: %2 s").arg(point.y()).arg(point.x());
+    case DataSeriesType::SensorRawData:
+        return tr("Raw Speed: %1\n"
+                  "Time: %2 s").arg(point.y()).arg(point.x());
+    case DataSeriesType::TravelledDistance:
+        return tr("Travelled: %1\n"
+                  "Time: %2 s").arg(point.y()).arg(point.x());
+    default:
+        break;
+    }
+
+    return IDataSeries::defaultTooltip(name(), index, point);
+}
+
+DataSeriesSpan SnapshotSeries::getSpan(int first, int count) const
+{
+    return mPoints.span(first, count);
+}
+
+bool SnapshotSeries::poll()
+{
+    // Read flag before draining so no delta pushed before closing is lost
+    const bool closed = mChannel->closed.load(std::memory_order_acquire);
+
+    SeriesDelta buf[PollBatchSize];
+
+    beginBatch();
+
+    int count = 0;
+    while((count = mChannel->ring.popMany(buf, PollBatchSize)) > 0)
+    {
+        for(int i = 0; i < count; i++)
+            apply(buf[i]);
+    }
+
+    endBatch();
+
+    return !closed;
+}
+
+void SnapshotSeries::apply(const SeriesDelta &delta)
+{
+    switch (delta.kind)
+    {
+    case SeriesDelta::Append:
+    {
+        if(delta.index < mPoints.count())
+        {
+            // Should not happen, keep copy consistent anyway
+            mPoints.replace(delta.index, delta.x, delta.y);
+            notifyPointsChanged(delta.index, 1);
+            break;
+        }
+
+        mPoints.append(delta.x, delta.y);
+        notifyPointsAppended(mPoints.count() - 1, 1);
+        break;
+    }
+    case SeriesDelta::Change:
+    {
+        if(delta.index >= mPoints.count())
+            break;
+
+        mPoints.replace(delta.index, delta.x, delta.y);
+        notifyPointsChanged(delta.index, 1);
+        break;
+    }
+    case SeriesDelta::Remove:
+    {
+        if(delta.index >= mPoints.count())
+            break;
+
+        const int count = qMin(delta.count, mPoints.count() - delta.index);
+        mPoints.remove(delta.index, count);
+        notifyPointsRemoved(delta.index, count);
+        break;
+    }
+    case SeriesDelta::Reset:
+    {
+        mPoints.clear();
+        notifyReset();
+        break;
+    }
+    }
+}
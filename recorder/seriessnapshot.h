@@ -0,0 +1,99 @@
+#ifndef SERIESSNAPSHOT_H
+#define SERIESSNAPSHOT_H
+
+#include "idataseries.h"
+
+#include "../utils/spscringbuffer.h"
+
+#include <QSharedPointer>
+
+// Series changes, one entry per point
+struct SeriesDelta
+{
+    enum Kind : quint8
+    {
+        Append = 0,
+        Change,
+        Remove, // Removes "count" points starting at "index"
+        Reset   // Followed by Append of all points
+    };
+
+    Kind kind = Append;
+    int index = 0;
+    int count = 0;
+    double x = 0;
+    double y = 0;
+};
+
+// Connects a series living in a worker thread to a copy in another thread
+class SeriesSnapshotChannel
+{
+public:
+    SeriesSnapshotChannel(DataSeriesType type, const QString& name);
+
+    const DataSeriesType type;
+    const QString name;
+
+    SpscRingBuffer<SeriesDelta> ring;
+
+    // Set by publisher when it is destroyed
+    std::atomic<bool> closed{false};
+};
+
+// Producer side, lives in source series thread.
+// Deltas which do not fit in ring are kept and retried later
+class SeriesSnapshotPublisher : public QObject
+{
+    Q_OBJECT
+public:
+    SeriesSnapshotPublisher(IDataSeries *source, const QSharedPointer<SeriesSnapshotChannel>& channel);
+    ~SeriesSnapshotPublisher();
+
+    void timerEvent(QTimerEvent *e) override;
+
+private slots:
+    void onPointsAppended(int first, int count);
+    void onPointsChanged(int first, int count);
+    void onPointsRemoved(int first, int count);
+    void onReset();
+
+private:
+    void pushPoints(SeriesDelta::Kind kind, int first, int count);
+    void push(const SeriesDelta& delta);
+    bool flushBacklog();
+
+private:
+    IDataSeries *mSource;
+    QSharedPointer<SeriesSnapshotChannel> mChannel;
+
+    QVector<SeriesDelta> mBacklog;
+    int mBacklogFirst = 0;
+    int mRetryTimerId = 0;
+};
+
+// Consumer side copy of a series, updated only when poll() is called
+// so listeners get at most one notification per poll
+class SnapshotSeries : public IDataSeries
+{
+    Q_OBJECT
+public:
+    explicit SnapshotSeries(const QSharedPointer<SeriesSnapshotChannel>& channel, QObject *parent = nullptr);
+
+    DataSeriesType getType() const override;
+    int getPointCount() const override;
+    QPointF getPointAt(int index) const override;
+    QString getPointTooltip(int index) const override;
+    DataSeriesSpan getSpan(int first, int count) const override;
+
+    // Apply pending changes, returns false when source is gone
+    bool poll();
+
+private:
+    void apply(const SeriesDelta& delta);
+
+private:
+    QSharedPointer<SeriesSnapshotChannel> mChannel;
+    DataSeriesStorage mPoints;
+};
+
+#endif // SERIESSNAPSHOT_H
@@ -0,0 +1,108 @@
+#include "seriessnapshothub.h"
+
+#include "recordingmanager.h"
+#include "seriessnapshot.h"
+
+#include <QTimerEvent>
+
+SeriesSnapshotHub::SeriesSnapshotHub(RecordingManager *recMgr, QObject *parent)
+    : QObject{parent}
+{
+    // Direct connection: publisher must exist before series emits anything else
+    connect(recMgr, &RecordingManager::seriesRegistered,
+            this, &SeriesSnapshotHub::publish, Qt::DirectConnection);
+    connect(recMgr, &RecordingManager::seriesUnregistered,
+            this, &SeriesSnapshotHub::unpublish, Qt::DirectConnection);
+
+    for(IDataSeries *s : recMgr->getSeries())
+        publish(s);
+}
+
+QVector<IDataSeries *> SeriesSnapshotHub::getSeries() const
+{
+    QVector<IDataSeries *> result;
+    result.reserve(mSeries.size());
+    for(SnapshotSeries *s : mSeries)
+        result.append(s);
+    return result;
+}
+
+int SeriesSnapshotHub::pollIntervalMillis() const
+{
+    return mPollIntervalMillis;
+}
+
+void SeriesSnapshotHub::setPollIntervalMillis(int newPollIntervalMillis)
+{
+    mPollIntervalMillis = qMax(newPollIntervalMillis, 1);
+
+    if(mPollTimerId)
+    {
+        killTimer(mPollTimerId);
+        mPollTimerId = startTimer(mPollIntervalMillis);
+    }
+}
+
+void SeriesSnapshotHub::timerEvent(QTimerEvent *e)
+{
+    if(e->timerId() == mPollTimerId && mPollTimerId)
+    {
+        pollAll();
+        return;
+    }
+
+    QObject::timerEvent(e);
+}
+
+void SeriesSnapshotHub::publish(IDataSeries *s)
+{
+    auto channel = QSharedPointer<SeriesSnapshotChannel>::create(s->getType(), s->name());
+
+    // Owned by series, lives in its thread
+    new SeriesSnapshotPublisher(s, channel);
+
+    QMetaObject::invokeMethod(this, [this, channel]()
+                              {
+                                  addSnapshot(channel);
+                              }, Qt::QueuedConnection);
+}
+
+void SeriesSnapshotHub::unpublish(IDataSeries *s)
+{
+    // Snapshot gets removed when it sees channel closed
+    delete s->findChild<SeriesSnapshotPublisher *>(QString(), Qt::FindDirectChildrenOnly);
+}
+
+void SeriesSnapshotHub::addSnapshot(const QSharedPointer<SeriesSnapshotChannel> &channel)
+{
+    SnapshotSeries *s = new SnapshotSeries(channel, this);
+    mSeries.append(s);
+
+    // Fill it before views see it
+    if(!s->poll())
+    {
+        mSeries.removeLast();
+        delete s;
+        return;
+    }
+
+    emit seriesRegistered(s);
+
+    if(!mPollTimerId)
+        mPollTimerId = startTimer(mPollIntervalMillis);
+}
+
+void SeriesSnapshotHub::pollAll()
+{
+    for(int i = mSeries.size() - 1; i >= 0; i--)
+    {
+        SnapshotSeries *s = mSeries.at(i);
+        if(s->poll())
+            continue;
+
+        // Source series is gone
+        mSeries.removeAt(i);
+        emit seriesUnregistered(s);
+        s->deleteLater();
+    }
+}
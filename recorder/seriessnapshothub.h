@@ -0,0 +1,49 @@
+#ifndef SERIESSNAPSHOTHUB_H
+#define SERIESSNAPSHOTHUB_H
+
+#include <QObject>
+#include <QVector>
+#include <QSharedPointer>
+
+class RecordingManager;
+class IDataSeries;
+class SnapshotSeries;
+class SeriesSnapshotChannel;
+
+// GUI side registry of RecordingManager series.
+// RecordingManager runs in its own thread, views get a snapshot copy
+// of each series which is updated at most every poll interval.
+// Must be created before RecordingManager is moved to its thread.
+class SeriesSnapshotHub : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SeriesSnapshotHub(RecordingManager *recMgr, QObject *parent = nullptr);
+
+    QVector<IDataSeries *> getSeries() const;
+
+    int pollIntervalMillis() const;
+    void setPollIntervalMillis(int newPollIntervalMillis);
+
+    void timerEvent(QTimerEvent *e) override;
+
+signals:
+    void seriesRegistered(IDataSeries *s);
+    void seriesUnregistered(IDataSeries *s);
+
+private:
+    // Called from RecordingManager thread
+    void publish(IDataSeries *s);
+    void unpublish(IDataSeries *s);
+
+    void addSnapshot(const QSharedPointer<SeriesSnapshotChannel>& channel);
+    void pollAll();
+
+private:
+    QVector<SnapshotSeries *> mSeries;
+
+    int mPollIntervalMillis = 40;
+    int mPollTimerId = 0;
+};
+
+#endif // SERIESSNAPSHOTHUB_H
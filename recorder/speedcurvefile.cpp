@@ -0,0 +1,74 @@
+#include "speedcurvefile.h"
+
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+
+static QJsonArray curveToJson(const QVector<double> &curve)
+{
+    QJsonArray arr;
+    for(int step = 0; step < SpeedCurveFile::CurveSize && step < curve.size(); step++)
+    {
+        arr.append(QJsonValue(curve.at(step)));
+    }
+    return arr;
+}
+
+static QJsonArray mappingToJson(const QMap<int, double> &mapping)
+{
+    QJsonArray arr;
+    for(auto it = mapping.cbegin(); it != mapping.cend(); ++it)
+    {
+        if(it.key() <= 0 || it.key() >= SpeedCurveFile::CurveSize)
+            continue;
+
+        QJsonObject stepObj;
+        stepObj[QLatin1String("step")] = it.key();
+        stepObj[QLatin1String("speed")] = it.value();
+        arr.append(stepObj);
+    }
+    return arr;
+}
+
+bool SpeedCurveFile::saveCurveArray(const QString &fileName, const QString &name,
+                                    const QVector<double> &curve, const QVector<double> &reverseCurve)
+{
+    QFile f(fileName);
+    if(!f.open(QFile::WriteOnly))
+        return false;
+
+    QJsonObject obj;
+    obj[QLatin1String("name")] = name;
+    obj[QLatin1String("curve_array")] = curveToJson(curve);
+
+    if(!reverseCurve.isEmpty())
+        obj[QLatin1String("reverse_curve_array")] = curveToJson(reverseCurve);
+
+    QJsonDocument doc(obj);
+    f.write(doc.toJson());
+
+    return true;
+}
+
+bool SpeedCurveFile::saveSpeedMapping(const QString &fileName, const QString &name,
+                                      int address, const QMap<int, double> &mapping,
+                                      const QMap<int, double> &reverseMapping)
+{
+    QFile f(fileName);
+    if(!f.open(QFile::WriteOnly))
+        return false;
+
+    QJsonObject obj;
+    obj[QLatin1String("name")] = name;
+    obj[QLatin1String("dcc_address")] = address;
+    obj[QLatin1String("speed_mapping")] = mappingToJson(mapping);
+
+    if(!reverseMapping.isEmpty())
+        obj[QLatin1String("reverse_speed_mapping")] = mappingToJson(reverseMapping);
+
+    QJsonDocument doc(obj);
+    f.write(doc.toJson());
+
+    return true;
+}
@@ -0,0 +1,29 @@
+#ifndef SPEEDCURVEFILE_H
+#define SPEEDCURVEFILE_H
+
+#include <QVector>
+#include <QMap>
+
+class QString;
+
+// Speed curve JSON without QtCharts dependency, so it can be used headless.
+// Same "curve_array" and "speed_mapping" formats read by RawSpeedCurveIO and TrainTab
+class SpeedCurveFile
+{
+public:
+    // Step 0 to 126 included
+    static constexpr int CurveSize = 126 + 1;
+
+    // Reverse curve is stored in "reverse_curve_array" if not empty
+    static bool saveCurveArray(const QString& fileName, const QString& name,
+                               const QVector<double>& curve,
+                               const QVector<double>& reverseCurve = QVector<double>());
+
+    // Sparse step -> speed table, missing steps are interpolated by readers.
+    // Reverse table is stored in "reverse_speed_mapping" if not empty
+    static bool saveSpeedMapping(const QString& fileName, const QString& name,
+                                 int address, const QMap<int, double>& mapping,
+                                 const QMap<int, double>& reverseMapping = QMap<int, double>());
+};
+
+#endif // SPEEDCURVEFILE_H
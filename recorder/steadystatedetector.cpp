@@ -0,0 +1,106 @@
+#include "steadystatedetector.h"
+
+#include <QtMath>
+
+SteadyStateDetector::SteadyStateDetector()
+{
+    mWindow.resize(mWindowSize);
+}
+
+int SteadyStateDetector::windowSize() const
+{
+    return mWindowSize;
+}
+
+void SteadyStateDetector::setWindowSize(int newWindowSize)
+{
+    // Need two halves to compare
+    mWindowSize = qMax(newWindowSize, 4);
+    mWindow.resize(mWindowSize);
+    reset();
+}
+
+double SteadyStateDetector::relativeTolerance() const
+{
+    return mRelativeTolerance;
+}
+
+void SteadyStateDetector::setRelativeTolerance(double newRelativeTolerance)
+{
+    mRelativeTolerance = qMax(newRelativeTolerance, 0.0);
+}
+
+double SteadyStateDetector::absoluteTolerance() const
+{
+    return mAbsoluteTolerance;
+}
+
+void SteadyStateDetector::setAbsoluteTolerance(double newAbsoluteTolerance)
+{
+    mAbsoluteTolerance = qMax(newAbsoluteTolerance, 0.0);
+}
+
+void SteadyStateDetector::reset()
+{
+    mNext = 0;
+    mCount = 0;
+    mSteady = false;
+}
+
+bool SteadyStateDetector::addSample(double speed)
+{
+    mWindow[mNext] = speed;
+    mNext = (mNext + 1) % mWindowSize;
+    if(mCount < mWindowSize)
+        mCount++;
+
+    checkSteady();
+    return mSteady;
+}
+
+double SteadyStateDetector::mean() const
+{
+    if(!mCount)
+        return 0;
+
+    double sum = 0;
+    for(int i = 0; i < mCount; i++)
+        sum += mWindow.at(i);
+    return sum / mCount;
+}
+
+void SteadyStateDetector::checkSteady()
+{
+    mSteady = false;
+    if(mCount < mWindowSize)
+        return;
+
+    // Window is small, recalculate instead of keeping running sums
+    const int half = mWindowSize / 2;
+    double olderSum = 0;
+    double newerSum = 0;
+    for(int i = 0; i < mWindowSize; i++)
+    {
+        // mNext is the oldest sample
+        const double v = mWindow.at((mNext + i) % mWindowSize);
+        if(i < half)
+            olderSum += v;
+        else
+            newerSum += v;
+    }
+
+    const double mean = (olderSum + newerSum) / mWindowSize;
+
+    double variance = 0;
+    for(int i = 0; i < mWindowSize; i++)
+    {
+        const double d = mWindow.at(i) - mean;
+        variance += d * d;
+    }
+    variance /= mWindowSize;
+
+    const double tolerance = qMax(mAbsoluteTolerance, qAbs(mean) * mRelativeTolerance);
+    const double trend = newerSum / (mWindowSize - half) - olderSum / half;
+
+    mSteady = qSqrt(variance) <= tolerance && qAbs(trend) <= tolerance;
+}
@@ -0,0 +1,48 @@
+#ifndef STEADYSTATEDETECTOR_H
+#define STEADYSTATEDETECTOR_H
+
+#include <QVector>
+
+// Tells when a speed stream settled after a step change.
+// Looks at last windowSize samples: speed is steady when their standard deviation
+// and the difference between mean of older and newer half are both within tolerance.
+// Tolerance is relative to mean speed with an absolute floor for low speeds.
+class SteadyStateDetector
+{
+public:
+    SteadyStateDetector();
+
+    int windowSize() const;
+    void setWindowSize(int newWindowSize);
+
+    double relativeTolerance() const;
+    void setRelativeTolerance(double newRelativeTolerance);
+
+    double absoluteTolerance() const;
+    void setAbsoluteTolerance(double newAbsoluteTolerance);
+
+    void reset();
+
+    // Returns true when speed is steady
+    bool addSample(double speed);
+
+    inline bool isSteady() const { return mSteady; }
+    inline int sampleCount() const { return mCount; }
+    double mean() const;
+
+private:
+    void checkSteady();
+
+private:
+    int mWindowSize = 10;
+    double mRelativeTolerance = 0.02;
+    double mAbsoluteTolerance = 0.002; // m/s
+
+    QVector<double> mWindow;
+    int mNext = 0;
+    int mCount = 0;
+
+    bool mSteady = false;
+};
+
+#endif // STEADYSTATEDETECTOR_H
@@ -0,0 +1,239 @@
+#include "sweepplanner.h"
+
+#include <QtMath>
+
+#include <utility>
+
+// Least squares parabola y = c0 + c1 * dx + c2 * dx^2 with dx = x - center
+static bool fitQuadratic(const int *x, const double *y, int n, int center, double &c0, double &c2)
+{
+    // Normal equations, symmetric 3x3
+    double s[5] = {0, 0, 0, 0, 0};
+    double t[3] = {0, 0, 0};
+    for(int i = 0; i < n; i++)
+    {
+        const double dx = x[i] - center;
+        double p = 1;
+        for(int k = 0; k < 5; k++)
+        {
+            s[k] += p;
+            if(k < 3)
+                t[k] += p * y[i];
+            p *= dx;
+        }
+    }
+
+    double m[3][4] = {
+        {s[0], s[1], s[2], t[0]},
+        {s[1], s[2], s[3], t[1]},
+        {s[2], s[3], s[4], t[2]}
+    };
+
+    // Gauss elimination with partial pivoting
+    for(int col = 0; col < 3; col++)
+    {
+        int pivot = col;
+        for(int r = col + 1; r < 3; r++)
+        {
+            if(qAbs(m[r][col]) > qAbs(m[pivot][col]))
+                pivot = r;
+        }
+        if(qFuzzyIsNull(m[pivot][col]))
+            return false;
+
+        if(pivot != col)
+        {
+            for(int k = 0; k < 4; k++)
+                std::swap(m[col][k], m[pivot][k]);
+        }
+
+        for(int r = col + 1; r < 3; r++)
+        {
+            const double f = m[r][col] / m[col][col];
+            for(int k = col; k < 4; k++)
+                m[r][k] -= f * m[col][k];
+        }
+    }
+
+    double c[3];
+    for(int r = 2; r >= 0; r--)
+    {
+        double v = m[r][3];
+        for(int k = r + 1; k < 3; k++)
+            v -= m[r][k] * c[k];
+        c[r] = v / m[r][r];
+    }
+
+    c0 = c[0];
+    c2 = c[2];
+    return true;
+}
+
+SweepPlanner::SweepPlanner()
+{
+
+}
+
+int SweepPlanner::coarseStride() const
+{
+    return mCoarseStride;
+}
+
+void SweepPlanner::setCoarseStride(int newCoarseStride)
+{
+    mCoarseStride = qBound(1, newCoarseStride, 64);
+}
+
+double SweepPlanner::tolerance() const
+{
+    return mTolerance;
+}
+
+void SweepPlanner::setTolerance(double newTolerance)
+{
+    mTolerance = qMax(newTolerance, 0.0);
+}
+
+double SweepPlanner::absoluteTolerance() const
+{
+    return mAbsoluteTolerance;
+}
+
+void SweepPlanner::setAbsoluteTolerance(double newAbsoluteTolerance)
+{
+    mAbsoluteTolerance = qMax(newAbsoluteTolerance, 0.0);
+}
+
+int SweepPlanner::maxMeasurements() const
+{
+    return mMaxMeasurements;
+}
+
+void SweepPlanner::setMaxMeasurements(int newMaxMeasurements)
+{
+    mMaxMeasurements = qMax(newMaxMeasurements, 2);
+}
+
+void SweepPlanner::start(int firstStep, int lastStep)
+{
+    mFirstStep = qBound(1, firstStep, 126);
+    mLastStep = qBound(mFirstStep, lastStep, 126);
+
+    mMeasured.clear();
+    mVisited.fill(false, mLastStep + 1);
+    mRetries.fill(0, mLastStep + 1);
+    mRequested = 0;
+
+    mQueue.clear();
+    mQueuePos = 0;
+    for(int step = mFirstStep; step < mLastStep; step += mCoarseStride)
+        mQueue.append(step);
+    mQueue.append(mLastStep);
+}
+
+int SweepPlanner::nextStep()
+{
+    while(mRequested < mMaxMeasurements)
+    {
+        while(mQueuePos < mQueue.size())
+        {
+            const int step = mQueue.at(mQueuePos++);
+            if(mVisited.at(step))
+                continue;
+
+            mVisited[step] = true;
+            mRequested++;
+            return step;
+        }
+
+        // Current pass done, look at what we got so far
+        planRefinement();
+        if(mQueue.isEmpty())
+            break;
+    }
+
+    return -1;
+}
+
+void SweepPlanner::addMeasurement(int step, double speed)
+{
+    if(step < mFirstStep || step > mLastStep)
+        return;
+    mMeasured.insert(step, speed);
+}
+
+void SweepPlanner::remeasure(int step)
+{
+    if(step < mFirstStep || step > mLastStep || mRetries.at(step) >= MaxRetries)
+        return;
+
+    mRetries[step]++;
+    mVisited[step] = false;
+    mQueue.append(step);
+}
+
+void SweepPlanner::planRefinement()
+{
+    mQueue.clear();
+    mQueuePos = 0;
+
+    const int n = mMeasured.size();
+    if(n < 2)
+        return;
+
+    QVector<int> steps;
+    QVector<double> speeds;
+    steps.reserve(n);
+    speeds.reserve(n);
+    for(auto it = mMeasured.cbegin(); it != mMeasured.cend(); ++it)
+    {
+        steps.append(it.key());
+        speeds.append(it.value());
+    }
+
+    // Local fit over 5 neighbour points gives curvature and residual at each point
+    QVector<double> curvature(n, 0);
+    QVector<double> residual(n, 0);
+    for(int i = 0; i < n; i++)
+    {
+        const int first = qBound(0, i - 2, qMax(0, n - 5));
+        const int count = qMin(5, n - first);
+        if(count < 3)
+            continue;
+
+        double c0 = 0;
+        double c2 = 0;
+        if(!fitQuadratic(steps.constData() + first, speeds.constData() + first, count, steps.at(i), c0, c2))
+            continue;
+
+        curvature[i] = qAbs(2 * c2);
+        residual[i] = qAbs(speeds.at(i) - c0);
+    }
+
+    const double tol = qMax(mAbsoluteTolerance, maxSpeed() * mTolerance);
+
+    for(int i = 0; i < n - 1; i++)
+    {
+        const int h = steps.at(i + 1) - steps.at(i);
+        if(h < 2)
+            continue;
+
+        // Max distance between chord and parabola is f'' * h^2 / 8
+        const double chordError = qMax(curvature.at(i), curvature.at(i + 1)) * h * h / 8.0;
+        const double fitError = qMax(residual.at(i), residual.at(i + 1));
+        if(chordError <= tol && fitError <= tol)
+            continue;
+
+        const int mid = steps.at(i) + h / 2;
+        if(!mVisited.at(mid))
+            mQueue.append(mid);
+    }
+}
+
+double SweepPlanner::maxSpeed() const
+{
+    double result = 0;
+    for(double speed : mMeasured)
+        result = qMax(result, qAbs(speed));
+    return result;
+}
@@ -0,0 +1,75 @@
+#ifndef SWEEPPLANNER_H
+#define SWEEPPLANNER_H
+
+#include <QMap>
+#include <QVector>
+
+// Chooses which DCC steps to measure instead of walking all of them.
+// First measures every coarseStride steps (first and last step always included),
+// then repeatedly halves intervals where the linear interpolation between
+// measured steps is not good enough:
+// - Curvature: error of chord against a parabola fitted on neighbour points
+// - Residual: a point far from the value of that same parabola at its step
+// Result is a sparse step -> speed table, see SpeedCurveFile::saveSpeedMapping()
+class SweepPlanner
+{
+public:
+    SweepPlanner();
+
+    int coarseStride() const;
+    void setCoarseStride(int newCoarseStride);
+
+    // Relative to max measured speed, i.e. 0.01 is 1%
+    double tolerance() const;
+    void setTolerance(double newTolerance);
+
+    // Floor for tolerance, m/s
+    double absoluteTolerance() const;
+    void setAbsoluteTolerance(double newAbsoluteTolerance);
+
+    int maxMeasurements() const;
+    void setMaxMeasurements(int newMaxMeasurements);
+
+    void start(int firstStep, int lastStep);
+
+    // Returns next step to measure or -1 when sweep is complete
+    int nextStep();
+
+    void addMeasurement(int step, double speed);
+
+    // Speed did not settle, step is requested again later in current pass.
+    // Each step is retried at most MaxRetries times, then left to interpolation
+    void remeasure(int step);
+
+    inline const QMap<int, double>& measurements() const { return mMeasured; }
+
+    // Steps requested so far, including the ones without measurement
+    inline int requestedCount() const { return mRequested; }
+
+    static constexpr int MaxRetries = 2;
+
+private:
+    void planRefinement();
+    double maxSpeed() const;
+
+private:
+    int mCoarseStride = 8;
+    double mTolerance = 0.01;
+    double mAbsoluteTolerance = 0.002;
+    int mMaxMeasurements = 126;
+
+    int mFirstStep = 1;
+    int mLastStep = 126;
+
+    QVector<int> mQueue;
+    int mQueuePos = 0;
+    int mRequested = 0;
+
+    // Intervals which cannot be refined anymore are skipped on next passes
+    QVector<bool> mVisited;
+    QVector<int> mRetries;
+
+    QMap<int, double> mMeasured;
+};
+
+#endif // SWEEPPLANNER_H
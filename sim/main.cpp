@@ -0,0 +1,144 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTimer>
+
+#include <QDebug>
+
+#include "z21simulator.h"
+
+// Parse non negative integer option
+static bool parseCount(const QString& str, int& value)
+{
+    bool ok = false;
+    value = str.toInt(&ok);
+    return ok && value >= 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QLatin1String("msr-z21sim"));
+    QCoreApplication::setApplicationVersion(QLatin1String("0.1"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QLatin1String("Simulate a Z21 command station on local UDP"));
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption bindOpt(QLatin1String("bind"),
+                               QLatin1String("Address to listen on, default is loopback"),
+                               QLatin1String("address"), QLatin1String("127.0.0.1"));
+    QCommandLineOption portOpt(QLatin1String("port"),
+                               QLatin1String("UDP port, default is 21105"),
+                               QLatin1String("port"), QLatin1String("21105"));
+    QCommandLineOption latencyOpt(QLatin1String("latency"),
+                                  QLatin1String("Delay of each reply in microseconds"),
+                                  QLatin1String("us"), QLatin1String("2000"));
+    QCommandLineOption jitterOpt(QLatin1String("jitter"),
+                                 QLatin1String("Random variation of delay in microseconds"),
+                                 QLatin1String("us"), QLatin1String("1000"));
+    QCommandLineOption lossOpt(QLatin1String("loss"),
+                               QLatin1String("Percent of outgoing datagrams which are dropped"),
+                               QLatin1String("percent"), QLatin1String("0"));
+    QCommandLineOption locosOpt(QLatin1String("locos"),
+                                QLatin1String("Number of virtual locomotives, addresses start from 1"),
+                                QLatin1String("n"), QLatin1String("16"));
+    QCommandLineOption trafficOpt(QLatin1String("traffic"),
+                                  QLatin1String("Speed changes per second from other virtual throttles"),
+                                  QLatin1String("n"), QLatin1String("0"));
+    QCommandLineOption seedOpt(QLatin1String("seed"),
+                               QLatin1String("Seed of jitter, loss and traffic generator"),
+                               QLatin1String("n"), QLatin1String("1"));
+    QCommandLineOption statsOpt(QLatin1String("stats"),
+                                QLatin1String("Print statistics every n seconds, 0 disables"),
+                                QLatin1String("seconds"), QLatin1String("5"));
+
+    parser.addOption(bindOpt);
+    parser.addOption(portOpt);
+    parser.addOption(latencyOpt);
+    parser.addOption(jitterOpt);
+    parser.addOption(lossOpt);
+    parser.addOption(locosOpt);
+    parser.addOption(trafficOpt);
+    parser.addOption(seedOpt);
+    parser.addOption(statsOpt);
+
+    parser.process(app);
+
+    Z21SimulatorConfig config;
+
+    if(!config.bindAddress.setAddress(parser.value(bindOpt)))
+    {
+        qCritical().noquote() << "Invalid bind address:" << parser.value(bindOpt);
+        return 1;
+    }
+
+    int port = 0;
+    if(!parseCount(parser.value(portOpt), port) || port < 1 || port > 65535)
+    {
+        qCritical().noquote() << "Invalid port:" << parser.value(portOpt);
+        return 1;
+    }
+    config.port = quint16(port);
+
+    if(!parseCount(parser.value(latencyOpt), config.latencyMicros))
+    {
+        qCritical().noquote() << "Invalid latency:" << parser.value(latencyOpt);
+        return 1;
+    }
+
+    if(!parseCount(parser.value(jitterOpt), config.jitterMicros))
+    {
+        qCritical().noquote() << "Invalid jitter:" << parser.value(jitterOpt);
+        return 1;
+    }
+
+    bool ok = false;
+    const double lossPercent = parser.value(lossOpt).toDouble(&ok);
+    if(!ok || lossPercent < 0 || lossPercent > 100)
+    {
+        qCritical().noquote() << "Invalid loss percent:" << parser.value(lossOpt);
+        return 1;
+    }
+    config.lossRate = lossPercent / 100.0;
+
+    // Same range as long DCC addresses
+    if(!parseCount(parser.value(locosOpt), config.locoCount) || config.locoCount > 10239)
+    {
+        qCritical().noquote() << "Invalid loco count:" << parser.value(locosOpt);
+        return 1;
+    }
+
+    if(!parseCount(parser.value(trafficOpt), config.trafficPerSecond))
+    {
+        qCritical().noquote() << "Invalid traffic rate:" << parser.value(trafficOpt);
+        return 1;
+    }
+
+    config.seed = parser.value(seedOpt).toUInt(&ok);
+    if(!ok)
+    {
+        qCritical().noquote() << "Invalid seed:" << parser.value(seedOpt);
+        return 1;
+    }
+
+    int statsSeconds = 0;
+    if(!parseCount(parser.value(statsOpt), statsSeconds))
+    {
+        qCritical().noquote() << "Invalid stats interval:" << parser.value(statsOpt);
+        return 1;
+    }
+
+    Z21Simulator simulator(config);
+    if(!simulator.start())
+        return 1;
+
+    QTimer statsTimer;
+    if(statsSeconds > 0)
+    {
+        QObject::connect(&statsTimer, &QTimer::timeout, &simulator, &Z21Simulator::printStats);
+        statsTimer.start(statsSeconds * 1000);
+    }
+
+    return app.exec();
+}
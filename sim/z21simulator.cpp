@@ -0,0 +1,313 @@
+#include "z21simulator.h"
+
+#include "../commandstation/backends/z21messages.h"
+#include "../utils/monotonicclock.h"
+
+#include <QUdpSocket>
+#include <QTimerEvent>
+#include <QtEndian>
+#include <QtMath>
+
+#include <QDebug>
+
+#include <cstring>
+
+// Ethernet MTU minus IP and UDP headers
+static constexpr int MaxDatagramSize = 1472;
+
+// Traffic generator tick
+static constexpr int TrafficTickMillis = 10;
+
+Z21Simulator::Z21Simulator(const Z21SimulatorConfig &config, QObject *parent)
+    : QObject{parent}
+    , mConfig(config)
+    , mRandom(config.seed)
+{
+    mSocket = new QUdpSocket(this);
+    connect(mSocket, &QUdpSocket::readyRead, this, &Z21Simulator::readPendingDatagrams);
+
+    mLocos.reserve(mConfig.locoCount);
+    for(int address = 1; address <= mConfig.locoCount; address++)
+        mLocos.insert(address, Loco());
+}
+
+bool Z21Simulator::start()
+{
+    if(!mSocket->bind(mConfig.bindAddress, mConfig.port))
+    {
+        qCritical().noquote() << "Cannot bind" << mConfig.bindAddress.toString() << mConfig.port
+                              << mSocket->errorString();
+        return false;
+    }
+
+    if(mConfig.trafficPerSecond > 0 && mConfig.locoCount > 0)
+        mTrafficTimerId = startTimer(TrafficTickMillis, Qt::PreciseTimer);
+
+    qDebug().noquote() << "Z21 simulator on" << mConfig.bindAddress.toString() << mConfig.port
+                       << "locos:" << mConfig.locoCount
+                       << "latency us:" << mConfig.latencyMicros << "+-" << mConfig.jitterMicros
+                       << "loss:" << mConfig.lossRate;
+    return true;
+}
+
+void Z21Simulator::printStats()
+{
+    qDebug().noquote() << "received:" << mReceivedCount
+                       << "sent:" << mSentCount
+                       << "lost:" << mLostCount
+                       << "ignored:" << mIgnoredCount
+                       << "clients:" << mClients.size()
+                       << "max queued:" << mMaxQueued;
+}
+
+void Z21Simulator::timerEvent(QTimerEvent *e)
+{
+    if(e->timerId() == mSendTimerId && mSendTimerId)
+    {
+        killTimer(mSendTimerId);
+        mSendTimerId = 0;
+
+        sendDueDatagrams();
+        return;
+    }
+    else if(e->timerId() == mTrafficTimerId && mTrafficTimerId)
+    {
+        generateTraffic();
+        return;
+    }
+
+    QObject::timerEvent(e);
+}
+
+void Z21Simulator::readPendingDatagrams()
+{
+    char buf[MaxDatagramSize];
+
+    while(mSocket->hasPendingDatagrams())
+    {
+        QHostAddress sender;
+        quint16 senderPort = 0;
+        const qint64 size = mSocket->readDatagram(buf, sizeof(buf), &sender, &senderPort);
+        if(size <= 0)
+            continue;
+
+        mReceivedCount++;
+        handleMessage(buf, int(size), sender, senderPort);
+    }
+}
+
+void Z21Simulator::handleMessage(const char *data, int size, const QHostAddress &sender, quint16 senderPort)
+{
+    // A datagram can contain multiple messages
+    while(size >= int(sizeof(Z21::Message)))
+    {
+        uint16_t msgSize = 0;
+        std::memcpy(&msgSize, data, sizeof(msgSize));
+        msgSize = qFromLittleEndian(msgSize);
+        if(msgSize > size || msgSize < sizeof(Z21::Message))
+            return;
+
+        const auto& message = *reinterpret_cast<const Z21::Message *>(data);
+        switch(message.header())
+        {
+        case Z21::LAN_SET_BROADCASTFLAGS:
+        {
+            if(msgSize < sizeof(Z21::LanSetBroadcastFlags))
+            {
+                mIgnoredCount++;
+                break;
+            }
+
+            const auto& msg = static_cast<const Z21::LanSetBroadcastFlags&>(message);
+            Client *client = findClient(sender, senderPort);
+            if(!client)
+            {
+                mClients.append(Client{sender, senderPort, 0});
+                client = &mClients.last();
+                qDebug().noquote() << "Client registered:" << sender.toString() << senderPort;
+            }
+            client->broadcastFlags = quint32(msg.broadcastFlags());
+            break;
+        }
+        case Z21::LAN_LOGOFF:
+        {
+            for(int i = 0; i < mClients.size(); i++)
+            {
+                if(mClients.at(i).address == sender && mClients.at(i).port == senderPort)
+                {
+                    mClients.removeAt(i);
+                    break;
+                }
+            }
+            break;
+        }
+        case Z21::LAN_X:
+        {
+            const auto& lanX = static_cast<const Z21::LanX&>(message);
+
+            // Checksum reads up to data size stored in xheader
+            if(msgSize < sizeof(Z21::LanX) + (lanX.xheader & 0x0F) + 1
+                    || !Z21::LanX::isChecksumValid(lanX))
+            {
+                mIgnoredCount++;
+                break;
+            }
+
+            if(lanX.xheader == Z21::LAN_X_SET_LOCO && msgSize >= sizeof(Z21::LanXSetLocoDrive))
+                onSetLocoDrive(data, sender, senderPort);
+            else if(lanX.xheader == Z21::LAN_X_GET_LOCO_INFO && msgSize >= sizeof(Z21::LanXGetLocoInfo))
+                onGetLocoInfo(data, sender, senderPort);
+            else
+                mIgnoredCount++;
+            break;
+        }
+        default:
+            mIgnoredCount++;
+            break;
+        }
+
+        data += msgSize;
+        size -= msgSize;
+    }
+}
+
+void Z21Simulator::onSetLocoDrive(const char *data, const QHostAddress &sender, quint16 senderPort)
+{
+    const auto& msg = *reinterpret_cast<const Z21::LanXSetLocoDrive *>(data);
+
+    // Unknown addresses become new virtual locos, like a real station
+    Loco& loco = mLocos[msg.address()];
+    loco.forward = msg.direction() == Z21::Direction::Forward;
+    loco.emergencyStop = msg.isEmergencyStop();
+    loco.speedStep = loco.emergencyStop ? 0 : msg.speedStep();
+
+    sendLocoInfo(msg.address(), sender, senderPort);
+}
+
+void Z21Simulator::onGetLocoInfo(const char *data, const QHostAddress &sender, quint16 senderPort)
+{
+    const auto& msg = *reinterpret_cast<const Z21::LanXGetLocoInfo *>(data);
+
+    // Only to requesting client
+    queueDatagram(makeLocoInfo(msg.address()), sender, senderPort);
+}
+
+Z21Simulator::Client *Z21Simulator::findClient(const QHostAddress &address, quint16 port)
+{
+    for(Client& client : mClients)
+    {
+        if(client.address == address && client.port == port)
+            return &client;
+    }
+    return nullptr;
+}
+
+QByteArray Z21Simulator::makeLocoInfo(int address) const
+{
+    const Loco loco = mLocos.value(address);
+
+    Z21::LanXLocoInfo info;
+    info.setAddress(address, address > 127);
+    info.setSpeedSteps(126);
+    info.setDirection(loco.forward ? Z21::Direction::Forward : Z21::Direction::Reverse);
+    if(loco.emergencyStop)
+        info.setEmergencyStop();
+    else
+        info.setSpeedStep(loco.speedStep);
+    info.updateChecksum();
+
+    return QByteArray(reinterpret_cast<const char *>(&info), info.dataLen());
+}
+
+void Z21Simulator::sendLocoInfo(int address, const QHostAddress &sender, quint16 senderPort)
+{
+    const QByteArray data = makeLocoInfo(address);
+
+    // Sender port 0 means change came from a virtual throttle
+    if(senderPort)
+        queueDatagram(data, sender, senderPort);
+
+    const quint32 allLocos = quint32(Z21::BroadcastFlags::AllLocoChanges);
+    for(const Client& client : std::as_const(mClients))
+    {
+        if(!(client.broadcastFlags & allLocos))
+            continue;
+        if(client.address == sender && client.port == senderPort)
+            continue;
+
+        queueDatagram(data, client.address, client.port);
+    }
+}
+
+void Z21Simulator::queueDatagram(const QByteArray &data, const QHostAddress &address, quint16 port)
+{
+    if(mConfig.lossRate > 0 && mRandom.generateDouble() < mConfig.lossRate)
+    {
+        mLostCount++;
+        return;
+    }
+
+    qint64 delay = mConfig.latencyMicros;
+    if(mConfig.jitterMicros > 0)
+        delay += mRandom.bounded(-mConfig.jitterMicros, mConfig.jitterMicros + 1);
+
+    const qint64 due = monotonicMicros() + qMax(qint64(0), delay);
+    mOutgoing.insert(due, Outgoing{data, address, port});
+    mMaxQueued = qMax(mMaxQueued, quint64(mOutgoing.size()));
+
+    scheduleSend();
+}
+
+void Z21Simulator::sendDueDatagrams()
+{
+    // Timers have millisecond resolution, send what is due within half of it
+    const qint64 now = monotonicMicros() + 500;
+
+    while(!mOutgoing.isEmpty() && mOutgoing.firstKey() <= now)
+    {
+        const Outgoing out = mOutgoing.take(mOutgoing.firstKey());
+        mSocket->writeDatagram(out.data, out.address, out.port);
+        mSentCount++;
+    }
+
+    scheduleSend();
+}
+
+void Z21Simulator::scheduleSend()
+{
+    if(mOutgoing.isEmpty())
+        return;
+
+    const qint64 due = mOutgoing.firstKey();
+    if(mSendTimerId)
+    {
+        if(mSendTimerDue <= due)
+            return; // Already woken up in time
+
+        killTimer(mSendTimerId);
+        mSendTimerId = 0;
+    }
+
+    const qint64 waitMicros = due - monotonicMicros();
+    mSendTimerDue = due;
+    mSendTimerId = startTimer(qMax(0, qCeil(double(waitMicros) / 1000.0)), Qt::PreciseTimer);
+}
+
+void Z21Simulator::generateTraffic()
+{
+    mTrafficCarry += double(mConfig.trafficPerSecond) * TrafficTickMillis / 1000.0;
+    const int count = int(mTrafficCarry);
+    mTrafficCarry -= count;
+
+    for(int i = 0; i < count; i++)
+    {
+        const int address = mRandom.bounded(1, mConfig.locoCount + 1);
+
+        Loco& loco = mLocos[address];
+        loco.speedStep = mRandom.bounded(0, 127);
+        loco.forward = mRandom.bounded(0, 2) == 0;
+        loco.emergencyStop = false;
+
+        sendLocoInfo(address, QHostAddress(), 0);
+    }
+}
@@ -0,0 +1,118 @@
+#ifndef Z21SIMULATOR_H
+#define Z21SIMULATOR_H
+
+#include <QObject>
+#include <QHostAddress>
+#include <QHash>
+#include <QMultiMap>
+#include <QVector>
+#include <QRandomGenerator>
+
+class QUdpSocket;
+
+struct Z21SimulatorConfig
+{
+    QHostAddress bindAddress = QHostAddress(QHostAddress::LocalHost);
+    quint16 port = 21105;
+
+    // Each reply or broadcast is delayed by latency +- jitter
+    int latencyMicros = 2000;
+    int jitterMicros = 1000;
+
+    // Fraction of outgoing datagrams which are not sent
+    double lossRate = 0;
+
+    // Virtual locomotives have addresses 1 to locoCount
+    int locoCount = 16;
+
+    // LAN_X_LOCO_INFO broadcasts per second from other virtual throttles
+    int trafficPerSecond = 0;
+
+    quint32 seed = 1;
+};
+
+// Stand-in for a Z21 command station on local UDP.
+// Speaks the subset used by Z21CommandStation:
+// LAN_SET_BROADCASTFLAGS, LAN_LOGOFF, LAN_X_SET_LOCO, LAN_X_GET_LOCO_INFO
+// and sends LAN_X_LOCO_INFO replies and broadcasts.
+class Z21Simulator : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Z21Simulator(const Z21SimulatorConfig& config, QObject *parent = nullptr);
+
+    bool start();
+
+    void printStats();
+
+protected:
+    void timerEvent(QTimerEvent *e) override;
+
+private slots:
+    void readPendingDatagrams();
+
+private:
+    struct Loco
+    {
+        int speedStep = 0;
+        bool forward = true;
+        bool emergencyStop = false;
+    };
+
+    struct Client
+    {
+        QHostAddress address;
+        quint16 port = 0;
+        quint32 broadcastFlags = 0;
+    };
+
+    struct Outgoing
+    {
+        QByteArray data;
+        QHostAddress address;
+        quint16 port = 0;
+    };
+
+    void handleMessage(const char *data, int size, const QHostAddress& sender, quint16 senderPort);
+
+    void onSetLocoDrive(const char *data, const QHostAddress& sender, quint16 senderPort);
+    void onGetLocoInfo(const char *data, const QHostAddress& sender, quint16 senderPort);
+
+    Client *findClient(const QHostAddress& address, quint16 port);
+
+    QByteArray makeLocoInfo(int address) const;
+
+    // Reply to sender and broadcast to clients receiving all loco changes
+    void sendLocoInfo(int address, const QHostAddress& sender, quint16 senderPort);
+
+    void queueDatagram(const QByteArray& data, const QHostAddress& address, quint16 port);
+    void sendDueDatagrams();
+    void scheduleSend();
+
+    void generateTraffic();
+
+private:
+    Z21SimulatorConfig mConfig;
+
+    QUdpSocket *mSocket = nullptr;
+    QRandomGenerator mRandom;
+
+    QHash<int, Loco> mLocos;
+    QVector<Client> mClients;
+
+    // Ordered by due monotonicMicros()
+    QMultiMap<qint64, Outgoing> mOutgoing;
+    int mSendTimerId = 0;
+    qint64 mSendTimerDue = 0;
+
+    int mTrafficTimerId = 0;
+    double mTrafficCarry = 0;
+
+    quint64 mReceivedCount = 0;
+    quint64 mSentCount = 0;
+    quint64 mLostCount = 0;
+    quint64 mIgnoredCount = 0;
+    quint64 mMaxQueued = 0;
+};
+
+#endif // Z21SIMULATOR_H
@@ -0,0 +1,284 @@
+#include "layoutsimulator.h"
+
+#include "../input/simulatedspeedsensor.h"
+#include "../commandstation/simulatedcommandstation.h"
+
+#include "../utils/monotonicclock.h"
+
+#include <QTimerEvent>
+
+// Real time pacing resolution
+static constexpr int SimulatorTickMillis = 10;
+
+// Simulated time per tick when not paced
+static constexpr qint64 FastStepMicros = 1000000;
+
+// Like ESP frames, a zero reading is published when wheel is still
+static constexpr qint64 ReadingPeriodMicros = 100000;
+static constexpr double StallMicros = 1000000;
+
+LayoutSimulator::LayoutSimulator(QObject *parent)
+    : QObject{parent}
+    , mRandom(1)
+{
+    mSpeedSensor = new SimulatedSpeedSensor(this);
+    mCommandStation = new SimulatedCommandStation(this);
+
+    addLocomotive(mSensorAddress);
+}
+
+LayoutSimulator::~LayoutSimulator()
+{
+    stop();
+    qDeleteAll(mLocomotives);
+}
+
+SimulatedSpeedSensor *LayoutSimulator::speedSensor() const
+{
+    return mSpeedSensor;
+}
+
+SimulatedCommandStation *LayoutSimulator::commandStation() const
+{
+    return mCommandStation;
+}
+
+VirtualLocomotive *LayoutSimulator::addLocomotive(int address, const VirtualLocomotiveConfig &config)
+{
+    VirtualLocomotive *loco = new VirtualLocomotive(config);
+
+    // Start from current simulation time
+    loco->advance(mElapsedMicros, mDiscardedEdges);
+    mDiscardedEdges.clear();
+
+    delete mLocomotives.value(address, nullptr);
+    mLocomotives.insert(address, loco);
+
+    if(address == mSensorAddress)
+        mLastEdgeMicros = -1;
+
+    return loco;
+}
+
+VirtualLocomotive *LayoutSimulator::locomotive(int address) const
+{
+    return mLocomotives.value(address, nullptr);
+}
+
+int LayoutSimulator::sensorAddress() const
+{
+    return mSensorAddress;
+}
+
+void LayoutSimulator::setSensorAddress(int newSensorAddress)
+{
+    mSensorAddress = newSensorAddress;
+
+    // Speed of first half rotation is unknown
+    mLastEdgeMicros = -1;
+}
+
+int LayoutSimulator::commandLatencyMicros() const
+{
+    return mCommandLatencyMicros;
+}
+
+void LayoutSimulator::setCommandLatencyMicros(int newCommandLatencyMicros)
+{
+    mCommandLatencyMicros = qMax(0, newCommandLatencyMicros);
+}
+
+int LayoutSimulator::edgeJitterMicros() const
+{
+    return mEdgeJitterMicros;
+}
+
+void LayoutSimulator::setEdgeJitterMicros(int newEdgeJitterMicros)
+{
+    mEdgeJitterMicros = qMax(0, newEdgeJitterMicros);
+}
+
+void LayoutSimulator::setSeed(quint32 seed)
+{
+    mRandom.seed(seed);
+}
+
+LayoutSimulator::Pacing LayoutSimulator::pacing() const
+{
+    return mPacing;
+}
+
+double LayoutSimulator::speedFactor() const
+{
+    return mSpeedFactor;
+}
+
+void LayoutSimulator::setPacing(Pacing newPacing, double newSpeedFactor)
+{
+    mPacing = newPacing;
+    mSpeedFactor = qMax(newSpeedFactor, 0.01);
+}
+
+void LayoutSimulator::runFor(qint64 micros)
+{
+    if(micros <= 0)
+        return;
+
+    advanceTo(mElapsedMicros + micros);
+
+    // Paced clock continues from here
+    mPacingStartMicros += micros;
+}
+
+void LayoutSimulator::queueCommand(int address, int speedStep, LocomotiveDirection direction)
+{
+    if(!mLocomotives.contains(address))
+        addLocomotive(address);
+
+    // Even with zero latency a command issued from a feedback slot is due
+    // later than the one being dispatched, so simulation time always advances
+    Command cmd;
+    cmd.dueMicros = mElapsedMicros + qMax(mCommandLatencyMicros, 1);
+    cmd.address = address;
+    cmd.speedStep = speedStep;
+    cmd.direction = direction;
+
+    // Keep order if latency was lowered
+    if(!mCommands.isEmpty())
+        cmd.dueMicros = qMax(cmd.dueMicros, mCommands.last().dueMicros);
+
+    mCommands.append(cmd);
+}
+
+void LayoutSimulator::timerEvent(QTimerEvent *e)
+{
+    if(e->timerId() == mTimerId && mTimerId)
+    {
+        if(mPacing == Pacing::AsFastAsPossible)
+        {
+            advanceTo(mElapsedMicros + FastStepMicros);
+        }
+        else
+        {
+            double factor = mPacing == Pacing::Scaled ? mSpeedFactor : 1.0;
+            const qint64 wallMicros = mWallClock.nsecsElapsed() / 1000;
+            advanceTo(mPacingStartMicros + qint64(wallMicros * factor));
+        }
+        return;
+    }
+
+    QObject::timerEvent(e);
+}
+
+void LayoutSimulator::start()
+{
+    stop();
+
+    mRunning = true;
+    mPacingStartMicros = mElapsedMicros;
+    mHostStartMicros = monotonicMicros() - mElapsedMicros;
+
+    if(mPacing == Pacing::AsFastAsPossible)
+        mTimerId = startTimer(0);
+    else
+        mTimerId = startTimer(SimulatorTickMillis, Qt::PreciseTimer);
+
+    mWallClock.start();
+}
+
+void LayoutSimulator::stop()
+{
+    if(mTimerId)
+    {
+        killTimer(mTimerId);
+        mTimerId = 0;
+    }
+
+    mRunning = false;
+}
+
+void LayoutSimulator::advanceTo(qint64 micros)
+{
+    while(mElapsedMicros < micros)
+    {
+        // Stop at each event so it happens at its exact time
+        qint64 next = qMin(micros, mNextReadingMicros);
+        if(!mCommands.isEmpty())
+            next = qMin(next, qMax(mElapsedMicros, mCommands.first().dueMicros));
+
+        advanceLocomotives(next);
+        publishEdges();
+
+        if(mElapsedMicros >= mNextReadingMicros)
+        {
+            publishStandstill();
+            mNextReadingMicros += ReadingPeriodMicros;
+        }
+
+        dispatchDueCommands();
+    }
+}
+
+void LayoutSimulator::advanceLocomotives(qint64 micros)
+{
+    for(auto it = mLocomotives.begin(); it != mLocomotives.end(); ++it)
+    {
+        QVector<double>& edges = it.key() == mSensorAddress ? mEdges : mDiscardedEdges;
+        it.value()->advance(micros, edges);
+    }
+
+    // Only edges of locomotive on sensor are used
+    mDiscardedEdges.clear();
+    mElapsedMicros = micros;
+}
+
+void LayoutSimulator::dispatchDueCommands()
+{
+    // Feedback slots may queue new commands, those wait for next dispatch
+    const int queued = mCommands.size();
+
+    int count = 0;
+    while(count < queued && mCommands.at(count).dueMicros <= mElapsedMicros)
+    {
+        // Copy, queue can grow while feedback is emitted
+        const Command cmd = mCommands.at(count);
+        mLocomotives.value(cmd.address)->setRequestedStep(cmd.speedStep, cmd.direction);
+        mCommandStation->simulateFeedback(cmd.address, cmd.speedStep, cmd.direction, hostMicros());
+        count++;
+    }
+
+    if(count)
+        mCommands.remove(0, count);
+}
+
+void LayoutSimulator::publishEdges()
+{
+    const VirtualLocomotive *loco = mLocomotives.value(mSensorAddress, nullptr);
+
+    for(double edge : std::as_const(mEdges))
+    {
+        if(mEdgeJitterMicros > 0)
+            edge += mRandom.bounded(-mEdgeJitterMicros, mEdgeJitterMicros + 1);
+
+        // Same computation as ESPAnalogHallSensor host edge detection
+        if(mLastEdgeMicros >= 0 && edge > mLastEdgeMicros)
+        {
+            // Speed of last half rotation, mm/us to m/s
+            mTravelledMillimeters += loco->millimetersPerHalfRotation();
+            const double speed = loco->millimetersPerHalfRotation() / (edge - mLastEdgeMicros) * 1000.0;
+            const qint64 edgeMicros = qRound64(edge);
+            mSpeedSensor->simulateReading(speed, mTravelledMillimeters, edgeMicros, mHostStartMicros + edgeMicros);
+        }
+
+        mLastEdgeMicros = edge;
+    }
+
+    mEdges.clear();
+}
+
+void LayoutSimulator::publishStandstill()
+{
+    // No edges means we are stopped, keep readings flowing
+    if(mLastEdgeMicros < 0 || mElapsedMicros - mLastEdgeMicros > StallMicros)
+        mSpeedSensor->simulateReading(0, mTravelledMillimeters, mElapsedMicros, hostMicros());
+}
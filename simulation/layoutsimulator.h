@@ -0,0 +1,132 @@
+#ifndef LAYOUTSIMULATOR_H
+#define LAYOUTSIMULATOR_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QVector>
+#include <QRandomGenerator>
+
+#include "virtuallocomotive.h"
+
+class SimulatedSpeedSensor;
+class SimulatedCommandStation;
+
+// Virtual layout with a speed sensor and a command station, so recording
+// and train control can run without hardware.
+// Locomotives, sensor and command station share one simulation clock.
+// Commands reach the track and are confirmed after commandLatency.
+// Sensor publishes a reading on each half rotation of the wheel under
+// sensorAddress locomotive, like ESPAnalogHallSensor with host edges.
+//
+// Feedback and sensor readings are stamped with simulation clock, which
+// matches host clock only with RealTime pacing. Faster pacing is meant for
+// headless runs which read the simulator clock, see runFor().
+class LayoutSimulator : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Pacing
+    {
+        RealTime = 0,
+        Scaled,           // Real time multiplied by speed factor
+        AsFastAsPossible  // Big steps, event loop still runs between them
+    };
+
+    explicit LayoutSimulator(QObject *parent = nullptr);
+    ~LayoutSimulator();
+
+    SimulatedSpeedSensor *speedSensor() const;
+    SimulatedCommandStation *commandStation() const;
+
+    // Replaces existing locomotive with same address
+    VirtualLocomotive *addLocomotive(int address, const VirtualLocomotiveConfig& config = VirtualLocomotiveConfig());
+    VirtualLocomotive *locomotive(int address) const;
+
+    int sensorAddress() const;
+    void setSensorAddress(int newSensorAddress);
+
+    int commandLatencyMicros() const;
+    void setCommandLatencyMicros(int newCommandLatencyMicros);
+
+    // Random error of each sensor edge
+    int edgeJitterMicros() const;
+    void setEdgeJitterMicros(int newEdgeJitterMicros);
+
+    void setSeed(quint32 seed);
+
+    Pacing pacing() const;
+    double speedFactor() const;
+
+    // Takes effect on next start
+    void setPacing(Pacing newPacing, double newSpeedFactor = 1.0);
+
+    // Simulation clock since first start
+    inline qint64 elapsedMicros() const { return mElapsedMicros; }
+
+    inline bool isRunning() const { return mRunning; }
+
+    // Advance simulation now by given time, ignoring pacing.
+    // Queued commands are delivered on the way
+    void runFor(qint64 micros);
+
+    // Called by SimulatedCommandStation, unknown addresses get a default locomotive
+    void queueCommand(int address, int speedStep, LocomotiveDirection direction);
+
+    void timerEvent(QTimerEvent *e) override;
+
+public slots:
+    void start();
+    void stop();
+
+private:
+    struct Command
+    {
+        qint64 dueMicros;
+        int address;
+        int speedStep;
+        LocomotiveDirection direction;
+    };
+
+    void advanceTo(qint64 micros);
+    void advanceLocomotives(qint64 micros);
+    void dispatchDueCommands();
+    void publishEdges();
+    void publishStandstill();
+
+    // Simulation clock expressed in host monotonicMicros()
+    inline qint64 hostMicros() const { return mHostStartMicros + mElapsedMicros; }
+
+private:
+    SimulatedSpeedSensor *mSpeedSensor;
+    SimulatedCommandStation *mCommandStation;
+
+    QHash<int, VirtualLocomotive *> mLocomotives;
+
+    // In sending order, due time never decreases
+    QVector<Command> mCommands;
+    int mCommandLatencyMicros = 2000;
+
+    int mSensorAddress = 3;
+    int mEdgeJitterMicros = 50;
+    QRandomGenerator mRandom;
+
+    // Sensor state
+    QVector<double> mEdges;
+    QVector<double> mDiscardedEdges;
+    double mLastEdgeMicros = -1;
+    double mTravelledMillimeters = 0;
+    qint64 mNextReadingMicros = 0;
+
+    Pacing mPacing = Pacing::RealTime;
+    double mSpeedFactor = 1.0;
+
+    int mTimerId = 0;
+    QElapsedTimer mWallClock;
+    qint64 mPacingStartMicros = 0;
+    qint64 mHostStartMicros = 0;
+    qint64 mElapsedMicros = 0;
+    bool mRunning = false;
+};
+
+#endif // LAYOUTSIMULATOR_H
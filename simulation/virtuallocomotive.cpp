@@ -0,0 +1,146 @@
+#include "virtuallocomotive.h"
+
+#include <QtMath>
+
+// NMRA S-9.2.2: seconds per step is CV * 0.896 / number of steps
+static constexpr double CVSecondsFactor = 0.896;
+
+VirtualLocomotive::VirtualLocomotive(const VirtualLocomotiveConfig &config)
+    : mConfig(config)
+{
+    mMillimetersPerHalfRotation = M_PI * mConfig.wheelDiameterMillimeters / 2.0;
+    mNextEdgeMillimeters = mMillimetersPerHalfRotation;
+
+    generateSpeedCurve();
+}
+
+void VirtualLocomotive::setSpeedCurve(const QVector<double> &forward, const QVector<double> &reverse)
+{
+    if(forward.size() != MaxStep + 1)
+        return;
+
+    mForwardCurve = forward;
+
+    if(reverse.size() == MaxStep + 1)
+    {
+        mReverseCurve = reverse;
+    }
+    else
+    {
+        mReverseCurve.resize(MaxStep + 1);
+        for(int step = 0; step <= MaxStep; step++)
+            mReverseCurve[step] = mForwardCurve.at(step) * mConfig.reverseFactor;
+    }
+}
+
+double VirtualLocomotive::curveSpeed(int step, LocomotiveDirection direction) const
+{
+    step = qBound(0, step, MaxStep);
+    if(direction == LocomotiveDirection::Reverse)
+        return mReverseCurve.at(step);
+    return mForwardCurve.at(step);
+}
+
+void VirtualLocomotive::setRequestedStep(int step, LocomotiveDirection direction)
+{
+    if(step == EMERGENCY_STOP)
+    {
+        emergencyStop();
+        mRequestedDirection = direction;
+        return;
+    }
+
+    mRequestedStep = qBound(0, step, MaxStep);
+    mRequestedDirection = direction;
+}
+
+void VirtualLocomotive::emergencyStop()
+{
+    // Motor power is cut, flywheel still coasts
+    mRequestedStep = 0;
+    mDecoderStep = 0;
+}
+
+void VirtualLocomotive::advance(qint64 toMicros, QVector<double> &edgeMicros)
+{
+    while(mTimeMicros < toMicros)
+        integrate(qMin(StepMicros, toMicros - mTimeMicros), edgeMicros);
+}
+
+int VirtualLocomotive::decoderStep() const
+{
+    // Decoder applies whole steps only
+    return int(mDecoderStep);
+}
+
+void VirtualLocomotive::generateSpeedCurve()
+{
+    QVector<double> curve(MaxStep + 1, 0);
+
+    const int startStep = qBound(1, mConfig.startStep, MaxStep);
+    const double range = MaxStep - startStep + 1;
+
+    for(int step = 1; step <= MaxStep; step++)
+    {
+        if(step >= startStep)
+            curve[step] = mConfig.maxMetersPerSecond * qPow((step - startStep + 1) / range, mConfig.curveExponent);
+    }
+
+    setSpeedCurve(curve);
+}
+
+void VirtualLocomotive::integrate(qint64 dtMicros, QVector<double> &edgeMicros)
+{
+    const double dtSeconds = dtMicros / 1000000.0;
+
+    // Decoder ramp, on direction change slow down to zero first
+    const double target = mRequestedDirection == LocomotiveDirection::Reverse ? -mRequestedStep : mRequestedStep;
+    if(mDecoderStep != target)
+    {
+        const bool reversing = target * mDecoderStep < 0;
+        const bool slowingDown = reversing || qAbs(target) < qAbs(mDecoderStep);
+        const double goal = reversing ? 0 : target;
+
+        const int cv = slowingDown ? mConfig.decelerationCV : mConfig.accelerationCV;
+        if(cv <= 0)
+        {
+            mDecoderStep = goal;
+        }
+        else
+        {
+            const double maxDelta = dtSeconds * MaxStep / (cv * CVSecondsFactor);
+            if(qAbs(goal - mDecoderStep) <= maxDelta)
+                mDecoderStep = goal;
+            else
+                mDecoderStep += goal > mDecoderStep ? maxDelta : -maxDelta;
+        }
+    }
+
+    // Motor follows decoder step with inertia
+    const int step = decoderStep();
+    const double motorSpeed = step < 0 ? -mReverseCurve.at(-step) : mForwardCurve.at(step);
+
+    double alpha = 1.0;
+    if(mConfig.inertiaMillis > 0)
+        alpha = 1.0 - qExp(-dtSeconds * 1000.0 / mConfig.inertiaMillis);
+    mSpeed += (motorSpeed - mSpeed) * alpha;
+
+    // Lag never reaches zero by itself, below 0.1 mm/s it is stopped
+    if(motorSpeed == 0 && qAbs(mSpeed) < 0.0001)
+        mSpeed = 0;
+
+    // m/s to mm per dtMicros
+    const double startMillimeters = mWheelMillimeters;
+    const double deltaMillimeters = qAbs(mSpeed) * dtMicros / 1000.0;
+    mWheelMillimeters += deltaMillimeters;
+
+    while(deltaMillimeters > 0 && mNextEdgeMillimeters <= mWheelMillimeters)
+    {
+        // Speed is constant inside integration step
+        const double fraction = (mNextEdgeMillimeters - startMillimeters) / deltaMillimeters;
+        edgeMicros.append(mTimeMicros + fraction * dtMicros);
+        mNextEdgeMillimeters += mMillimetersPerHalfRotation;
+    }
+
+    mTimeMicros += dtMicros;
+}
@@ -0,0 +1,94 @@
+#ifndef VIRTUALLOCOMOTIVE_H
+#define VIRTUALLOCOMOTIVE_H
+
+#include <QVector>
+
+#include "../commandstation/utils.h"
+
+struct VirtualLocomotiveConfig
+{
+    // Generated speed curve, used if no explicit curve is set
+    double maxMetersPerSecond = 0.4;
+    int startStep = 4;       // First step which moves the motor
+    double curveExponent = 0.85;
+    double reverseFactor = 0.95;
+
+    // Decoder acceleration and deceleration, NMRA CV3 and CV4
+    int accelerationCV = 8;
+    int decelerationCV = 6;
+
+    // Time constant of motor and flywheel
+    int inertiaMillis = 150;
+
+    // Two magnet poles per wheel rotation
+    double wheelDiameterMillimeters = 10.5;
+};
+
+// Model of a DCC locomotive on a rolling road.
+// Decoder moves its internal step towards the requested one at the rate
+// given by CV3/CV4, motor speed follows the speed curve of that step with
+// a first order lag for mechanical inertia.
+// Hall sensor wheel produces an edge every half rotation.
+// Time is given by caller so any clock can drive it.
+class VirtualLocomotive
+{
+public:
+    static constexpr int MaxStep = 126;
+
+    // Integration step, edges are interpolated inside it
+    static constexpr qint64 StepMicros = 1000;
+
+    explicit VirtualLocomotive(const VirtualLocomotiveConfig& config = VirtualLocomotiveConfig());
+
+    inline const VirtualLocomotiveConfig& config() const { return mConfig; }
+
+    // MaxStep + 1 values in m/s, empty reverse curve uses reverseFactor
+    void setSpeedCurve(const QVector<double>& forward, const QVector<double>& reverse = {});
+    double curveSpeed(int step, LocomotiveDirection direction) const;
+
+    void setRequestedStep(int step, LocomotiveDirection direction);
+    void emergencyStop();
+
+    inline int requestedStep() const { return mRequestedStep; }
+    inline LocomotiveDirection requestedDirection() const { return mRequestedDirection; }
+
+    // Integrate until toMicros, edge times are appended to edgeMicros
+    void advance(qint64 toMicros, QVector<double>& edgeMicros);
+
+    inline qint64 timeMicros() const { return mTimeMicros; }
+
+    // Step currently applied by decoder, negative is reverse
+    int decoderStep() const;
+
+    // Signed, negative is reverse
+    inline double metersPerSecond() const { return mSpeed; }
+
+    // Sum of both directions as seen by sensor wheel
+    inline double wheelMillimeters() const { return mWheelMillimeters; }
+
+    inline double millimetersPerHalfRotation() const { return mMillimetersPerHalfRotation; }
+
+private:
+    void generateSpeedCurve();
+    void integrate(qint64 dtMicros, QVector<double>& edgeMicros);
+
+private:
+    VirtualLocomotiveConfig mConfig;
+    QVector<double> mForwardCurve;
+    QVector<double> mReverseCurve;
+    double mMillimetersPerHalfRotation = 0;
+
+    int mRequestedStep = 0;
+    LocomotiveDirection mRequestedDirection = LocomotiveDirection::Forward;
+
+    qint64 mTimeMicros = 0;
+
+    // Decoder internal step, fractional while ramping
+    double mDecoderStep = 0;
+    double mSpeed = 0;
+
+    double mWheelMillimeters = 0;
+    double mNextEdgeMillimeters = 0;
+};
+
+#endif // VIRTUALLOCOMOTIVE_H
@@ -15,6 +15,32 @@ double LocoSpeedMapping::getSpeedForStep(int step) const
     return mSpeed.at(step - 1); // We do not store zero so index is step - 1
 }
 
+double LocoSpeedMapping::getSpeedForStep(int step, LocomotiveDirection direction) const
+{
+    if(direction == LocomotiveDirection::Reverse && mHasReverse)
+    {
+        if(step <= 0 || step > 126)
+            return 0;
+        return mReverseSpeed.at(step - 1);
+    }
+
+    return getSpeedForStep(step);
+}
+
+void LocoSpeedMapping::setReverseSpeedTable(const std::array<double, 126> &arr)
+{
+    mReverseSpeed = arr;
+    mHasReverse = true;
+}
+
+LocoSpeedMapping LocoSpeedMapping::forDirection(LocomotiveDirection direction) const
+{
+    if(direction == LocomotiveDirection::Forward || !mHasReverse)
+        return *this;
+
+    return LocoSpeedMapping(mName, mAddress, mReverseSpeed);
+}
+
 int LocoSpeedMapping::stepUpperBound(double speed) const
 {
     auto it = std::upper_bound(mSpeed.begin(), mSpeed.end(), speed);
@@ -4,6 +4,8 @@
 #include <QString>
 #include <array>
 
+#include "../commandstation/utils.h"
+
 class LocoSpeedMapping
 {
 public:
@@ -11,6 +13,16 @@ public:
 
     double getSpeedForStep(int step) const;
 
+    // Uses reverse table if available
+    double getSpeedForStep(int step, LocomotiveDirection direction) const;
+
+    // Some locomotives run at different speed in reverse
+    void setReverseSpeedTable(const std::array<double, 126>& arr);
+    inline bool hasReverseTable() const { return mHasReverse; }
+
+    // Mapping with table of given direction as main table
+    LocoSpeedMapping forDirection(LocomotiveDirection direction) const;
+
     int stepUpperBound(double speed) const;
     int stepLowerBound(double speed) const;
 
@@ -23,6 +35,8 @@ private:
     int mAddress = 0;
 
     std::array<double, 126> mSpeed;
+    std::array<double, 126> mReverseSpeed;
+    bool mHasReverse = false;
 };
 
 #endif // LOCOSPEEDMAPPING_H
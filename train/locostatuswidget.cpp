@@ -68,7 +68,7 @@ void LocoStatusWidget::updateStatus()
         direction = mLocomotive->direction();
         targetSpeedStep = mLocomotive->targetSpeedStep();
         targetDirection = mLocomotive->targetDirection();
-        metersPerSecond = speedMapping.getSpeedForStep(speedStep);
+        metersPerSecond = speedMapping.getSpeedForStep(speedStep, direction);
     }
 
     const double realKmH = metersPerSecond * 87.0 * 3.6;
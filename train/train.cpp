@@ -129,9 +129,13 @@ void Train::updateSpeedTable()
 
     std::vector<LocoSpeedMapping> mappings;
     mappings.reserve(mLocomotives.size());
+    auto invertedDir = oppositeDir(mDirection);
     for(int i = 0; i < mLocomotives.size(); i++)
     {
-        mappings.push_back(mLocomotives.at(i).loco->speedMapping());
+        // Each locomotive may run with its own reverse table
+        const LocoItem& item = mLocomotives.at(i);
+        LocomotiveDirection locoDir = item.invertDir ? invertedDir : mDirection;
+        mappings.push_back(item.loco->speedMapping().forDirection(locoDir));
     }
 
     mSpeedTable = TrainSpeedTable::buildTable(mappings);
@@ -144,11 +148,23 @@ void Train::updateSpeedTable()
 
 void Train::setDirection(LocomotiveDirection dir)
 {
+    const bool changed = mDirection != dir;
     mDirection = dir;
 
     if(!active)
         return;
 
+    if(changed && mLocomotives.size() >= 2
+            && mLastSetSpeed.tableIdx == TrainSpeedTable::NULL_TABLE_ENTRY
+            && mTargetSpeed.tableIdx == TrainSpeedTable::NULL_TABLE_ENTRY)
+    {
+        // Switch to speed tables of new direction while stopped
+        // Table indexes change so keep maximum speed instead
+        const double maxSpeed = mMaxSpeed.speed;
+        updateSpeedTable();
+        setMaximumSpeed(maxSpeed);
+    }
+
     auto invertedDir = oppositeDir(mDirection);
 
     // Apply direction to all locomotives
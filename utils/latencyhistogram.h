@@ -0,0 +1,75 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <QtGlobal>
+
+#include <array>
+
+// Histogram of latencies in microseconds with power of two buckets.
+// Bucket i counts values in [2^i, 2^(i+1)) us, last bucket collects
+// everything above ~1 s. Adding a value does not allocate.
+class LatencyHistogram
+{
+public:
+    static constexpr int BucketCount = 21;
+
+    void add(qint64 micros)
+    {
+        if(micros < 0)
+            micros = 0;
+
+        int bucket = 0;
+        while(bucket < BucketCount - 1 && (qint64(2) << bucket) <= micros)
+            bucket++;
+
+        mBuckets[bucket]++;
+        mCount++;
+        mSum += micros;
+        if(mCount == 1 || micros < mMin)
+            mMin = micros;
+        if(micros > mMax)
+            mMax = micros;
+    }
+
+    void reset()
+    {
+        mBuckets.fill(0);
+        mCount = 0;
+        mSum = 0;
+        mMin = 0;
+        mMax = 0;
+    }
+
+    inline quint64 count() const { return mCount; }
+    inline qint64 min() const { return mMin; }
+    inline qint64 max() const { return mMax; }
+    inline qint64 mean() const { return mCount ? qint64(mSum / mCount) : 0; }
+
+    inline quint64 bucketCount(int bucket) const { return mBuckets.at(bucket); }
+
+    // Upper bound of bucket containing given fraction of values, i.e. 0.99
+    qint64 percentile(double fraction) const
+    {
+        if(!mCount)
+            return 0;
+
+        const quint64 target = qMax<quint64>(1, quint64(fraction * double(mCount) + 0.5));
+        quint64 seen = 0;
+        for(int bucket = 0; bucket < BucketCount; bucket++)
+        {
+            seen += mBuckets[bucket];
+            if(seen >= target && bucket < BucketCount - 1)
+                return qMin(mMax, (qint64(2) << bucket) - 1);
+        }
+        return mMax;
+    }
+
+private:
+    std::array<quint64, BucketCount> mBuckets{};
+    quint64 mCount = 0;
+    quint64 mSum = 0;
+    qint64 mMin = 0;
+    qint64 mMax = 0;
+};
+
+#endif // LATENCYHISTOGRAM_H
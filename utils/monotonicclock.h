@@ -0,0 +1,17 @@
+#ifndef MONOTONICCLOCK_H
+#define MONOTONICCLOCK_H
+
+#include <QtGlobal>
+
+#include <chrono>
+
+// Host time shared by all threads.
+// Events are stamped where they are received so queueing
+// between threads does not change their time.
+inline qint64 monotonicMicros()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+#endif // MONOTONICCLOCK_H
@@ -0,0 +1,139 @@
+#ifndef SPSCRINGBUFFER_H
+#define SPSCRINGBUFFER_H
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <memory>
+
+// Lock free ring buffer for exactly one producer thread and one consumer thread.
+// Capacity is rounded up to a power of two.
+// Each side caches the other side index so it touches
+// the shared cache line only when it looks full/empty.
+template <typename T>
+class SpscRingBuffer
+{
+public:
+    explicit SpscRingBuffer(int minCapacity)
+    {
+        quint64 capacity = 2;
+        while(capacity < quint64(minCapacity))
+            capacity <<= 1;
+
+        mCapacity = capacity;
+        mMask = capacity - 1;
+        mData.reset(new T[capacity]);
+    }
+
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+    inline int capacity() const { return int(mCapacity); }
+
+    // Approximate when called from a third thread
+    inline int size() const
+    {
+        return int(mHead.load(std::memory_order_acquire) - mTail.load(std::memory_order_acquire));
+    }
+
+    // Producer side
+    bool tryPush(const T& item)
+    {
+        const quint64 head = mHead.load(std::memory_order_relaxed);
+        if(head - mCachedTail >= mCapacity)
+        {
+            mCachedTail = mTail.load(std::memory_order_acquire);
+            if(head - mCachedTail >= mCapacity)
+                return false; // Full
+        }
+
+        mData[head & mMask] = item;
+        mHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool tryPop(T& out)
+    {
+        return popMany(&out, 1) == 1;
+    }
+
+    // Consumer side, returns number of items copied to out
+    int popMany(T *out, int maxCount)
+    {
+        const quint64 tail = mTail.load(std::memory_order_relaxed);
+        if(mCachedHead - tail < quint64(maxCount))
+            mCachedHead = mHead.load(std::memory_order_acquire);
+
+        const int count = int(qMin(mCachedHead - tail, quint64(maxCount)));
+        for(int i = 0; i < count; i++)
+            out[i] = mData[(tail + i) & mMask];
+
+        if(count)
+            mTail.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+private:
+    // Keep producer and consumer indexes on different cache lines
+    static constexpr int CacheLineSize = 64;
+
+    alignas(CacheLineSize) std::atomic<quint64> mHead{0};
+    quint64 mCachedTail = 0; // Producer copy of mTail
+
+    alignas(CacheLineSize) std::atomic<quint64> mTail{0};
+    quint64 mCachedHead = 0; // Consumer copy of mHead
+
+    alignas(CacheLineSize) std::unique_ptr<T[]> mData;
+    quint64 mCapacity = 0;
+    quint64 mMask = 0;
+};
+
+// Ring which tells producer when consumer must be woken up.
+// Consumer is notified once after it drained the ring, not for every item.
+// Items which do not fit are dropped and counted.
+template <typename T>
+class SpscNotifyingRing
+{
+public:
+    explicit SpscNotifyingRing(int minCapacity)
+        : mRing(minCapacity)
+    {
+    }
+
+    // Producer side, returns true if consumer must be notified
+    bool push(const T& item)
+    {
+        if(!mRing.tryPush(item))
+        {
+            mOverruns.fetch_add(1, std::memory_order_relaxed);
+            return false; // Consumer already has a pending notification
+        }
+
+        // Pairs with fence in take()
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return !mNotifyPending.exchange(true, std::memory_order_relaxed);
+    }
+
+    // Consumer side, keep calling until it returns less than maxCount
+    int take(T *out, int maxCount)
+    {
+        // Clear before popping so an item pushed after we looked at the ring
+        // is always followed by a new notification
+        mNotifyPending.store(false, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        return mRing.popMany(out, maxCount);
+    }
+
+    inline quint64 overruns() const { return mOverruns.load(std::memory_order_relaxed); }
+
+    inline int capacity() const { return mRing.capacity(); }
+
+private:
+    SpscRingBuffer<T> mRing;
+    std::atomic<quint64> mOverruns{0};
+    std::atomic<bool> mNotifyPending{false};
+};
+
+#endif // SPSCRINGBUFFER_H
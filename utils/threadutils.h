@@ -0,0 +1,21 @@
+#ifndef THREADUTILS_H
+#define THREADUTILS_H
+
+#include <QObject>
+#include <QThread>
+
+#include <utility>
+
+// For objects living in a worker thread which can be called from other threads.
+// If current thread is not obj thread, queue func in obj thread and return true.
+template <typename Func>
+inline bool queueIfOtherThread(QObject *obj, Func &&func)
+{
+    if(QThread::currentThread() == obj->thread())
+        return false;
+
+    QMetaObject::invokeMethod(obj, std::forward<Func>(func), Qt::QueuedConnection);
+    return true;
+}
+
+#endif // THREADUTILS_H
@@ -1,7 +1,7 @@
 #include "dataseriesfiltermodel.h"
 
 #include "../recorder/idataseries.h"
-#include "../recorder/recordingmanager.h"
+#include "../recorder/seriessnapshothub.h"
 
 #include "../chart/chart.h"
 
@@ -49,7 +49,7 @@ void setupAxisTicksOnZoom(QValueAxis *axis)
 
 DataSeriesFilterModel::DataSeriesFilterModel(Chart *chart, QObject *parent)
     : QAbstractTableModel(parent)
-    , mRecMgr(nullptr)
+    , mSeriesHub(nullptr)
     , mChart(chart)
 {
     mTimeAxis = new QValueAxis(this);
@@ -235,36 +235,36 @@ void DataSeriesFilterModel::setColorAt(const QModelIndex &idx, const QColor& col
     emit dataChanged(idx, idx);
 }
 
-RecordingManager *DataSeriesFilterModel::recMgr() const
+SeriesSnapshotHub *DataSeriesFilterModel::seriesHub() const
 {
-    return mRecMgr;
+    return mSeriesHub;
 }
 
-void DataSeriesFilterModel::setRecMgr(RecordingManager *newRecMgr)
+void DataSeriesFilterModel::setSeriesHub(SeriesSnapshotHub *newSeriesHub)
 {
     beginResetModel();
 
-    if(mRecMgr)
+    if(mSeriesHub)
     {
-        disconnect(mRecMgr, &RecordingManager::seriesRegistered,
+        disconnect(mSeriesHub, &SeriesSnapshotHub::seriesRegistered,
                    this, &DataSeriesFilterModel::onSeriesRegistered);
-        disconnect(mRecMgr, &RecordingManager::seriesUnregistered,
+        disconnect(mSeriesHub, &SeriesSnapshotHub::seriesUnregistered,
                    this, &DataSeriesFilterModel::onSeriesUnregistered);
     }
 
     qDeleteAll(mItems);
     mItems.clear();
 
-    mRecMgr = newRecMgr;
+    mSeriesHub = newSeriesHub;
 
-    if(mRecMgr)
+    if(mSeriesHub)
     {
-        connect(mRecMgr, &RecordingManager::seriesRegistered,
+        connect(mSeriesHub, &SeriesSnapshotHub::seriesRegistered,
                 this, &DataSeriesFilterModel::onSeriesRegistered);
-        connect(mRecMgr, &RecordingManager::seriesUnregistered,
+        connect(mSeriesHub, &SeriesSnapshotHub::seriesUnregistered,
                 this, &DataSeriesFilterModel::onSeriesUnregistered);
 
-        for(auto series : mRecMgr->getSeries())
+        for(auto series : mSeriesHub->getSeries())
         {
             onSeriesRegistered(series);
         }
@@ -309,9 +309,11 @@ void DataSeriesFilterModel::onSeriesRegistered(IDataSeries *s)
     case DataSeriesType::RequestedSpeedStep:
         item->setColor(Qt::black);
         item->attachAxis(mStepAxis);
-        connect(item->dataSeries(), &IDataSeries::pointAdded, this,
-                [this](int, const QPointF& pt)
+        connect(item->dataSeries(), &IDataSeries::pointsAppended, this,
+                [this, s](int first, int count)
         {
+            // Points are sorted by time, last one is enough
+            const QPointF pt = s->getPointAt(first + count - 1);
             if(mAxisRangeFollowsChanges && pt.x() + 5 > mTimeAxis->max())
                 mTimeAxis->setMax(pt.x() + 10);
         });
@@ -323,11 +325,28 @@ void DataSeriesFilterModel::onSeriesRegistered(IDataSeries *s)
     case DataSeriesType::SensorRawData:
         item->setColor(Qt::green);
         item->attachAxis(mSpeedAxis);
-        connect(item->dataSeries(), &IDataSeries::pointAdded, this,
-                [this](int, const QPointF& pt)
+        connect(item->dataSeries(), &IDataSeries::pointsAppended, this,
+                [this, s](int first, int count)
         {
-            if(mAxisRangeFollowsChanges && pt.y() + 0.3 > mSpeedAxis->max())
-                mSpeedAxis->setMax(pt.y() + 0.5);
+            if(!mAxisRangeFollowsChanges)
+                return;
+
+            double maxSpeed = 0;
+            const int end = first + count;
+            while(first < end)
+            {
+                const DataSeriesSpan span = s->getSpan(first, end - first);
+                if(!span.count)
+                    break;
+
+                for(int i = 0; i < span.count; i++)
+                    maxSpeed = qMax(maxSpeed, span.y[i]);
+
+                first += span.count;
+            }
+
+            if(maxSpeed + 0.3 > mSpeedAxis->max())
+                mSpeedAxis->setMax(maxSpeed + 0.5);
         });
         break;
     case DataSeriesType::MovingAverage:
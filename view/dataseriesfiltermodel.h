@@ -5,7 +5,7 @@
 #include <QVector>
 
 class IDataSeries;
-class RecordingManager;
+class SeriesSnapshotHub;
 
 class Chart;
 class QValueAxis;
@@ -42,8 +42,8 @@ public:
     QColor getColorAt(const QModelIndex& idx) const;
     void setColorAt(const QModelIndex &idx, const QColor &color);
 
-    RecordingManager *recMgr() const;
-    void setRecMgr(RecordingManager *newRecMgr);
+    SeriesSnapshotHub *seriesHub() const;
+    void setSeriesHub(SeriesSnapshotHub *newSeriesHub);
 
     void setAxisRange(const QRectF &r);
     QRectF getAxisRange() const;
@@ -56,7 +56,7 @@ private slots:
     void onSeriesUnregistered(IDataSeries *s);
 
 private:
-    RecordingManager *mRecMgr;
+    SeriesSnapshotHub *mSeriesHub;
     Chart *mChart;
 
     QValueAxis *mSpeedAxis;
@@ -2,20 +2,19 @@
 
 #include "../recorder/idataseries.h"
 
-DataSeriesGraph::DataSeriesGraph(IDataSeries *s, QObject *parent)
+DataSeriesGraph::DataSeriesGraph(IDataSeries *s, QObject *parent, Direction direction)
     : QLineSeries(parent)
     , mDataSeries(s)
+    , mDirection(direction)
 {
-    connect(mDataSeries, &IDataSeries::pointAdded, this, &DataSeriesGraph::pointAdded);
-    connect(mDataSeries, &IDataSeries::pointRemoved, this, &DataSeriesGraph::pointRemoved);
-    connect(mDataSeries, &IDataSeries::pointChanged, this, &DataSeriesGraph::pointChanged);
+    connect(mDataSeries, &IDataSeries::pointsAppended, this, &DataSeriesGraph::onPointsAppended);
+    connect(mDataSeries, &IDataSeries::pointsChanged, this, &DataSeriesGraph::onPointsChanged);
+    connect(mDataSeries, &IDataSeries::pointsRemoved, this, &DataSeriesGraph::onPointsRemoved);
+    connect(mDataSeries, &IDataSeries::reset, this, &DataSeriesGraph::onReset);
 
     setName(mDataSeries->name());
 
-    for(int i = 0; i < s->getPointCount(); i++)
-    {
-        insert(i, s->getPointAt(i));
-    }
+    onReset();
 }
 
 IDataSeries *DataSeriesGraph::dataSeries() const
@@ -23,17 +22,196 @@ IDataSeries *DataSeriesGraph::dataSeries() const
     return mDataSeries;
 }
 
-void DataSeriesGraph::pointAdded(int index, const QPointF &point)
+void DataSeriesGraph::onPointsAppended(int first, int count)
+{
+    if(mDirection != Direction::All)
+    {
+        // Only appends at end keep filtered points in order
+        if(first != mGraphIndex.size())
+        {
+            onReset();
+            return;
+        }
+
+        append(readFiltered(first, count, QLineSeries::count()));
+        return;
+    }
+
+    const QList<QPointF> points = readPoints(first, count);
+
+    if(first == QLineSeries::count())
+    {
+        append(points);
+        return;
+    }
+
+    for(int i = 0; i < points.size(); i++)
+        insert(first + i, points.at(i));
+}
+
+void DataSeriesGraph::onPointsChanged(int first, int count)
+{
+    if(mDirection != Direction::All)
+    {
+        if(first < 0 || first + count > mGraphIndex.size())
+        {
+            onReset();
+            return;
+        }
+
+        const int end = first + count;
+        while(first < end)
+        {
+            const DataSeriesSpan span = mDataSeries->getSpan(first, end - first);
+            if(!span.count)
+                break;
+
+            for(int i = 0; i < span.count; i++)
+            {
+                QPointF pt;
+                const bool accepted = mapPoint(span.x[i], span.y[i], pt);
+                const int graphIndex = mGraphIndex.at(first + i);
+                if(accepted != (graphIndex >= 0))
+                {
+                    // Point moved to other direction, following indices shift
+                    onReset();
+                    return;
+                }
+
+                if(accepted)
+                    replace(graphIndex, pt);
+            }
+
+            first += span.count;
+        }
+        return;
+    }
+
+    // Only changed range, copying all points costs more than a repaint each
+    const QList<QPointF> points = readPoints(first, count);
+    for(int i = 0; i < points.size() && first + i < QLineSeries::count(); i++)
+        replace(first + i, points.at(i));
+}
+
+void DataSeriesGraph::onPointsRemoved(int first, int count)
+{
+    if(mDirection != Direction::All)
+    {
+        // Removing from end does not shift other points
+        if(first + count != mGraphIndex.size())
+        {
+            onReset();
+            return;
+        }
+
+        int graphFirst = QLineSeries::count();
+        for(int i = first; i < first + count; i++)
+        {
+            if(mGraphIndex.at(i) >= 0)
+            {
+                graphFirst = mGraphIndex.at(i);
+                break;
+            }
+        }
+
+        if(graphFirst < QLineSeries::count())
+            removePoints(graphFirst, QLineSeries::count() - graphFirst);
+        mGraphIndex.resize(first);
+        return;
+    }
+
+    removePoints(first, count);
+}
+
+void DataSeriesGraph::onReset()
 {
-    insert(index, point);
+    if(mDirection != Direction::All)
+    {
+        mGraphIndex.clear();
+        replace(readFiltered(0, mDataSeries->getPointCount(), 0));
+        return;
+    }
+
+    // Fill graph in one go from series memory
+    replace(readPoints(0, mDataSeries->getPointCount()));
+}
+
+bool DataSeriesGraph::mapPoint(double x, double y, QPointF &out) const
+{
+    switch (mDirection)
+    {
+    case Direction::All:
+        break;
+    case Direction::Forward:
+        if(x < 0)
+            return false;
+        break;
+    case Direction::Reverse:
+        if(x >= 0)
+            return false;
+        x = -x;
+        break;
+    }
+
+    out = QPointF(x, y);
+    return true;
 }
 
-void DataSeriesGraph::pointRemoved(int index)
+QList<QPointF> DataSeriesGraph::readFiltered(int first, int count, int graphFirst)
 {
-    removePoints(index, 1);
+    QList<QPointF> points;
+    points.reserve(count);
+    mGraphIndex.reserve(first + count);
+
+    int graphIndex = graphFirst;
+    const int end = first + count;
+    while(first < end)
+    {
+        const DataSeriesSpan span = mDataSeries->getSpan(first, end - first);
+        if(!span.count)
+            break;
+
+        for(int i = 0; i < span.count; i++)
+        {
+            QPointF pt;
+            if(mapPoint(span.x[i], span.y[i], pt))
+            {
+                points.append(pt);
+                mGraphIndex.append(graphIndex++);
+            }
+            else
+            {
+                mGraphIndex.append(-1);
+            }
+        }
+
+        first += span.count;
+    }
+
+    return points;
 }
 
-void DataSeriesGraph::pointChanged(int index, const QPointF &newPoint)
+QList<QPointF> DataSeriesGraph::readPoints(int first, int count) const
 {
-    replace(index, newPoint);
+    QList<QPointF> points;
+    points.reserve(count);
+
+    const int end = first + count;
+    while(first < end)
+    {
+        const DataSeriesSpan span = mDataSeries->getSpan(first, end - first);
+        if(!span.count)
+            break;
+
+        for(int i = 0; i < span.count; i++)
+        {
+            QPointF pt;
+            if(mapPoint(span.x[i], span.y[i], pt))
+                points.append(pt);
+        }
+
+        first += span.count;
+    }
+
+    return points;
 }
@@ -9,17 +9,43 @@ class DataSeriesGraph : public QLineSeries
 {
     Q_OBJECT
 public:
-    DataSeriesGraph(IDataSeries *s, QObject *parent = nullptr);
+    // For curve mappings, reverse steps have negative X.
+    // Forward keeps X >= 0, Reverse keeps X < 0 and mirrors it.
+    // Filtered graphs are not index aligned with series.
+    enum class Direction
+    {
+        All = 0,
+        Forward,
+        Reverse
+    };
+
+    DataSeriesGraph(IDataSeries *s, QObject *parent = nullptr, Direction direction = Direction::All);
 
     IDataSeries *dataSeries() const;
 
+    inline Direction direction() const { return mDirection; }
+
 private slots:
-    void pointAdded(int index, const QPointF& point);
-    void pointRemoved(int index);
-    void pointChanged(int index, const QPointF& newPoint);
+    void onPointsAppended(int first, int count);
+    void onPointsChanged(int first, int count);
+    void onPointsRemoved(int first, int count);
+    void onReset();
+
+private:
+    QList<QPointF> readPoints(int first, int count) const;
+
+    // Returns false if point belongs to other direction
+    bool mapPoint(double x, double y, QPointF& out) const;
+
+    // Filtered graphs, appends to mGraphIndex starting from graphFirst
+    QList<QPointF> readFiltered(int first, int count, int graphFirst);
 
 private:
     IDataSeries *mDataSeries;
+    Direction mDirection;
+
+    // For filtered graphs, graph index of each series point or -1
+    QVector<int> mGraphIndex;
 };
 
 
@@ -1,7 +1,7 @@
 #include "locomotiverecordingview.h"
 #include "dataseriesfiltermodel.h"
 
-#include "../recorder/recordingmanager.h"
+#include "../recorder/seriessnapshothub.h"
 
 #include "../chart/chartview.h"
 #include "../chart/chart.h"
@@ -70,13 +70,13 @@ LocomotiveRecordingView::LocomotiveRecordingView(QWidget *parent)
             });
 }
 
-RecordingManager *LocomotiveRecordingView::recMgr() const
+SeriesSnapshotHub *LocomotiveRecordingView::seriesHub() const
 {
-    return mRecMgr;
+    return mSeriesHub;
 }
 
-void LocomotiveRecordingView::setRecMgr(RecordingManager *newRecMgr)
+void LocomotiveRecordingView::setSeriesHub(SeriesSnapshotHub *newSeriesHub)
 {
-    mRecMgr = newRecMgr;
-    mFilterModel->setRecMgr(mRecMgr);
+    mSeriesHub = newSeriesHub;
+    mFilterModel->setSeriesHub(mSeriesHub);
 }
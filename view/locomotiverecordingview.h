@@ -7,7 +7,7 @@ class Chart;
 class ChartView;
 
 class DataSeriesFilterModel;
-class RecordingManager;
+class SeriesSnapshotHub;
 
 class QTableView;
 
@@ -19,11 +19,11 @@ class LocomotiveRecordingView : public QWidget
 public:
     explicit LocomotiveRecordingView(QWidget *parent = nullptr);
 
-    RecordingManager *recMgr() const;
-    void setRecMgr(RecordingManager *newRecMgr);
+    SeriesSnapshotHub *seriesHub() const;
+    void setSeriesHub(SeriesSnapshotHub *newSeriesHub);
 
 private:
-    RecordingManager *mRecMgr = nullptr;
+    SeriesSnapshotHub *mSeriesHub = nullptr;
 
     Chart *mChart;
     ChartView *mChartView;
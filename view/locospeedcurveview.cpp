@@ -1,6 +1,6 @@
 #include "locospeedcurveview.h"
 
-#include "../recorder/recordingmanager.h"
+#include "../recorder/seriessnapshothub.h"
 
 #include "../chart/chartview.h"
 #include "../chart/chart.h"
@@ -22,7 +22,7 @@
 
 LocoSpeedCurveView::LocoSpeedCurveView(QWidget *parent)
     : QWidget{parent}
-    , mRecMgr(nullptr)
+    , mSeriesHub(nullptr)
 {
     mChart = new Chart;
     mChart->setLocalizeNumbers(false);
@@ -94,15 +94,15 @@ void LocoSpeedCurveView::setTargedSpeedCurve(const QVector<double> &targetSpeedC
     //    }
 }
 
-RecordingManager *LocoSpeedCurveView::recMgr() const
+SeriesSnapshotHub *LocoSpeedCurveView::seriesHub() const
 {
-    return mRecMgr;
+    return mSeriesHub;
 }
 
-void LocoSpeedCurveView::setRecMgr(RecordingManager *newRecMgr)
+void LocoSpeedCurveView::setSeriesHub(SeriesSnapshotHub *newSeriesHub)
 {
-    mRecMgr = newRecMgr;
-    mFilterModel->setRecMgr(mRecMgr);
+    mSeriesHub = newSeriesHub;
+    mFilterModel->setSeriesHub(mSeriesHub);
 }
 
 void LocoSpeedCurveView::onTableContextMenu(const QPoint &pos)
@@ -246,6 +246,46 @@ void LocoSpeedCurveView::onTableContextMenu(const QPoint &pos)
                     return;
                 RawSpeedCurveIO::saveCurveToFile(fileName, s);
             });
+
+            menu->addAction(tr("Save with Reverse Curve..."),
+                            this, [this, idx]()
+            {
+                QLineSeries *s = mFilterModel->getCurveAt(idx.column());
+                if(!s)
+                    return;
+
+                // Pick another stored curve as reverse table
+                QStringList names;
+                QVector<int> columns;
+                for(int col = 0; col < mFilterModel->columnCount(); col++)
+                {
+                    if(col == idx.column() || !mFilterModel->getCurveAt(col))
+                        continue;
+                    names.append(mFilterModel->getSeriesName(col));
+                    columns.append(col);
+                }
+
+                if(names.isEmpty())
+                    return;
+
+                bool ok = false;
+                const QString reverseName = QInputDialog::getItem(this, tr("Reverse Curve"),
+                                                                  tr("Curve:"), names, 0, false, &ok);
+                const int nameIdx = names.indexOf(reverseName);
+                if(!ok || nameIdx < 0)
+                    return;
+
+                QString fileName;
+                fileName = QFileDialog::getSaveFileName(this,
+                                                        tr("Save Curve File"));
+                if(fileName.isEmpty())
+                    return;
+
+                QLineSeries *reverse = mFilterModel->getCurveAt(columns.at(nameIdx));
+                if(!reverse)
+                    return;
+                RawSpeedCurveIO::saveCurveToFile(fileName, s, reverse);
+            });
         }
     }
 
@@ -13,7 +13,7 @@ class SpeedCurveTableModel;
 
 class QSplitter;
 
-class RecordingManager;
+class SeriesSnapshotHub;
 
 class LocoSpeedCurveView : public QWidget
 {
@@ -23,8 +23,8 @@ public:
 
     void setTargedSpeedCurve(const QVector<double>& targetSpeedCurve);
 
-    RecordingManager *recMgr() const;
-    void setRecMgr(RecordingManager *newRecMgr);
+    SeriesSnapshotHub *seriesHub() const;
+    void setSeriesHub(SeriesSnapshotHub *newSeriesHub);
 
 private slots:
     void onTableContextMenu(const QPoint& pos);
@@ -34,7 +34,7 @@ private:
     ChartView *mChartView;
 
     QLineSeries mTargetSpeedCurve;
-    RecordingManager *mRecMgr = nullptr;
+    SeriesSnapshotHub *mSeriesHub = nullptr;
 
     QTableView *mFilterView;
     SpeedCurveTableModel *mFilterModel;
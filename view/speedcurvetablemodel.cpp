@@ -1,7 +1,7 @@
 #include "speedcurvetablemodel.h"
 
-#include "../recorder/recordingmanager.h"
-#include "../recorder/series/dataseriescurvemapping.h"
+#include "../recorder/seriessnapshothub.h"
+#include "../recorder/idataseries.h"
 
 #include "dataseriesgraph.h"
 
@@ -12,7 +12,7 @@
 
 SpeedCurveTableModel::SpeedCurveTableModel(Chart *chart, QObject *parent)
     : QAbstractTableModel(parent)
-    , mRecMgr(nullptr)
+    , mSeriesHub(nullptr)
     , mChart(chart)
 {
     mStepAxis = new QValueAxis(this);
@@ -155,18 +155,8 @@ QVariant SpeedCurveTableModel::data(const QModelIndex &idx, int role) const
     if(step < 0)
         return QVariant();
 
-    int indexInSeries = idx.row() - mStepStart[step];
-
-    int baseStepIndex = getFirstIndexForStep(series, step);
-    if(baseStepIndex < 0)
-        return QVariant();
-
-    int lastStepIndex = getFirstIndexForStep(series, step + 1);
-
-    indexInSeries += baseStepIndex;
-    if(indexInSeries >= series->count() ||
-            (indexInSeries >= lastStepIndex
-             && lastStepIndex != -1))
+    const int indexInSeries = getPointIndex(idx.column(), step, idx.row() - mStepStart[step]);
+    if(indexInSeries < 0 || indexInSeries >= series->count())
         return QVariant();
 
     if(role == Qt::DisplayRole)
@@ -232,20 +222,20 @@ Qt::ItemFlags SpeedCurveTableModel::flags(const QModelIndex &idx) const
     return Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsUserCheckable;
 }
 
-RecordingManager *SpeedCurveTableModel::recMgr() const
+SeriesSnapshotHub *SpeedCurveTableModel::seriesHub() const
 {
-    return mRecMgr;
+    return mSeriesHub;
 }
 
-void SpeedCurveTableModel::setRecMgr(RecordingManager *newRecMgr)
+void SpeedCurveTableModel::setSeriesHub(SeriesSnapshotHub *newSeriesHub)
 {
     beginSetState(State::WaitingForRecalculation);
 
-    if(mRecMgr)
+    if(mSeriesHub)
     {
-        disconnect(mRecMgr, &RecordingManager::seriesRegistered,
+        disconnect(mSeriesHub, &SeriesSnapshotHub::seriesRegistered,
                    this, &SpeedCurveTableModel::onSeriesRegistered);
-        disconnect(mRecMgr, &RecordingManager::seriesUnregistered,
+        disconnect(mSeriesHub, &SeriesSnapshotHub::seriesUnregistered,
                    this, &SpeedCurveTableModel::onSeriesUnregistered);
     }
 
@@ -260,16 +250,20 @@ void SpeedCurveTableModel::setRecMgr(RecordingManager *newRecMgr)
         }
     }
 
-    mRecMgr = newRecMgr;
+    for(const DataSeriesColumn& col : std::as_const(mPendingReverse))
+        delete col.mGraph;
+    mPendingReverse.clear();
+
+    mSeriesHub = newSeriesHub;
 
-    if(mRecMgr)
+    if(mSeriesHub)
     {
-        connect(mRecMgr, &RecordingManager::seriesRegistered,
+        connect(mSeriesHub, &SeriesSnapshotHub::seriesRegistered,
                 this, &SpeedCurveTableModel::onSeriesRegistered);
-        connect(mRecMgr, &RecordingManager::seriesUnregistered,
+        connect(mSeriesHub, &SeriesSnapshotHub::seriesUnregistered,
                 this, &SpeedCurveTableModel::onSeriesUnregistered);
 
-        for(auto series : mRecMgr->getSeries())
+        for(auto series : mSeriesHub->getSeries())
         {
             onSeriesRegistered(series);
         }
@@ -339,55 +333,102 @@ void SpeedCurveTableModel::onSeriesRegistered(IDataSeries *s)
 
     beginSetState(State::WaitingForRecalculation);
 
+    // Reverse steps are negative, split them in a separate column
     DataSeriesColumn col;
-    col.mSeries = static_cast<DataSeriesCurveMapping *>(s);
-    col.mGraph = new DataSeriesGraph(s, this);
+    col.mSeries = s;
+    col.mGraph = new DataSeriesGraph(s, this, DataSeriesGraph::Direction::Forward);
 
     mChart->addSeries(col.mGraph);
     col.mGraph->attachAxis(mStepAxis);
     col.mGraph->attachAxis(mSpeedAxis);
 
-    connect(col.mSeries, &IDataSeries::pointAdded, this, &SpeedCurveTableModel::onSeriesChanged);
-    connect(col.mSeries, &IDataSeries::pointRemoved, this, &SpeedCurveTableModel::onSeriesPointRemoved);
-    connect(col.mSeries, &IDataSeries::pointChanged, this, &SpeedCurveTableModel::onSeriesChanged);
+    DataSeriesColumn reverseCol;
+    reverseCol.mSeries = s;
+    reverseCol.mGraph = new DataSeriesGraph(s, this, DataSeriesGraph::Direction::Reverse);
+    reverseCol.mGraph->setName(tr("%1 (Reverse)").arg(s->name()));
+    mPendingReverse.append(reverseCol);
+
+    connect(col.mSeries, &IDataSeries::pointsAppended, this,
+            [this, s](int first, int count)
+    {
+        onSeriesPointsChanged(s, first, count);
+    });
+    connect(col.mSeries, &IDataSeries::pointsChanged, this,
+            [this, s](int first, int count)
+    {
+        onSeriesPointsChanged(s, first, count);
+    });
+    connect(col.mSeries, &IDataSeries::pointsRemoved, this, &SpeedCurveTableModel::onSeriesReset);
+    connect(col.mSeries, &IDataSeries::reset, this, &SpeedCurveTableModel::onSeriesReset);
 
     mSeries.append(col);
 
     endSetState();
 }
 
-void SpeedCurveTableModel::onSeriesUnregistered(IDataSeries *s)
+void SpeedCurveTableModel::removeSeriesColumns(IDataSeries *s)
 {
-    if(s->getType() != DataSeriesType::CurveMapping)
-        return;
-
-    beginSetState(State::WaitingForRecalculation);
-
+    // Both directions of this series
     for(int i = mSeries.size() - 1; i >= 0; i--)
     {
         const DataSeriesColumn& col = mSeries.at(i);
         if(col.mSeries == s)
         {
-            // Remove it
             delete col.mGraph;
             mSeries.removeAt(i);
-            break;
         }
     }
 
+    for(int i = mPendingReverse.size() - 1; i >= 0; i--)
+    {
+        const DataSeriesColumn& col = mPendingReverse.at(i);
+        if(col.mSeries == s)
+        {
+            delete col.mGraph;
+            mPendingReverse.removeAt(i);
+        }
+    }
+}
+
+void SpeedCurveTableModel::onSeriesUnregistered(IDataSeries *s)
+{
+    if(s->getType() != DataSeriesType::CurveMapping)
+        return;
+
+    beginSetState(State::WaitingForRecalculation);
+
+    removeSeriesColumns(s);
+
     endSetState();
 }
 
-void SpeedCurveTableModel::onSeriesChanged(int, const QPointF &pt)
+void SpeedCurveTableModel::onSeriesPointsChanged(IDataSeries *s, int first, int count)
 {
-    if(mAxisRangeFollowsChanges && pt.y() + 0.3 > mSpeedAxis->max())
-        mSpeedAxis->setMax(pt.y() + 0.5);
+    if(mAxisRangeFollowsChanges)
+    {
+        double maxSpeed = 0;
+        const int end = first + count;
+        while(first < end)
+        {
+            const DataSeriesSpan span = s->getSpan(first, end - first);
+            if(!span.count)
+                break;
+
+            for(int i = 0; i < span.count; i++)
+                maxSpeed = qMax(maxSpeed, span.y[i]);
+
+            first += span.count;
+        }
+
+        if(maxSpeed + 0.3 > mSpeedAxis->max())
+            mSpeedAxis->setMax(maxSpeed + 0.5);
+    }
 
     beginSetState(State::WaitingForRecalculation);
     endSetState();
 }
 
-void SpeedCurveTableModel::onSeriesPointRemoved()
+void SpeedCurveTableModel::onSeriesReset()
 {
     beginSetState(State::WaitingForRecalculation);
     endSetState();
@@ -452,6 +493,30 @@ void SpeedCurveTableModel::endSetState()
 
 void SpeedCurveTableModel::recalculate()
 {
+    // Show reverse columns once test recorded reverse steps
+    for(int i = 0; i < mPendingReverse.size(); )
+    {
+        const DataSeriesColumn col = mPendingReverse.at(i);
+        if(col.mGraph->count() == 0)
+        {
+            i++;
+            continue;
+        }
+
+        mChart->addSeries(col.mGraph);
+        col.mGraph->attachAxis(mStepAxis);
+        col.mGraph->attachAxis(mSpeedAxis);
+        mSeries.append(col);
+        mPendingReverse.removeAt(i);
+    }
+
+    // Cache step lookup for all columns
+    mStepIndex.clear();
+    for(const DataSeriesColumn& col : mSeries)
+        mStepIndex.append(buildStepIndex(col.mGraph));
+    for(QLineSeries *curve : mCurves)
+        mStepIndex.append(buildStepIndex(curve));
+
     int stepCount[126 + 1] = {0};
     for(int i = 0; i <= 126; i++)
     {
@@ -459,28 +524,12 @@ void SpeedCurveTableModel::recalculate()
         stepCount[i] = 1;
     }
 
-    // Get highest number of rows per each step
-    for(const DataSeriesColumn& col : mSeries)
+    // Get highest number of rows per each step, test series only
+    for(int col = 0; col < mSeries.size(); col++)
     {
-        int step = 0;
-        int rows = 0;
-
-        for(const QPointF& pt : col.mGraph->points())
-        {
-            if(pt.x() > step)
-            {
-                if(stepCount[step] < rows)
-                    stepCount[step] = rows;
-
-                step = pt.x();
-                rows = 0;
-
-                if(step > 126)
-                    break;
-            }
-
-            rows++;
-        }
+        const StepIndex& stepIndex = mStepIndex.at(col);
+        for(int i = 0; i <= 126; i++)
+            stepCount[i] = qMax(stepCount[i], stepIndex.countForStep(i));
     }
 
     // One row for checkboxes
@@ -496,18 +545,46 @@ void SpeedCurveTableModel::recalculate()
     mLastRow--;
 }
 
-int SpeedCurveTableModel::getFirstIndexForStep(QLineSeries *s, int step) const
+int SpeedCurveTableModel::getPointIndex(int column, int step, int row) const
 {
-    int i = 0;
-    for(; i < s->count(); i++)
+    if(column < 0 || column >= mStepIndex.size())
+        return -1;
+
+    const StepIndex& stepIndex = mStepIndex.at(column);
+    if(step < 0 || step > 126 || row < 0 || row >= stepIndex.countForStep(step))
+        return -1;
+
+    return stepIndex.points.at(stepIndex.offsets.at(step) + row);
+}
+
+SpeedCurveTableModel::StepIndex SpeedCurveTableModel::buildStepIndex(QLineSeries *s) const
+{
+    // Steps are not always increasing (i.e. back to zero when test ends,
+    // sparse sweep, step measured again) so bucket points by step
+    StepIndex stepIndex;
+    stepIndex.offsets.fill(0, 126 + 2);
+
+    const QList<QPointF> points = s->points();
+    for(const QPointF& pt : points)
     {
-        if(s->at(i).x() == step)
-        {
-            return i;
-        }
+        if(pt.x() >= 0 && pt.x() < 126 + 1)
+            stepIndex.offsets[int(pt.x()) + 1]++;
+    }
+
+    for(int step = 0; step <= 126; step++)
+        stepIndex.offsets[step + 1] += stepIndex.offsets.at(step);
+
+    // Fill each bucket in series order
+    QVector<int> next = stepIndex.offsets;
+    stepIndex.points.resize(stepIndex.offsets.last());
+    for(int i = 0; i < points.size(); i++)
+    {
+        const double x = points.at(i).x();
+        if(x >= 0 && x < 126 + 1)
+            stepIndex.points[next[int(x)]++] = i;
     }
 
-    return -1;
+    return stepIndex;
 }
 
 QLineSeries *SpeedCurveTableModel::getSeriesAtColumn(int col) const
@@ -560,6 +637,8 @@ QLineSeries *SpeedCurveTableModel::addNewCurve(const QString &name)
     int col = mSeries.size() + mCurves.size();
     beginInsertColumns(QModelIndex(), col, col);
     mCurves.append(curve);
+    if(mStepIndex.size() == col)
+        mStepIndex.append(buildStepIndex(curve));
     endInsertColumns();
 
     return curve;
@@ -575,6 +654,8 @@ void SpeedCurveTableModel::removeCurveAt(int column)
     beginRemoveColumns(QModelIndex(), column, column);
 
     delete mCurves.takeAt(column - mSeries.size());
+    if(column < mStepIndex.size())
+        mStepIndex.removeAt(column);
 
     endRemoveColumns();
 }
@@ -592,6 +673,9 @@ void SpeedCurveTableModel::updateCurveAt(int column)
     if(getColumnType(column) != ColumnType::StoredSpeedCurve)
         return;
 
+    if(column < mStepIndex.size())
+        mStepIndex[column] = buildStepIndex(getSeriesAtColumn(column));
+
     emit dataChanged(index(0, column),
                      index(mLastRow, column));
 }
@@ -615,18 +699,8 @@ QPointF SpeedCurveTableModel::getValueAtIdx(const QModelIndex &idx) const
     if(step < 0)
         return invalid;
 
-    int indexInSeries = idx.row() - mStepStart[step];
-
-    int baseStepIndex = getFirstIndexForStep(series, step);
-    if(baseStepIndex < 0)
-        return invalid;
-
-    int lastStepIndex = getFirstIndexForStep(series, step + 1);
-
-    indexInSeries += baseStepIndex;
-    if(indexInSeries >= series->count()
-            || (indexInSeries >= lastStepIndex
-                && lastStepIndex != -1))
+    const int indexInSeries = getPointIndex(idx.column(), step, idx.row() - mStepStart[step]);
+    if(indexInSeries < 0 || indexInSeries >= series->count())
         return invalid;
 
     QPointF pt = series->at(indexInSeries);
@@ -674,7 +748,7 @@ void SpeedCurveTableModel::storeFirstOfEachStepInCurrentCurve(int sourceCol)
 
     for(int step = 1; step <= 126; step++)
     {
-        int idx = getFirstIndexForStep(sourceSeries, step);
+        int idx = getPointIndex(sourceCol, step, 0);
         if(idx != -1)
         {
             currentEditSeries->replace(step, sourceSeries->at(idx));
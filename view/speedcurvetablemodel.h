@@ -5,14 +5,13 @@
 #include <QVector>
 
 class DataSeriesGraph;
-class DataSeriesCurveMapping;
 class IDataSeries;
 
 class Chart;
 class QValueAxis;
 class QLineSeries;
 
-class RecordingManager;
+class SeriesSnapshotHub;
 
 class SpeedCurveTableModel : public QAbstractTableModel
 {
@@ -37,8 +36,8 @@ public:
 
     Qt::ItemFlags flags(const QModelIndex& idx) const override;
 
-    RecordingManager *recMgr() const;
-    void setRecMgr(RecordingManager *newRecMgr);
+    SeriesSnapshotHub *seriesHub() const;
+    void setSeriesHub(SeriesSnapshotHub *newSeriesHub);
 
     enum SpecialRows
     {
@@ -81,8 +80,7 @@ public:
 private slots:
     void onSeriesRegistered(IDataSeries *s);
     void onSeriesUnregistered(IDataSeries *s);
-    void onSeriesChanged(int, const QPointF &pt);
-    void onSeriesPointRemoved();
+    void onSeriesReset();
 
 protected:
     void timerEvent(QTimerEvent *e) override;
@@ -98,6 +96,7 @@ private:
     void beginSetState(State newState);
     void endSetState();
     void recalculate();
+    void onSeriesPointsChanged(IDataSeries *s, int first, int count);
 
     inline int getStepForRow(int row) const
     {
@@ -116,12 +115,26 @@ private:
         return step;
     }
 
-    int getFirstIndexForStep(QLineSeries *s, int step) const;
+    // Point indices bucketed by step, in series order inside each step
+    struct StepIndex
+    {
+        // Points of step are points[offsets[step]] up to points[offsets[step + 1]]
+        QVector<int> offsets;
+        QVector<int> points;
+
+        inline int countForStep(int step) const { return offsets.at(step + 1) - offsets.at(step); }
+    };
+
+    // Index in series of row-th point of step, or -1
+    int getPointIndex(int column, int step, int row) const;
+    StepIndex buildStepIndex(QLineSeries *s) const;
 
     QLineSeries *getSeriesAtColumn(int col) const;
 
+    void removeSeriesColumns(IDataSeries *s);
+
 private:
-    RecordingManager *mRecMgr;
+    SeriesSnapshotHub *mSeriesHub;
     Chart *mChart;
 
     QValueAxis *mStepAxis;
@@ -131,10 +144,13 @@ private:
     struct DataSeriesColumn
     {
         DataSeriesGraph *mGraph;
-        DataSeriesCurveMapping *mSeries;
+        IDataSeries *mSeries;
     };
     QVector<DataSeriesColumn> mSeries;
 
+    // Reverse graphs of test series, shown only when they get points
+    QVector<DataSeriesColumn> mPendingReverse;
+
     // Stored curves, these are persistent
     QVector<QLineSeries *> mCurves;
 
@@ -144,6 +160,9 @@ private:
     int mStepStart[126 + 1] = {0};
     int mLastRow = 0;
 
+    // For each column, its points bucketed by step
+    QVector<StepIndex> mStepIndex;
+
     int mCurrentEditCurve = -1;
 
     bool mAxisRangeFollowsChanges = true;
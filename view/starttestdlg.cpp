@@ -2,7 +2,13 @@
 
 #include <QFormLayout>
 #include <QSpinBox>
+#include <QDoubleSpinBox>
+#include <QCheckBox>
 #include <QDialogButtonBox>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QHBoxLayout>
+#include <QFileDialog>
 
 StartTestDlg::StartTestDlg(QWidget *parent)
     : QDialog{parent}
@@ -20,10 +26,100 @@ StartTestDlg::StartTestDlg(QWidget *parent)
     mDefaultTimerForStep->setSuffix(tr(" ms"));
     lay->addRow(tr("Step duration:"), mDefaultTimerForStep);
 
+    mAdaptiveStepTime = new QCheckBox(tr("Next step when speed is steady"));
+    lay->addRow(tr("Adaptive duration:"), mAdaptiveStepTime);
+
+    mMaxTimerForStep = new QSpinBox;
+    mMaxTimerForStep->setRange(1000, 60000);
+    mMaxTimerForStep->setSuffix(tr(" ms"));
+    lay->addRow(tr("Max step duration:"), mMaxTimerForStep);
+
+    mSteadyTolerance = new QDoubleSpinBox;
+    mSteadyTolerance->setRange(0.1, 20);
+    mSteadyTolerance->setDecimals(1);
+    mSteadyTolerance->setSuffix(tr(" %"));
+    lay->addRow(tr("Steady speed tolerance:"), mSteadyTolerance);
+
+    // Fixed duration is not used in adaptive mode
+    connect(mAdaptiveStepTime, &QCheckBox::toggled, this,
+            [this](bool val)
+    {
+        mDefaultTimerForStep->setEnabled(!val);
+        mMaxTimerForStep->setEnabled(val);
+        mSteadyTolerance->setEnabled(val);
+    });
+    mMaxTimerForStep->setEnabled(false);
+    mSteadyTolerance->setEnabled(false);
+
     mStartingDCCStep = new QSpinBox;
     mStartingDCCStep->setRange(1, 126);
     lay->addRow(tr("Start from DCC Step:"), mStartingDCCStep);
 
+    QHBoxLayout *captureLay = new QHBoxLayout;
+    mCaptureFile = new QLineEdit;
+    mCaptureFile->setPlaceholderText(tr("No capture"));
+    captureLay->addWidget(mCaptureFile);
+
+    QPushButton *browseBut = new QPushButton(tr("Browse"));
+    captureLay->addWidget(browseBut);
+    connect(browseBut, &QPushButton::clicked, this,
+            [this]()
+    {
+        QString f = QFileDialog::getSaveFileName(this, tr("Save Run Capture"),
+                                                 mCaptureFile->text(),
+                                                 tr("Run Capture (*.msrcap)"));
+        if(!f.isEmpty())
+            mCaptureFile->setText(f);
+    });
+    lay->addRow(tr("Capture file:"), captureLay);
+
+    mSparseSweep = new QCheckBox(tr("Measure subset of steps and refine"));
+    lay->addRow(tr("Sparse sweep:"), mSparseSweep);
+
+    mCoarseStride = new QSpinBox;
+    mCoarseStride->setRange(1, 64);
+    lay->addRow(tr("Coarse step interval:"), mCoarseStride);
+
+    QHBoxLayout *mappingLay = new QHBoxLayout;
+    mSpeedMappingFile = new QLineEdit;
+    mSpeedMappingFile->setPlaceholderText(tr("Do not save"));
+    mappingLay->addWidget(mSpeedMappingFile);
+
+    QPushButton *mappingBrowseBut = new QPushButton(tr("Browse"));
+    mappingLay->addWidget(mappingBrowseBut);
+    connect(mappingBrowseBut, &QPushButton::clicked, this,
+            [this]()
+    {
+        QString f = QFileDialog::getSaveFileName(this, tr("Save Speed Mapping"),
+                                                 mSpeedMappingFile->text(),
+                                                 tr("JSON (*.json)"));
+        if(!f.isEmpty())
+            mSpeedMappingFile->setText(f);
+    });
+    lay->addRow(tr("Speed mapping file:"), mappingLay);
+
+    connect(mSparseSweep, &QCheckBox::toggled, this,
+            [this, mappingBrowseBut](bool val)
+    {
+        mCoarseStride->setEnabled(val);
+        mSpeedMappingFile->setEnabled(val);
+        mappingBrowseBut->setEnabled(val);
+    });
+    mCoarseStride->setEnabled(false);
+    mSpeedMappingFile->setEnabled(false);
+    mappingBrowseBut->setEnabled(false);
+
+    mBidirectional = new QCheckBox(tr("Record reverse table too"));
+    lay->addRow(tr("Both directions:"), mBidirectional);
+
+    mDirectionBlockSize = new QSpinBox;
+    mDirectionBlockSize->setRange(1, 126);
+    mDirectionBlockSize->setSuffix(tr(" steps"));
+    lay->addRow(tr("Steps before reversing:"), mDirectionBlockSize);
+
+    connect(mBidirectional, &QCheckBox::toggled, mDirectionBlockSize, &QSpinBox::setEnabled);
+    mDirectionBlockSize->setEnabled(false);
+
     QDialogButtonBox *box =
             new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel,
                                  Qt::Horizontal,
@@ -62,3 +158,93 @@ void StartTestDlg::setDefaultStepTime(int newDefaultStepTime)
 {
     mDefaultTimerForStep->setValue(newDefaultStepTime);
 }
+
+QString StartTestDlg::getCaptureFile() const
+{
+    return mCaptureFile->text().trimmed();
+}
+
+void StartTestDlg::setCaptureFile(const QString &fileName)
+{
+    mCaptureFile->setText(fileName);
+}
+
+bool StartTestDlg::getAdaptiveStepTime() const
+{
+    return mAdaptiveStepTime->isChecked();
+}
+
+void StartTestDlg::setAdaptiveStepTime(bool val)
+{
+    mAdaptiveStepTime->setChecked(val);
+}
+
+int StartTestDlg::getMaxStepTime() const
+{
+    return mMaxTimerForStep->value();
+}
+
+void StartTestDlg::setMaxStepTime(int millis)
+{
+    mMaxTimerForStep->setValue(millis);
+}
+
+double StartTestDlg::getSteadyTolerance() const
+{
+    return mSteadyTolerance->value() / 100.0;
+}
+
+void StartTestDlg::setSteadyTolerance(double relativeTolerance)
+{
+    mSteadyTolerance->setValue(relativeTolerance * 100.0);
+}
+
+bool StartTestDlg::getSparseSweep() const
+{
+    return mSparseSweep->isChecked();
+}
+
+void StartTestDlg::setSparseSweep(bool val)
+{
+    mSparseSweep->setChecked(val);
+}
+
+int StartTestDlg::getCoarseStride() const
+{
+    return mCoarseStride->value();
+}
+
+void StartTestDlg::setCoarseStride(int stride)
+{
+    mCoarseStride->setValue(stride);
+}
+
+QString StartTestDlg::getSpeedMappingFile() const
+{
+    return mSpeedMappingFile->text();
+}
+
+void StartTestDlg::setSpeedMappingFile(const QString &fileName)
+{
+    mSpeedMappingFile->setText(fileName);
+}
+
+bool StartTestDlg::getBidirectional() const
+{
+    return mBidirectional->isChecked();
+}
+
+void StartTestDlg::setBidirectional(bool val)
+{
+    mBidirectional->setChecked(val);
+}
+
+int StartTestDlg::getDirectionBlockSize() const
+{
+    return mDirectionBlockSize->value();
+}
+
+void StartTestDlg::setDirectionBlockSize(int steps)
+{
+    mDirectionBlockSize->setValue(steps);
+}
@@ -4,6 +4,9 @@
 #include <QDialog>
 
 class QSpinBox;
+class QDoubleSpinBox;
+class QCheckBox;
+class QLineEdit;
 
 class StartTestDlg : public QDialog
 {
@@ -20,10 +23,46 @@ public:
     int getDefaultStepTime() const;
     void setDefaultStepTime(int newDefaultStepTime);
 
+    QString getCaptureFile() const;
+    void setCaptureFile(const QString& fileName);
+
+    bool getAdaptiveStepTime() const;
+    void setAdaptiveStepTime(bool val);
+
+    int getMaxStepTime() const;
+    void setMaxStepTime(int millis);
+
+    double getSteadyTolerance() const;
+    void setSteadyTolerance(double relativeTolerance);
+
+    bool getSparseSweep() const;
+    void setSparseSweep(bool val);
+
+    int getCoarseStride() const;
+    void setCoarseStride(int stride);
+
+    QString getSpeedMappingFile() const;
+    void setSpeedMappingFile(const QString& fileName);
+
+    bool getBidirectional() const;
+    void setBidirectional(bool val);
+
+    int getDirectionBlockSize() const;
+    void setDirectionBlockSize(int steps);
+
 private:
     QSpinBox *mLocoAddress;
     QSpinBox *mDefaultTimerForStep;
     QSpinBox *mStartingDCCStep;
+    QCheckBox *mAdaptiveStepTime;
+    QSpinBox *mMaxTimerForStep;
+    QDoubleSpinBox *mSteadyTolerance;
+    QLineEdit *mCaptureFile;
+    QCheckBox *mSparseSweep;
+    QSpinBox *mCoarseStride;
+    QLineEdit *mSpeedMappingFile;
+    QCheckBox *mBidirectional;
+    QSpinBox *mDirectionBlockSize;
 };
 
 #endif // STARTTESTDLG_H
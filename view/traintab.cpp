@@ -26,28 +26,10 @@
 
 #include <QMessageBox>
 
-bool loadSpeedCurve(const QString& fileName, Locomotive *loco)
+static bool readSpeedTable(const QJsonObject& obj, QLatin1String curveKey, QLatin1String mappingKey,
+                           std::array<double, 126>& speedTable)
 {
-    QFile f(fileName);
-    if(!f.open(QFile::ReadOnly))
-        return false;
-
-    QJsonDocument doc = QJsonDocument::fromJson(f.readAll());
-
-    QJsonObject obj = doc.object();
-
-    QString name = obj.value(QLatin1String("name")).toString();
-    if(name.isEmpty())
-    {
-        name = f.fileName();
-        int i = name.lastIndexOf('/');
-        if(i >= 0 && i < (name.size() - 1))
-            name = name.mid(i + 1);
-    }
-
-    std::array<double, 126> speedTable;
-
-    QJsonValue tmp = obj.value(QLatin1String("curve_array"));
+    QJsonValue tmp = obj.value(curveKey);
     if(tmp.isArray())
     {
         QJsonArray curve = tmp.toArray();
@@ -67,7 +49,7 @@ bool loadSpeedCurve(const QString& fileName, Locomotive *loco)
             step++;
         }
     }
-    else if(tmp = obj.value(QLatin1String("speed_mapping")); tmp.isArray())
+    else if(tmp = obj.value(mappingKey); tmp.isArray())
     {
         QJsonArray sparseTable = tmp.toArray();
 
@@ -106,8 +88,41 @@ bool loadSpeedCurve(const QString& fileName, Locomotive *loco)
     else
         return false;
 
+    return true;
+}
+
+bool loadSpeedCurve(const QString& fileName, Locomotive *loco)
+{
+    QFile f(fileName);
+    if(!f.open(QFile::ReadOnly))
+        return false;
+
+    QJsonDocument doc = QJsonDocument::fromJson(f.readAll());
+
+    QJsonObject obj = doc.object();
+
+    QString name = obj.value(QLatin1String("name")).toString();
+    if(name.isEmpty())
+    {
+        name = f.fileName();
+        int i = name.lastIndexOf('/');
+        if(i >= 0 && i < (name.size() - 1))
+            name = name.mid(i + 1);
+    }
+
+    std::array<double, 126> speedTable;
+    if(!readSpeedTable(obj, QLatin1String("curve_array"), QLatin1String("speed_mapping"), speedTable))
+        return false;
+
     int address = obj.value(QLatin1String("dcc_address")).toInt();
     LocoSpeedMapping mapping(name, address, speedTable);
+
+    // Optional, without it reverse uses same table
+    std::array<double, 126> reverseTable;
+    if(readSpeedTable(obj, QLatin1String("reverse_curve_array"),
+                      QLatin1String("reverse_speed_mapping"), reverseTable))
+        mapping.setReverseSpeedTable(reverseTable);
+
     loco->setSpeedMapping(mapping);
     loco->setAddress(address);
 